@@ -0,0 +1,72 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vcs {
+
+/**
+ * @brief Fixed-size bloom filter over strings
+ *
+ * Answers "definitely absent" without false negatives; a positive answer
+ * may be a false positive and has to be confirmed by the caller.
+ */
+class BloomFilter {
+private:
+    std::vector<std::uint64_t> bits;    ///< Bit array packed into 64-bit words
+    unsigned hash_count;                ///< Number of probes per key
+
+    /**
+     * @brief Computes the two base hashes used for double hashing
+     * @param key The key to hash
+     * @param h1 Reference to receive the first hash
+     * @param h2 Reference to receive the second (odd) hash
+     */
+    static void baseHashes(const std::string& key, std::uint64_t& h1, std::uint64_t& h2);
+
+public:
+    /**
+     * @brief Constructs a bloom filter sized for an expected number of keys
+     * @param expected_keys Number of keys the filter is sized for
+     * @param bits_per_key Bits reserved per key (10 gives about 1% false positives)
+     */
+    explicit BloomFilter(std::size_t expected_keys = 0, unsigned bits_per_key = 10);
+
+    /**
+     * @brief Adds a key to the filter
+     * @param key The key to add
+     */
+    void add(const std::string& key);
+
+    /**
+     * @brief Checks whether a key may be present
+     * @param key The key to check
+     * @return bool False if the key is definitely absent, true if it may be present
+     */
+    bool mightContain(const std::string& key) const;
+
+    /**
+     * @brief Gets the size of the bit array
+     * @return std::size_t Number of bits in the filter
+     */
+    std::size_t bitCount() const;
+
+    /**
+     * @brief Serializes the filter to a single-line text form
+     * @return std::string Probe count and bit array as "<k>:<hex words>"
+     */
+    std::string serialize() const;
+
+    /**
+     * @brief Restores a filter from the form produced by serialize()
+     * @param data Serialized filter
+     * @return bool True if the data was well-formed, false otherwise
+     */
+    bool deserialize(const std::string& data);
+};
+
+} // namespace vcs
+
+#endif
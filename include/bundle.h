@@ -0,0 +1,71 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Summary of a bundle operation
+ */
+struct BundleStats {
+    std::size_t objects = 0;        ///< Objects written to or ingested from the bundle
+    std::size_t skipped = 0;        ///< Bundled objects the receiver already had, or repeated in the bundle
+    std::uint64_t bytes = 0;        ///< Uncompressed size of those objects
+};
+
+/**
+ * @brief Writes and reads single-file, compressed object bundles
+ *
+ * A bundle lists its prerequisite commits (tips the receiver already has)
+ * and its tips, followed by every object reachable from the tips but not
+ * from the prerequisites. The whole file is one gzip stream, and
+ * unbundling writes the objects straight into a new pack instead of
+ * millions of loose files.
+ */
+class Bundle {
+private:
+    Storage& storage;   ///< Storage objects are read from and ingested into
+
+public:
+    /**
+     * @brief Constructs a Bundle working on the given storage
+     * @param storage Storage to read from and write to
+     */
+    explicit Bundle(Storage& storage);
+
+    /**
+     * @brief Writes a bundle with everything the receiver lacks
+     * @param file_path Path of the bundle file to create
+     * @param tips Commits the receiver should end up with
+     * @param haves Commits the receiver already has
+     * @param stats Reference to BundleStats to populate
+     * @return bool True if the bundle was written, false if objects were missing or on I/O errors
+     */
+    bool create(const std::string& file_path, const std::vector<std::string>& tips,
+                const std::vector<std::string>& haves, BundleStats& stats);
+
+    /**
+     * @brief Ingests a bundle into a new pack
+     *
+     * Fails, and removes the new pack again, unless every object reachable
+     * from the tips is present afterwards.
+     *
+     * @param file_path Path of the bundle file to read
+     * @param tips Vector receiving the tips recorded in the bundle
+     * @param missing Vector receiving prerequisites this repository lacks
+     * @param incomplete Vector receiving objects the tips need that neither the bundle nor this repository has
+     * @param stats Reference to BundleStats to populate
+     * @return bool True if all objects were ingested and the tips are complete, false otherwise
+     */
+    bool unbundle(const std::string& file_path, std::vector<std::string>& tips,
+                  std::vector<std::string>& missing, std::vector<std::string>& incomplete,
+                  BundleStats& stats);
+};
+
+} // namespace vcs
+
+#endif
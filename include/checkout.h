@@ -0,0 +1,77 @@
+#ifndef CHECKOUT_H
+#define CHECKOUT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "index.h"
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Summary of a finished checkout
+ */
+struct CheckoutStats {
+    std::size_t files_written = 0;          ///< Number of files written to the working tree
+    std::size_t directories_created = 0;    ///< Number of directories created up front
+    std::size_t failures = 0;               ///< Number of files that could not be restored
+    std::uint64_t bytes_written = 0;        ///< Total size of written file content
+};
+
+/**
+ * @brief Restores the files of a Tree into a directory using worker threads
+ *
+ * The tree is walked once to collect files and directories, all directories
+ * are created before any file is written, and blob reads and file writes are
+ * then spread across a worker pool. Index stat data for every restored file
+ * is written in a single batch at the end, as unstaged entries.
+ */
+class Checkout {
+private:
+    /**
+     * @brief A single file to restore
+     */
+    struct FileJob {
+        std::string path;   ///< Path relative to the checkout root
+        std::string hash;   ///< Hash of the blob holding the content
+        std::string mode;   ///< File permissions mode from the tree entry
+    };
+
+    Storage& storage;       ///< Storage the objects are read from
+    Index& index;           ///< Index updated with the restored files
+    unsigned threads;       ///< Worker thread count (0 selects hardware concurrency)
+
+    /**
+     * @brief Recursively collects files and directories of a tree
+     * @param tree_hash Hash of the tree to walk
+     * @param prefix Path of the tree relative to the checkout root
+     * @param jobs Vector receiving the files to restore
+     * @param directories Vector receiving the directories to create
+     * @return bool True if every tree could be read and every name is safe, false otherwise
+     */
+    bool collect(const std::string& tree_hash, const std::string& prefix,
+                 std::vector<FileJob>& jobs, std::vector<std::string>& directories);
+
+public:
+    /**
+     * @brief Constructs a Checkout working on the given storage and index
+     * @param storage Storage to read objects from
+     * @param index Index to record restored files in
+     * @param threads Worker thread count (0 selects hardware concurrency)
+     */
+    Checkout(Storage& storage, Index& index, unsigned threads = 0);
+
+    /**
+     * @brief Restores all files of a tree below a target directory
+     * @param tree_hash Hash of the root tree to restore
+     * @param target_root Directory to restore into ("." for the working directory)
+     * @param stats Reference to CheckoutStats to populate with results
+     * @return bool True if every file was restored, false otherwise
+     */
+    bool run(const std::string& tree_hash, const std::string& target_root, CheckoutStats& stats);
+};
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef COMMIT_GRAPH_H
+#define COMMIT_GRAPH_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bloom.h"
+#include "diff.h"
+#include "object.h"
+
+namespace vcs {
+
+/**
+ * @brief Cached metadata of a single commit in the commit graph
+ */
+struct CommitGraphEntry {
+    std::string tree_hash;                  ///< Hash of the commit's root tree
+    std::vector<std::string> parent_hashes; ///< Hashes of the parent commits
+    bool has_changed_paths = false;         ///< False if too many paths changed to filter
+    BloomFilter changed_paths;              ///< Filter of paths changed against the first parent
+    std::uint64_t generation = 0;           ///< One more than the largest parent generation (0 if an ancestor is not in the graph)
+};
+
+/**
+ * @brief Side file with the parents, tree and changed-path filter of every commit
+ *
+ * Path-limited history walks use it to skip commits that cannot have touched
+ * a path without reading the commit or diffing its trees. Generation numbers
+ * are derived from the parents in memory: a commit's generation is larger
+ * than that of any of its ancestors, which lets walks stop early.
+ */
+class CommitGraph {
+private:
+    std::string graph_path;     ///< Path to the commit-graph file
+    std::unordered_map<std::string, CommitGraphEntry> entries;  ///< Entries by commit hash
+
+    /**
+     * @brief Numbers every entry whose ancestors are all in the graph, parents first
+     */
+    void computeGenerations();
+
+public:
+    /**
+     * @brief Commits changing more paths than this get no filter
+     */
+    static const std::size_t MAX_CHANGED_PATHS = 512;
+
+    /**
+     * @brief Constructs a CommitGraph for the repository's commit-graph file
+     */
+    CommitGraph();
+
+    /**
+     * @brief Constructs a CommitGraph backed by a specific file
+     * @param path Path to the commit-graph file
+     */
+    explicit CommitGraph(const std::string& path);
+
+    /**
+     * @brief Loads all entries from disk
+     * @return bool True if the file was read, false if it does not exist
+     */
+    bool load();
+
+    /**
+     * @brief Adds an entry and appends it to the file on disk
+     * @param commit_hash Hash of the commit
+     * @param entry Graph entry of the commit
+     * @return bool True if the entry was written successfully, false otherwise
+     */
+    bool append(const std::string& commit_hash, const CommitGraphEntry& entry);
+
+    /**
+     * @brief Looks up the entry of a commit
+     * @param commit_hash Hash of the commit
+     * @return const CommitGraphEntry* The entry, or nullptr if the commit is not in the graph
+     */
+    const CommitGraphEntry* find(const std::string& commit_hash) const;
+
+    /**
+     * @brief Builds the graph entry of a commit from its diff against the first parent
+     * @param commit The commit
+     * @param changes Files changed against the first parent
+     * @return CommitGraphEntry Entry with the changed-path filter filled in
+     */
+    static CommitGraphEntry makeEntry(const Commit& commit, const std::vector<FileChange>& changes);
+
+    /**
+     * @brief Checks whether a commit may have changed a file or directory
+     * @param entry Graph entry of the commit
+     * @param path Slash-separated path of a file or directory
+     * @return bool False if the commit definitely did not change the path
+     */
+    static bool mayHaveChanged(const CommitGraphEntry& entry, const std::string& path);
+};
+
+} // namespace vcs
+
+#endif
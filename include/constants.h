@@ -1,6 +1,7 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+#include <cstdint>
 #include <string>
 #include <filesystem>
 
@@ -16,16 +17,46 @@ const std::string VCS_DIR = ".my_vcs";
  */
 const std::string OBJECTS_DIR = "objects";
 
+/**
+ * @brief Subdirectory of the objects directory holding pack files
+ */
+const std::string PACK_DIR = "pack";
+
+/**
+ * @brief File below the objects directory listing alternate object directories, one per line
+ */
+const std::string ALTERNATES_FILE = "info/alternates";
+
+/**
+ * @brief File below the objects directory caching the bloom filter of all stored objects
+ */
+const std::string OBJECT_INDEX_FILE = "info/object-index";
+
 /**
  * @brief Index file name for staging area
  */
 const std::string INDEX_FILE = "index";
 
+/**
+ * @brief Base index file; while it exists the index file only holds changes on top of it
+ */
+const std::string INDEX_BASE_FILE = "index.base";
+
 /**
  * @brief HEAD file name pointing to current branch/commit
  */
 const std::string HEAD_FILE = "HEAD";
 
+/**
+ * @brief Side file with parents, tree and changed-path filter of every commit
+ */
+const std::string COMMIT_GRAPH_FILE = "commit-graph";
+
+/**
+ * @brief Largest object a pack or bundle may hold; larger sizes are treated as corruption
+ */
+const std::uint64_t MAX_OBJECT_SIZE = 1ULL << 30;
+
 namespace types {
     /**
      * @brief Object type constant for file content storage
@@ -0,0 +1,85 @@
+#ifndef DIFF_H
+#define DIFF_H
+
+#include <string>
+#include <vector>
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief A single file-level difference between two trees
+ */
+struct FileChange {
+    /**
+     * @brief Kind of change applied to the file
+     */
+    enum class Kind {
+        Added,      ///< File exists only in the new tree
+        Deleted,    ///< File exists only in the old tree
+        Modified,   ///< File exists in both trees with different content
+        Renamed,    ///< File moved from old_path, possibly with edits
+        Copied      ///< File copied from old_path, which still exists
+    };
+
+    Kind kind;              ///< Kind of change
+    std::string path;       ///< Slash-separated path of the file
+    std::string old_hash;   ///< Blob hash in the old tree (empty if added)
+    std::string new_hash;   ///< Blob hash in the new tree (empty if deleted)
+    std::string old_path;   ///< Source path of a rename or copy (empty otherwise)
+    int similarity = 0;     ///< Similarity of a rename or copy in percent
+};
+
+/**
+ * @brief Computes file-level differences between two Tree hierarchies
+ *
+ * Subtrees with equal hashes are skipped without being read, so the cost
+ * of a diff follows the size of the change rather than the size of the tree.
+ */
+class TreeDiff {
+private:
+    Storage& storage;   ///< Storage the trees are read from
+
+    /**
+     * @brief Reports every file below a tree as added or deleted
+     * @param tree_hash Hash of the tree to walk
+     * @param prefix Path of the tree relative to the root
+     * @param kind Kind of change to report (Added or Deleted)
+     * @param changes Vector receiving the changes
+     * @return bool True if every tree could be read, false otherwise
+     */
+    bool addAll(const std::string& tree_hash, const std::string& prefix,
+                FileChange::Kind kind, std::vector<FileChange>& changes);
+
+    /**
+     * @brief Recursively compares two trees
+     * @param old_hash Hash of the old tree
+     * @param new_hash Hash of the new tree
+     * @param prefix Path of the trees relative to the root
+     * @param changes Vector receiving the changes
+     * @return bool True if every tree could be read, false otherwise
+     */
+    bool diffTrees(const std::string& old_hash, const std::string& new_hash,
+                   const std::string& prefix, std::vector<FileChange>& changes);
+
+public:
+    /**
+     * @brief Constructs a TreeDiff reading from the given storage
+     * @param storage Storage to read Tree objects from
+     */
+    explicit TreeDiff(Storage& storage);
+
+    /**
+     * @brief Computes the changes between two root trees
+     * @param old_tree_hash Hash of the old root tree (empty for no tree)
+     * @param new_tree_hash Hash of the new root tree (empty for no tree)
+     * @param changes Vector receiving the changes in path order
+     * @return bool True if every tree could be read, false otherwise
+     */
+    bool diff(const std::string& old_tree_hash, const std::string& new_tree_hash,
+              std::vector<FileChange>& changes);
+};
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef FSCK_H
+#define FSCK_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief A reference to an object that is missing or has the wrong type
+ */
+struct BrokenLink {
+    std::string hash;           ///< Hash of the referenced object
+    std::string expected_type;  ///< Type the reference requires ("blob", "tree" or "commit")
+    std::string referrer;       ///< Object, "HEAD" or "index" holding the reference
+};
+
+/**
+ * @brief Result of an integrity check
+ */
+struct FsckReport {
+    std::size_t objects = 0;                ///< Objects hashed
+    std::uint64_t bytes = 0;                ///< Total bytes hashed
+    double seconds = 0;                     ///< Wall time of the hashing phase
+    std::vector<std::string> corrupt;       ///< Objects whose content does not match their name
+    std::vector<BrokenLink> missing;        ///< References to absent or mistyped objects
+    std::vector<std::string> bad_packs;     ///< Pack indexes that are unreadable or inconsistent with their pack
+};
+
+/**
+ * @brief Verifies object hashes and connectivity of the whole object store
+ *
+ * Every loose and packed object is read and hashed on all cores; its type is the one
+ * whose prefix makes the hash match the object name. Trees and commits are
+ * then parsed and every reference, plus HEAD and the index, is checked;
+ * objects found only in an alternate are read and followed as well.
+ */
+class IntegrityChecker {
+private:
+    Storage& storage;   ///< Storage to verify
+    unsigned threads;   ///< Worker thread count (0 selects hardware concurrency)
+
+public:
+    /**
+     * @brief Constructs a checker for the given storage
+     * @param storage Storage to verify
+     * @param threads Worker thread count (0 selects hardware concurrency)
+     */
+    explicit IntegrityChecker(Storage& storage, unsigned threads = 0);
+
+    /**
+     * @brief Checks all objects and references
+     * @param report Reference to FsckReport to populate
+     * @param progress Stream for progress lines (nullptr for none)
+     * @return bool True if no corrupt or missing objects or bad packs were found, false otherwise
+     */
+    bool run(FsckReport& report, std::ostream* progress = nullptr);
+};
+
+} // namespace vcs
+
+#endif
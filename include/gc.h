@@ -0,0 +1,67 @@
+#ifndef GC_H
+#define GC_H
+
+#include <cstdint>
+#include <string>
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Summary of a garbage collection run
+ */
+struct GcStats {
+    std::size_t reachable = 0;          ///< Objects reachable from HEAD and the index
+    std::size_t examined = 0;           ///< Loose objects looked at by the sweep
+    std::size_t removed = 0;            ///< Unreachable objects deleted (or that would be)
+    std::size_t kept_recent = 0;        ///< Unreachable objects kept because they are too new
+    std::size_t missing = 0;            ///< Referenced objects that could not be read
+    std::uint64_t bytes_reclaimed = 0;  ///< Total size of removed objects
+};
+
+/**
+ * @brief Removes loose objects that are unreachable from HEAD and the index
+ *
+ * Objects younger than the grace period are never removed, which protects
+ * objects written by a concurrent add before it updates the index. The
+ * roots are read again after marking so entries staged meanwhile are kept.
+ */
+class GarbageCollector {
+private:
+    Storage& storage;   ///< Storage to collect
+    unsigned threads;   ///< Worker thread count for marking (0 selects hardware concurrency)
+
+public:
+    /**
+     * @brief Reads the current roots from HEAD and the index file
+     * @param commits Vector receiving the root commits
+     * @param blobs Vector receiving the staged blobs
+     */
+    static void readRoots(std::vector<std::string>& commits, std::vector<std::string>& blobs);
+
+    /**
+     * @brief Default grace period of two weeks, in seconds
+     */
+    static const std::int64_t DEFAULT_GRACE_SECONDS = 14 * 24 * 3600;
+
+    /**
+     * @brief Constructs a collector for the given storage
+     * @param storage Storage to collect
+     * @param threads Worker thread count for marking (0 selects hardware concurrency)
+     */
+    explicit GarbageCollector(Storage& storage, unsigned threads = 0);
+
+    /**
+     * @brief Marks reachable objects and sweeps the rest
+     * @param grace_seconds Only remove objects older than this many seconds
+     * @param dry_run Report what would be removed without deleting anything
+     * @param stats Reference to GcStats to populate
+     * @return bool True if every object could be examined and removed, false otherwise
+     *              (nothing is removed if a reachable object is missing)
+     */
+    bool run(std::int64_t grace_seconds, bool dry_run, GcStats& stats);
+};
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef GREP_H
+#define GREP_H
+
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "line_regex.h"
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Settings for a tree search
+ */
+struct GrepOptions {
+    bool ignore_case = false;       ///< Match letters regardless of case
+    bool fixed_strings = false;     ///< Treat the pattern as a literal instead of a regex
+    unsigned threads = 0;           ///< Worker thread count (0 selects hardware concurrency)
+};
+
+/**
+ * @brief A matching line (or a matching binary file)
+ */
+struct GrepMatch {
+    std::string path;           ///< Slash-separated path of the file
+    std::size_t line_number;    ///< 1-based line number (0 for a binary file)
+    std::string line;           ///< Text of the line without its line end (empty for a binary file)
+};
+
+/**
+ * @brief Counters describing the work done by a search
+ */
+struct GrepStats {
+    std::size_t files = 0;              ///< Files in the searched tree
+    std::size_t blobs_searched = 0;     ///< Blobs read and searched
+    std::size_t blobs_prefiltered = 0;  ///< Blobs ruled out by the literal prefilter
+    std::size_t binary_files = 0;       ///< Searched blobs detected as binary
+    std::size_t blob_cache_hits = 0;    ///< Files answered from the blob cache
+    std::size_t tree_cache_hits = 0;    ///< Subtrees answered from the tree cache
+    std::uint64_t bytes_searched = 0;   ///< Bytes of blob content searched
+    std::size_t lines_skipped = 0;      ///< Lines too long for a backtracking-only pattern
+};
+
+/**
+ * @brief Searches blob contents of a tree straight from the object store
+ *
+ * Each distinct blob is searched once on a pool of worker threads.
+ * Literals that every match must contain are extracted from the pattern;
+ * the longest is located with a vectorized scan, and a line reaches the
+ * regex only if it contains all of them. Regular patterns run on a linear-time
+ * NFA; patterns with backreferences or lookahead fall back to std::regex,
+ * whose recursive matcher is only given lines of bounded length.
+ * Results are cached per blob and per subtree for the current pattern,
+ * so searching another commit only reads the trees and blobs that differ;
+ * the caches are dropped once they hold too many entries or lines.
+ */
+class TreeGrep {
+private:
+    /**
+     * @brief Matching lines of one blob
+     */
+    struct BlobResult {
+        bool binary = false;                                        ///< True if the blob is binary
+        std::vector<std::pair<std::size_t, std::string>> lines;     ///< Line numbers and texts (one line 0 for a binary match)
+        std::size_t skipped = 0;                                    ///< Lines too long for the fallback regex
+    };
+
+    Storage& storage;                   ///< Storage trees and blobs are read from
+    GrepOptions options;                ///< Current search settings
+    std::string pattern;                ///< Current pattern
+    std::vector<std::string> literals;  ///< Literals every match contains, longest first
+    std::unique_ptr<std::regex> regex;  ///< Compiled pattern (null for fixed strings)
+    LineRegex line_regex;               ///< Linear-time form of the pattern
+    bool use_line_regex = false;        ///< True if the pattern is regular and line_regex is used
+    std::unordered_map<std::string, BlobResult> blob_cache;                 ///< Blob hash -> result
+    std::unordered_map<std::string, std::vector<GrepMatch>> tree_cache;     ///< Tree hash -> matches with relative paths
+    std::size_t cached_lines = 0;       ///< Matching lines held by both caches
+
+    /**
+     * @brief Drops the blob and subtree caches
+     */
+    void clearCaches();
+
+    /**
+     * @brief Searches the content of one blob
+     * @param data The blob content
+     * @param result Reference to BlobResult to populate
+     * @return bool False if the prefilter ruled the blob out, true otherwise
+     */
+    bool searchBlob(std::string_view data, BlobResult& result) const;
+
+public:
+    /**
+     * @brief Extracts literals that every match of a regex must contain
+     *
+     * Only text outside groups and brackets counts, and a pattern with a
+     * top-level alternation has no required literals.
+     *
+     * @param pattern ECMAScript regular expression
+     * @return std::vector<std::string> Required literals, longest first (empty if none were found)
+     */
+    static std::vector<std::string> requiredLiterals(const std::string& pattern);
+
+    /**
+     * @brief Finds a literal in a buffer
+     * @param haystack Buffer to search
+     * @param needle Literal to find (not empty)
+     * @param ignore_case Compare ASCII letters regardless of case
+     * @return std::size_t Offset of the first occurrence, or std::string_view::npos
+     */
+    static std::size_t findLiteral(std::string_view haystack, std::string_view needle, bool ignore_case);
+
+    /**
+     * @brief Constructs a TreeGrep reading from the given storage
+     * @param storage Storage to read trees and blobs from
+     */
+    explicit TreeGrep(Storage& storage);
+
+    /**
+     * @brief Sets the pattern; the caches are kept only if pattern and settings are unchanged
+     * @param pattern Regular expression or literal
+     * @param options Search settings
+     * @return bool True if the pattern is valid, false otherwise
+     */
+    bool setPattern(const std::string& pattern, const GrepOptions& options);
+
+    /**
+     * @brief Searches every file below a tree
+     * @param tree_hash Hash of the root tree
+     * @param matches Vector receiving matches in path and line order
+     * @param stats Reference to GrepStats to populate
+     * @return bool True if every tree and blob could be read, false otherwise
+     */
+    bool search(const std::string& tree_hash, std::vector<GrepMatch>& matches, GrepStats& stats);
+};
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <string>
+#include <vector>
+#include "commit_graph.h"
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Counters describing the work done by a history walk
+ */
+struct HistoryStats {
+    std::size_t commits_visited = 0;    ///< Commits reached by the walk
+    std::size_t filter_skipped = 0;     ///< Commits ruled out by their changed-path filter
+    std::size_t trees_diffed = 0;       ///< Commits whose trees had to be diffed
+};
+
+/**
+ * @brief Walks commit history, optionally limited to a path
+ */
+class History {
+private:
+    Storage& storage;       ///< Storage commits and trees are read from
+    CommitGraph& graph;     ///< Commit graph consulted before reading commits
+
+    /**
+     * @brief Gets tree and parents of a commit, preferring the commit graph
+     * @param commit_hash Hash of the commit
+     * @param entry Reference to CommitGraphEntry to populate
+     * @return bool True if the commit is known, false otherwise
+     */
+    bool lookup(const std::string& commit_hash, CommitGraphEntry& entry);
+
+public:
+    /**
+     * @brief Constructs a History walker
+     * @param storage Storage to read commits and trees from
+     * @param graph Commit graph with cached parents and changed-path filters
+     */
+    History(Storage& storage, CommitGraph& graph);
+
+    /**
+     * @brief Lists commits reachable from a start commit, newest first
+     * @param start_hash Hash of the commit to start from
+     * @param path Only list commits changing this file or directory (empty for all)
+     * @param commits Vector receiving the matching commit hashes
+     * @param stats Reference to HistoryStats to populate
+     * @param use_filters Consult changed-path filters before diffing (default true)
+     * @return bool True if the walk completed, false if a commit or tree was missing
+     */
+    bool log(const std::string& start_hash, const std::string& path,
+             std::vector<std::string>& commits, HistoryStats& stats, bool use_filters = true);
+
+    /**
+     * @brief Checks whether one commit is reachable from another through parents
+     * @param ancestor Hash of the possible ancestor
+     * @param descendant Hash of the commit to walk back from
+     * @param result Reference set to true if ancestor is descendant or one of its ancestors
+     * @return bool True if the walk completed, false if a commit was missing
+     */
+    bool isAncestor(const std::string& ancestor, const std::string& descendant, bool& result);
+};
+
+} // namespace vcs
+
+#endif
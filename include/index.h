@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <unordered_map>
 
 namespace vcs {
@@ -14,6 +15,9 @@ struct IndexEntry {
     std::string file_path;      ///< Path to the file in working directory
     std::string blob_hash;      ///< Hash of the file content (Blob)
     std::uint64_t timestamp;    ///< Timestamp when file was added to index
+    std::uint64_t file_size;    ///< Size of the working file when it was staged
+    std::uint64_t mtime;        ///< Modification time of the working file when it was staged
+    bool staged;                ///< False for stat data of a file restored by checkout (not committed)
     
     /**
      * @brief Default constructor for IndexEntry
@@ -30,17 +34,42 @@ struct IndexEntry {
 
 /**
  * @brief Manages the staging area (index) for tracking files to be committed
+ *
+ * Checkout records the stat data of the files it restores as unstaged
+ * entries; only staged entries are listed, committed or reported.
+ *
+ * In split mode the entries live in a base file that is rarely rewritten,
+ * and the index file becomes an append-only log of "+ <entry>" and
+ * "- <path>" lines. Staging a file then costs one appended line; the log
+ * is folded into the base once it grows past a fraction of the base.
  */
 class Index {
 private:
-    std::string index_path;     ///< Path to the index file on disk
-    std::unordered_map<std::string, IndexEntry> entries;  ///< Map of staged files (path -> entry)
+    std::string index_path;     ///< Path to the index file (the change log in split mode)
+    std::string base_path;      ///< Path to the base index file of split mode
+    mutable std::unordered_map<std::string, IndexEntry> entries;  ///< Map of staged files (path -> entry)
+    mutable bool loaded;        ///< True once the index file has been read
+    mutable bool split;         ///< True if the base index file exists
+    mutable std::size_t base_count;     ///< Entries in the base file
+    mutable std::size_t delta_count;    ///< Lines in the change log
+    mutable std::string loaded_stamp;   ///< Size and mtime of the index files when they were read
+    
+    /**
+     * @brief Describes the current state of the index files on disk
+     * @return std::string Size and mtime of the index and base files
+     */
+    std::string diskStamp() const;
     
     /**
      * @brief Loads index entries from disk storage
      * @return bool True if load successful, false otherwise
      */
-    bool loadFromDisk();
+    bool loadFromDisk() const;
+    
+    /**
+     * @brief Reads the index file on first access
+     */
+    void ensureLoaded() const;
     
     /**
      * @brief Saves index entries to disk storage
@@ -48,9 +77,36 @@ private:
      */
     bool saveToDisk();
     
+    /**
+     * @brief Rewrites the base index with all entries and empties the change log
+     * @return bool True if save successful, false otherwise
+     */
+    bool writeBase();
+    
+    /**
+     * @brief Persists changed entries: appended to the change log in split mode, a full save otherwise
+     * @param updated Entries that were added or replaced
+     * @param removed Paths that were removed
+     * @return bool True if save successful, false otherwise
+     */
+    bool saveChanges(const std::vector<const IndexEntry*>& updated,
+                     const std::vector<std::string>& removed);
+    
+    /**
+     * @brief Writes changed entries without tracking the on-disk state
+     * @param updated Entries that were added or replaced
+     * @param removed Paths that were removed
+     * @return bool True if save successful, false otherwise
+     */
+    bool appendChanges(const std::vector<const IndexEntry*>& updated,
+                       const std::vector<std::string>& removed);
+    
 public:
+    static const std::size_t MIN_FOLD_ENTRIES = 256;    ///< Change log lines always tolerated before folding
+    static const std::size_t MAX_DELTA_PERCENT = 20;    ///< Change log size (percent of base) that triggers folding
+    
     /**
-     * @brief Constructs Index object and loads existing index from disk
+     * @brief Constructs Index object; the index file is read on first access
      */
     Index();
     
@@ -62,6 +118,13 @@ public:
      */
     bool addFile(const std::string& file_path, const std::string& blob_hash);
     
+    /**
+     * @brief Adds or updates many entries and writes the index to disk once
+     * @param batch Entries to stage or stat data to record (replaces entries with the same path, except that stat data never replaces a staged entry)
+     * @return bool True if the index was saved successfully, false otherwise
+     */
+    bool addFiles(const std::vector<IndexEntry>& batch);
+    
     /**
      * @brief Removes a file from the staging area index
      * @param file_path Path to the file to remove
@@ -76,6 +139,14 @@ public:
      */
     bool containsFile(const std::string& file_path) const;
     
+    /**
+     * @brief Looks up the staged entry for a file
+     * @param file_path Path to the file to look up
+     * @param entry Reference to IndexEntry to populate with data
+     * @return bool True if file is staged, false otherwise
+     */
+    bool getEntry(const std::string& file_path, IndexEntry& entry) const;
+    
     /**
      * @brief Gets list of all file paths currently staged in index
      * @return std::vector<std::string> List of staged file paths
@@ -88,8 +159,43 @@ public:
      */
     bool isClean() const;
     
+    /**
+     * @brief Switches split mode on or off, rewriting the index in the new layout
+     * @param enable True to keep a base index plus a change log, false for a single file
+     * @return bool True if the index was rewritten successfully, false otherwise
+     */
+    bool setSplit(bool enable);
+    
+    /**
+     * @brief Checks whether the index is in split mode
+     * @return bool True if entries are kept in a base index plus a change log
+     */
+    bool isSplit() const;
+    
+    /**
+     * @brief Gets the number of entries in the base index
+     * @return std::size_t Base entries (0 outside split mode)
+     */
+    std::size_t baseSize() const;
+    
+    /**
+     * @brief Gets the number of lines in the change log
+     * @return std::size_t Change log lines (0 outside split mode)
+     */
+    std::size_t deltaSize() const;
+    
+    /**
+     * @brief Drops the loaded entries if another process changed the index files
+     *
+     * Long-running processes call this between requests so that they never
+     * act on, or overwrite, a stale copy of the index.
+     */
+    void refresh();
+    
     /**
      * @brief Clears all entries from the index and removes index file from disk
+     *
+     * Split mode stays on: the base is emptied instead of removed.
      */
     void clear();
 };
@@ -0,0 +1,157 @@
+#ifndef LINE_REGEX_H
+#define LINE_REGEX_H
+
+#include <bitset>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vcs {
+
+/**
+ * @brief Regular expression matcher that runs in time linear in the line length
+ *
+ * Patterns are compiled to a Thompson NFA and simulated one byte at a time
+ * without recursion or backtracking, so a long line cannot exhaust the stack.
+ * Covers the regular subset of ECMAScript syntax: literals and escapes,
+ * ".", bracket classes, "\d", "\w", "\s" and their negations, groups,
+ * alternation, greedy or lazy quantifiers and the assertions "^", "$",
+ * "\b" and "\B".
+ * Backreferences and lookahead are not regular and are rejected by compile().
+ */
+class LineRegex {
+private:
+    /**
+     * @brief One instruction of the compiled program
+     */
+    struct Inst {
+        enum class Op {
+            Class,          ///< Consume a byte in classes[arg]
+            Split,          ///< Continue at both arg and arg2
+            Jump,           ///< Continue at arg
+            LineStart,      ///< Assert the start of the line
+            LineEnd,        ///< Assert the end of the line
+            WordBoundary,   ///< Assert a word boundary
+            NotWordBoundary,///< Assert the absence of a word boundary
+            Match           ///< The pattern matched
+        };
+        Op op;          ///< Operation
+        int arg = 0;    ///< Class index, or target of a jump or the first branch of a split
+        int arg2 = 0;   ///< Second branch of a split
+    };
+
+    /**
+     * @brief Node of the parsed pattern
+     */
+    struct Node {
+        enum class Kind { Class, Assert, Concat, Alternate, Repeat };
+        Kind kind;                  ///< What the node matches
+        int value = 0;              ///< Class index, or assertion opcode
+        int min = 0;                ///< Minimum repetitions
+        int max = 0;                ///< Maximum repetitions (-1 for unbounded)
+        std::vector<int> children;  ///< Operands
+
+        explicit Node(Kind kind) : kind(kind) {}
+    };
+
+    std::vector<Inst> program;                  ///< Compiled instructions, starting at 0
+    std::vector<std::bitset<256>> classes;      ///< Byte sets used by Class instructions
+
+    std::vector<Node> nodes;    ///< Parsed pattern (only while compiling)
+    std::string source;         ///< Pattern being compiled
+    std::size_t pos = 0;        ///< Parse position in source
+    bool ignore_case = false;   ///< Fold ASCII letters into both cases
+
+    /**
+     * @brief Parses alternatives separated by '|'
+     * @param depth Group nesting depth
+     * @return int Index of the node (-1 on failure)
+     */
+    int parseAlternation(int depth);
+
+    /**
+     * @brief Parses a sequence of quantified atoms
+     * @param depth Group nesting depth
+     * @return int Index of the node (-1 on failure)
+     */
+    int parseConcat(int depth);
+
+    /**
+     * @brief Parses an atom with an optional quantifier
+     * @param depth Group nesting depth
+     * @return int Index of the node (-1 on failure)
+     */
+    int parseRepeat(int depth);
+
+    /**
+     * @brief Parses a literal, class, group or assertion
+     * @param depth Group nesting depth
+     * @return int Index of the node (-1 on failure)
+     */
+    int parseAtom(int depth);
+
+    /**
+     * @brief Expands a class escape ("\d", "\w", "\s" and their negations)
+     * @param escaped Letter after the backslash
+     * @param set Byte set the class is added to
+     * @return bool True if the letter names a class, false otherwise
+     */
+    bool parseClassEscape(char escaped, std::bitset<256>& set);
+
+    /**
+     * @brief Decodes an escape that stands for one byte (control, "\0", "\xHH", "\uHHHH", "\cX")
+     * @param escaped Letter after the backslash (its operand follows at pos)
+     * @param value Reference to receive the byte
+     * @return bool True if the escape stands for a single byte, false otherwise
+     */
+    bool parseCharEscape(char escaped, unsigned char& value);
+
+    /**
+     * @brief Parses a bracket expression after its opening '['
+     * @param set Reference to receive the accepted bytes
+     * @return bool True if the expression is supported and closed, false otherwise
+     */
+    bool parseBracket(std::bitset<256>& set);
+
+    /**
+     * @brief Adds a byte set, folding case if required, and a node consuming it
+     * @param set Bytes the node accepts
+     * @return int Index of the node
+     */
+    int addClass(std::bitset<256> set);
+
+    /**
+     * @brief Adds a node to the parsed pattern
+     * @param node The node
+     * @return int Index of the node
+     */
+    int addNode(Node node);
+
+    /**
+     * @brief Appends the instructions of a node to the program
+     * @param node Index of the node
+     * @return bool True if the program stays within its size limit, false otherwise
+     */
+    bool emit(int node);
+
+public:
+    /**
+     * @brief Compiles a pattern
+     * @param pattern ECMAScript regular expression
+     * @param ignore_case Match ASCII letters regardless of case
+     * @return bool True if the pattern was compiled, false if it is invalid or not regular
+     */
+    bool compile(const std::string& pattern, bool ignore_case);
+
+    /**
+     * @brief Checks whether the pattern matches anywhere in a line
+     * @param line Text of the line without its line end
+     * @return bool True if some substring matches, false otherwise
+     */
+    bool search(std::string_view line) const;
+};
+
+} // namespace vcs
+
+#endif
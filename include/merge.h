@@ -0,0 +1,189 @@
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "commit_graph.h"
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief A path the three-way merge could not resolve on its own
+ */
+struct MergeConflict {
+    /**
+     * @brief Kind of conflict
+     */
+    enum class Kind {
+        Content,        ///< Both sides changed the same lines (result has conflict markers)
+        Binary,         ///< Both sides changed a binary file (result keeps ours)
+        ModifyDelete,   ///< One side modified a file the other deleted (result keeps the modification)
+        FileDirectory   ///< One side has a file where the other has a directory (result keeps ours)
+    };
+
+    Kind kind;                  ///< Kind of conflict
+    std::string path;           ///< Slash-separated path of the file
+    std::string base_hash;      ///< Entry hash in the merge base (empty if absent)
+    std::string ours_hash;      ///< Entry hash on our side (empty if absent)
+    std::string theirs_hash;    ///< Entry hash on their side (empty if absent)
+};
+
+/**
+ * @brief Counters describing the work done by a merge
+ */
+struct MergeStats {
+    std::size_t trees_read = 0;         ///< Trees read to merge their entries
+    std::size_t subtrees_skipped = 0;   ///< Subtrees resolved by hash without being read
+    std::size_t blobs_merged = 0;       ///< Files changed on both sides and merged line by line
+};
+
+/**
+ * @brief Result of a three-way merge
+ */
+struct MergeResult {
+    std::string base_hash;                  ///< Merge base commit (empty if the histories are unrelated)
+    std::string tree_hash;                  ///< Merged tree, with conflict markers in conflicting files
+    std::vector<MergeConflict> conflicts;   ///< Conflicts in path order (empty for a clean merge)
+};
+
+/**
+ * @brief Merges the trees of two commits in memory, without a working tree
+ *
+ * The merge base is a common ancestor that no other common ancestor
+ * descends from. The three root trees are then merged recursively: any
+ * subtree whose hash matches on two sides is resolved without being read,
+ * and only files changed on both sides are merged line by line (diff3
+ * over a Myers diff). All results are written to storage as regular trees and blobs.
+ */
+class TreeMerger {
+private:
+    Storage& storage;           ///< Storage trees and blobs are read from and written to
+    const CommitGraph* graph;   ///< Commit graph consulted before reading commits (may be null)
+    std::size_t commits_walked; ///< Commits visited by the last merge base search
+    std::string ours_label;     ///< Label of our side in conflict markers
+    std::string theirs_label;   ///< Label of their side in conflict markers
+
+    /**
+     * @brief Recursively merges three trees
+     * @param base Hash of the base tree (empty if absent)
+     * @param ours Hash of our tree (empty if absent)
+     * @param theirs Hash of their tree (empty if absent)
+     * @param prefix Path of the trees relative to the root
+     * @param result Reference to receive the merged tree hash (empty if it has no entries)
+     * @param conflicts Vector receiving conflicts
+     * @param stats Reference to MergeStats to update
+     * @return bool True if every object could be read and written, false otherwise
+     */
+    bool mergeTrees(const std::string& base, const std::string& ours, const std::string& theirs,
+                    const std::string& prefix, std::string& result,
+                    std::vector<MergeConflict>& conflicts, MergeStats& stats);
+
+    /**
+     * @brief Merges two versions of a file against their base
+     * @param base Hash of the base blob (empty if absent)
+     * @param ours Hash of our blob
+     * @param theirs Hash of their blob
+     * @param result Reference to receive the merged blob hash
+     * @param clean Reference set to false if conflict markers were written
+     * @param binary Reference set to true if a side is binary (result is ours)
+     * @return bool True if every blob could be read and written, false otherwise
+     */
+    bool mergeBlobs(const std::string& base, const std::string& ours, const std::string& theirs,
+                    std::string& result, bool& clean, bool& binary);
+
+    /**
+     * @brief Gets the parents of a commit from the commit graph, or from the commit itself
+     * @param hash Commit hash
+     * @param parents Vector receiving the parent hashes
+     * @return bool True if the commit could be found, false otherwise
+     */
+    bool parentsOf(const std::string& hash, std::vector<std::string>& parents);
+
+    /**
+     * @brief Gets the generation number of a commit for ordering walks
+     * @param hash Commit hash
+     * @return std::uint64_t Generation from the commit graph (the maximum if unknown)
+     */
+    std::uint64_t generationOf(const std::string& hash) const;
+
+    /**
+     * @brief Adds a commit and its ancestors down to a generation to a set
+     * @param start Commit hash to start from
+     * @param min_generation Commits numbered below this are neither added nor walked
+     * @param seen Set receiving the commits; commits already in it are not walked again
+     * @return bool True if all commits could be read, false otherwise
+     */
+    bool collectAncestors(const std::string& start, std::uint64_t min_generation,
+                          std::unordered_set<std::string>& seen);
+
+public:
+    /**
+     * @brief Constructs a TreeMerger working on the given storage
+     * @param storage Storage to read from and write to
+     * @param graph Commit graph used to walk history without reading commits (may be null)
+     */
+    explicit TreeMerger(Storage& storage, const CommitGraph* graph = nullptr);
+
+    /**
+     * @brief Merges text line by line against a common base
+     * @param base Base version
+     * @param ours Our version
+     * @param theirs Their version
+     * @param ours_label Label after the "<<<<<<<" marker
+     * @param theirs_label Label after the ">>>>>>>" marker
+     * @param merged Reference to string receiving the result
+     * @return bool True if the merge is clean, false if conflict markers were written
+     */
+    static bool mergeText(const std::string& base, const std::string& ours, const std::string& theirs,
+                          const std::string& ours_label, const std::string& theirs_label,
+                          std::string& merged);
+
+    /**
+     * @brief Finds a best common ancestor of two commits
+     *
+     * A best common ancestor is not an ancestor of another common ancestor.
+     * Criss-cross histories have several; the one with the newest timestamp
+     * (then the smallest hash) is chosen.
+     *
+     * @param a First commit hash
+     * @param b Second commit hash
+     * @param base Reference to receive the merge base (empty if there is none)
+     * @return bool True if all commits could be read, false otherwise
+     */
+    bool findMergeBase(const std::string& a, const std::string& b, std::string& base);
+
+    /**
+     * @brief Gets the number of commits the last merge base search visited
+     * @return std::size_t Commits visited (0 before the first search)
+     */
+    std::size_t commitsWalked() const;
+
+    /**
+     * @brief Merges the trees of two commits
+     * @param ours Our commit hash
+     * @param theirs Their commit hash
+     * @param result Reference to MergeResult to populate
+     * @param stats Reference to MergeStats to populate
+     * @return bool True if the merge could be computed, false if objects were missing
+     */
+    bool merge(const std::string& ours, const std::string& theirs, MergeResult& result, MergeStats& stats);
+
+    /**
+     * @brief Merges the trees of two commits against a merge base found earlier
+     * @param ours Our commit hash
+     * @param theirs Their commit hash
+     * @param base Merge base from findMergeBase (empty if the histories are unrelated)
+     * @param result Reference to MergeResult to populate
+     * @param stats Reference to MergeStats to populate
+     * @return bool True if the merge could be computed, false if objects were missing
+     */
+    bool merge(const std::string& ours, const std::string& theirs, const std::string& base,
+               MergeResult& result, MergeStats& stats);
+};
+
+} // namespace vcs
+
+#endif
@@ -1,11 +1,48 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace vcs {
 
+/**
+ * @brief Number of bytes in a binary (raw) object hash
+ */
+const std::size_t RAW_HASH_SIZE = 8;
+
+/**
+ * @brief Calculates a simple hash for input string using std::hash
+ * @param input The string to hash ("<type>:" followed by the serialized object)
+ * @return std::string Hexadecimal representation of the hash
+ */
+std::string calculateSimpleHash(std::string_view input);
+
+/**
+ * @brief Detects the type of stored object data by matching it against its name
+ * @param hash The object name
+ * @param data The stored object data
+ * @return std::string "blob", "tree" or "commit", or empty if the data does not match the hash
+ */
+std::string detectObjectType(const std::string& hash, std::string_view data);
+
+/**
+ * @brief Converts a hex object hash to its raw binary form
+ * @param hex The hex hash (16 lowercase hex digits)
+ * @param raw Reference to string to receive the raw bytes
+ * @return bool True if the hash was well-formed, false otherwise
+ */
+bool hexToRaw(std::string_view hex, std::string& raw);
+
+/**
+ * @brief Converts a raw binary object hash to hex
+ * @param raw The raw hash bytes
+ * @return std::string The hex hash
+ */
+std::string rawToHex(std::string_view raw);
+
 /**
  * @brief Represents a file object in the VCS (stores file content)
  */
@@ -38,6 +75,52 @@ struct TreeEntry {
     std::string name;    ///< File or directory name
 };
 
+/**
+ * @brief Non-owning view of one entry of a serialized tree
+ */
+struct TreeEntryView {
+    std::string_view mode;      ///< Octal permissions mode (e.g., "100644", "40000" for trees)
+    std::string_view name;      ///< File or directory name
+    std::string_view raw_hash;  ///< Raw binary hash of the referenced object
+    
+    /**
+     * @brief Checks whether the entry refers to a subtree
+     * @return bool True for directory entries, false for files
+     */
+    bool isTree() const;
+};
+
+/**
+ * @brief Reads entries of a serialized tree one by one without allocating
+ *
+ * Each entry is stored as "<octal mode> <name>\0<raw hash>".
+ */
+class TreeParser {
+private:
+    std::string_view data;  ///< Remaining serialized tree data
+    bool error;             ///< True once malformed data was found
+    
+public:
+    /**
+     * @brief Constructs a parser over serialized tree data
+     * @param data The serialized tree (must outlive the parser and its views)
+     */
+    explicit TreeParser(std::string_view data);
+    
+    /**
+     * @brief Parses the next entry
+     * @param entry Reference to TreeEntryView to populate
+     * @return bool True if an entry was read, false at the end or on malformed data
+     */
+    bool next(TreeEntryView& entry);
+    
+    /**
+     * @brief Checks whether parsing stopped on malformed data
+     * @return bool True if the data was malformed, false otherwise
+     */
+    bool failed() const;
+};
+
 /**
  * @brief Represents a directory structure in the VCS
  */
@@ -62,6 +145,56 @@ struct Tree {
      * @return std::string Serialized tree representation
      */
     std::string serialize() const;
+    
+    /**
+     * @brief Checks that the tree can be serialized without losing information
+     * @return bool True if every entry has a well-formed hash, a mode matching its type
+     *              (40000 for trees, 100644 or 100755 for blobs) and a non-empty name without NUL
+     */
+    bool isValid() const;
+    
+    /**
+     * @brief Parses a serialized tree
+     * @param data The serialized tree
+     * @param tree Reference to Tree object to populate (hash is left empty)
+     * @return bool True if the data was well-formed, false otherwise
+     */
+    static bool parse(std::string_view data, Tree& tree);
+};
+
+/**
+ * @brief Non-owning view of a serialized commit, parsed without allocating
+ *
+ * A serialized commit is a sequence of fields, each a one-byte tag, a
+ * varint length and the value: tree ('t'), parents ('p', concatenated raw
+ * hashes), author ('a'), timestamp ('d') and message ('m').
+ */
+struct CommitView {
+    std::string_view tree_raw;      ///< Raw hash of the root tree
+    std::string_view parents_raw;   ///< Raw hashes of all parents, back to back
+    std::string_view author;        ///< Commit author information
+    std::string_view timestamp;     ///< Commit timestamp
+    std::string_view message;       ///< Commit message
+    
+    /**
+     * @brief Parses a serialized commit
+     * @param data The serialized commit (must outlive the view)
+     * @return bool True if the data was well-formed, false otherwise
+     */
+    bool parse(std::string_view data);
+    
+    /**
+     * @brief Gets the number of parents
+     * @return std::size_t Number of parent commits
+     */
+    std::size_t parentCount() const;
+    
+    /**
+     * @brief Gets the raw hash of a parent
+     * @param i Index of the parent (less than parentCount())
+     * @return std::string_view Raw hash of the parent
+     */
+    std::string_view parentRaw(std::size_t i) const;
 };
 
 /**
@@ -86,6 +219,20 @@ struct Commit {
      * @return std::string Serialized commit representation
      */
     std::string serialize() const;
+    
+    /**
+     * @brief Checks that the commit can be serialized without losing information
+     * @return bool True if the tree and parent hashes are well-formed
+     */
+    bool isValid() const;
+    
+    /**
+     * @brief Parses a serialized commit
+     * @param data The serialized commit
+     * @param commit Reference to Commit object to populate (hash is left empty)
+     * @return bool True if the data was well-formed, false otherwise
+     */
+    static bool parse(std::string_view data, Commit& commit);
 };
 
 } // namespace vcs
@@ -0,0 +1,159 @@
+#ifndef OBJECT_INDEX_H
+#define OBJECT_INDEX_H
+
+#include <cstddef>
+#include <filesystem>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "bloom.h"
+#include "pack.h"
+
+namespace vcs {
+
+/**
+ * @brief Checks whether a file name has the form of an object hash
+ * @param name The file name to check
+ * @return bool True if the name is a 16-digit lowercase hex hash
+ */
+bool isObjectName(const std::string& name);
+
+/**
+ * @brief In-memory index of every loose and packed object in an object directory
+ *
+ * Built on first use from one scan of the loose objects plus the indexes of
+ * all packs, and kept up to date as objects are stored, so lookups for
+ * missing objects are answered by a bloom filter without touching the
+ * filesystem and packed objects are found without probing each pack file.
+ *
+ * The filter is saved to objects/info/object-index together with the
+ * directory mtimes it reflects, after a scan and when the index is destroyed
+ * with new objects added. A later process loads it instead of scanning, as
+ * long as neither directory has changed since; the pack indexes are then
+ * only opened when a packed object is looked up.
+ */
+class ObjectIndex {
+private:
+    std::string objects_path;           ///< Object directory covered by the index
+    mutable std::shared_mutex mutex;    ///< Guards all members below
+    bool loaded;                        ///< True once the filter has been scanned or read
+    bool packs_loaded;                  ///< True once the pack indexes have been opened
+    bool dirty;                         ///< True if objects were added since the filter was saved
+    std::size_t scans;                  ///< Number of full directory scans
+    BloomFilter bloom;                  ///< Filter over all known object hashes
+    std::size_t key_count;              ///< Number of hashes added to the filter
+    std::size_t capacity;               ///< Number of hashes the filter was sized for
+    std::filesystem::file_time_type scanned_mtime;  ///< Directory mtime seen by the last scan
+    std::filesystem::file_time_type scanned_pack_mtime;  ///< Pack directory mtime seen by the last scan
+    std::vector<PackReader> packs;      ///< Indexes of all pack files
+
+    /**
+     * @brief Loads the index if it has not been loaded yet (shared lock not held)
+     */
+    void ensureLoaded();
+
+    /**
+     * @brief Opens the pack indexes if they have not been opened yet (shared lock not held)
+     */
+    void ensurePacksLoaded();
+
+    /**
+     * @brief Opens the index of every pack in the pack directory (mutex held)
+     */
+    void openPacksLocked();
+
+    /**
+     * @brief Reads the saved filter, or scans the directory if it is missing or stale (mutex held)
+     */
+    void loadLocked();
+
+    /**
+     * @brief Scans the object directory and rebuilds and saves the filter (mutex held)
+     */
+    void scanLocked();
+
+    /**
+     * @brief Reads the saved filter if it matches the current directory mtimes (mutex held)
+     * @return bool True if the filter was read, false if it is missing, stale or malformed
+     */
+    bool readLocked();
+
+    /**
+     * @brief Saves the filter with the directory mtimes it reflects (mutex held)
+     * @return bool True if the file was written, false otherwise
+     */
+    bool writeLocked();
+
+public:
+    /**
+     * @brief Constructs an ObjectIndex for an object directory
+     * @param objects_path Path to the object directory
+     */
+    explicit ObjectIndex(const std::string& objects_path);
+
+    /**
+     * @brief Saves the filter if objects were added and no other process changed the directory
+     */
+    ~ObjectIndex();
+
+    /**
+     * @brief Checks whether an object may exist, loading the index on first use
+     * @param hash The object hash to check
+     * @return bool False if the object is definitely absent, true if it may exist
+     */
+    bool mightContain(const std::string& hash);
+
+    /**
+     * @brief Records a newly stored object
+     * @param hash The hash of the stored object
+     * @param previous_mtime Directory mtime taken just before the object was written
+     */
+    void add(const std::string& hash, std::filesystem::file_time_type previous_mtime);
+
+    /**
+     * @brief Drops the index so the next lookup rescans the directory
+     */
+    void reset();
+
+    /**
+     * @brief Rescans the directory if it was modified since the filter was built
+     */
+    void refreshIfChanged();
+
+    /**
+     * @brief Checks whether an object is stored in one of the packs
+     * @param hash The object hash to check
+     * @return bool True if a pack contains the object, false otherwise
+     */
+    bool containsPacked(const std::string& hash);
+
+    /**
+     * @brief Reads an object from the pack that contains it
+     * @param hash The object hash to read
+     * @param data Reference to string to receive the object data
+     * @return bool True if the object was found and read, false otherwise
+     */
+    bool readPacked(const std::string& hash, std::string& data);
+
+    /**
+     * @brief Lists the hashes of all packed objects
+     * @return std::vector<std::string> Hashes of objects in all packs
+     */
+    std::vector<std::string> packedObjects();
+
+    /**
+     * @brief Gets the number of objects known to the index
+     * @return std::size_t Number of indexed objects (0 if not loaded yet)
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Gets the number of full directory scans made so far
+     * @return std::size_t Number of scans (0 while the saved filter was enough)
+     */
+    std::size_t scanCount() const;
+};
+
+} // namespace vcs
+
+#endif
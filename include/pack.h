@@ -0,0 +1,120 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace vcs {
+
+/**
+ * @brief Location of one object inside a pack file
+ */
+struct PackEntry {
+    std::uint64_t key;      ///< Object hash as a number (16 hex digits)
+    std::uint64_t offset;   ///< Offset of the object record in the pack file
+};
+
+/**
+ * @brief Converts a hex object hash to its numeric key
+ * @param hash The hex hash
+ * @param key Reference to receive the key
+ * @return bool True if the hash was well-formed, false otherwise
+ */
+bool hashToKey(const std::string& hash, std::uint64_t& key);
+
+/**
+ * @brief Read access to a pack file through its index
+ *
+ * A pack holds zlib-compressed object records back to back; the ".idx"
+ * file next to it lists (hash, offset) pairs sorted by hash, so lookups
+ * are a binary search in memory and a single read from the pack.
+ */
+class PackReader {
+private:
+    std::string pack_path;              ///< Path to the ".pack" file
+    std::vector<PackEntry> entries;     ///< Index entries sorted by key
+    std::uint64_t pack_size = 0;        ///< Size of the ".pack" file when the index was loaded
+
+public:
+    /**
+     * @brief Loads the index of a pack
+     * @param idx_path Path to the ".idx" file (the ".pack" file must sit next to it)
+     * @return bool True if the index was read and is consistent with both files, false otherwise
+     */
+    bool open(const std::string& idx_path);
+
+    /**
+     * @brief Checks whether the pack contains an object
+     * @param key Numeric key of the object hash
+     * @return bool True if the object is in the pack, false otherwise
+     */
+    bool contains(std::uint64_t key) const;
+
+    /**
+     * @brief Reads and decompresses an object from the pack
+     * @param key Numeric key of the object hash
+     * @param data Reference to string to receive the object data
+     * @return bool True if the object was read successfully, false otherwise
+     */
+    bool read(std::uint64_t key, std::string& data) const;
+
+    /**
+     * @brief Lists the hashes of all objects in the pack
+     * @return std::vector<std::string> Hex hashes of packed objects
+     */
+    std::vector<std::string> hashes() const;
+};
+
+/**
+ * @brief Writes a new pack file and its index
+ *
+ * Data goes to temporary files that are renamed into place by finish(),
+ * so readers never see a partially written pack.
+ */
+class PackWriter {
+private:
+    std::string base_path;              ///< Final path without the ".pack"/".idx" extension
+    std::ofstream pack;                 ///< Temporary pack file being written
+    std::uint64_t offset;               ///< Current write offset in the pack
+    std::vector<PackEntry> entries;     ///< Entries written so far
+
+public:
+    /**
+     * @brief Starts a new pack in a directory
+     * @param pack_dir Directory to create the pack in
+     * @param name Pack name (file names become "pack-<name>.pack/.idx")
+     * @return bool True if the pack file could be created, false otherwise
+     */
+    bool open(const std::string& pack_dir, const std::string& name);
+
+    /**
+     * @brief Compresses and appends an object
+     * @param hash The object's hash
+     * @param data The object data
+     * @return bool True if the object was written successfully, false otherwise
+     */
+    bool add(const std::string& hash, const std::string& data);
+
+    /**
+     * @brief Gets the number of objects added so far
+     * @return std::size_t Number of objects in the pack
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Writes the index and moves both files into place (an empty pack is discarded)
+     * @return bool True if the pack was completed successfully, false otherwise
+     */
+    bool finish();
+
+    /**
+     * @brief Discards the pack being written
+     */
+    void abort();
+};
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace vcs {
+
+/**
+ * @brief Gets the number of worker threads to use for parallel operations
+ * @param requested Requested thread count (0 selects hardware concurrency)
+ * @return unsigned Number of worker threads, at least 1
+ */
+inline unsigned workerCount(unsigned requested = 0) {
+    if (requested > 0) return requested;
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+/**
+ * @brief Calls fn(i) for every i in [0, count) on a pool of worker threads
+ *
+ * Items are handed out one at a time through a shared counter, so workers
+ * that draw small items simply take more of them.
+ *
+ * @param count Number of work items
+ * @param fn Callable invoked with the index of each item
+ * @param threads Number of worker threads (0 selects hardware concurrency)
+ */
+template <typename Fn>
+void parallelFor(std::size_t count, Fn fn, unsigned threads = 0) {
+    unsigned workers = workerCount(threads);
+    if (workers > count) workers = static_cast<unsigned>(count);
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; i++) fn(i);
+        return;
+    }
+
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+        for (std::size_t i = next++; i < count; i = next++) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned t = 1; t < workers; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Marks every object reachable from a set of commits and blobs
+ *
+ * Commits are followed through their parents one by one; the trees they
+ * reference are then read level by level, with each level spread across
+ * worker threads.
+ */
+class ReachabilityWalker {
+private:
+    Storage& storage;   ///< Storage the objects are read from
+    unsigned threads;   ///< Worker thread count (0 selects hardware concurrency)
+
+public:
+    /**
+     * @brief Constructs a walker reading from the given storage
+     * @param storage Storage to read objects from
+     * @param threads Worker thread count (0 selects hardware concurrency)
+     */
+    explicit ReachabilityWalker(Storage& storage, unsigned threads = 0);
+
+    /**
+     * @brief Adds all objects reachable from the roots to a set
+     *
+     * Objects already in the set are not walked again, so the walk can be
+     * repeated with new roots to extend an earlier result.
+     *
+     * @param commit_roots Commits to start from (e.g. HEAD)
+     * @param blob_roots Blobs that must be kept (e.g. staged files)
+     * @param reachable Set receiving the hashes of all reachable objects
+     * @param missing Vector receiving referenced commits and trees that could not be read
+     * @param check_blobs Also report blobs that do not exist (default false)
+     */
+    void mark(const std::vector<std::string>& commit_roots,
+              const std::vector<std::string>& blob_roots,
+              std::unordered_set<std::string>& reachable,
+              std::vector<std::string>& missing,
+              bool check_blobs = false);
+};
+
+} // namespace vcs
+
+#endif
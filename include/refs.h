@@ -0,0 +1,38 @@
+#ifndef REFS_H
+#define REFS_H
+
+#include <string>
+
+namespace vcs {
+
+/**
+ * @brief Reads and updates the HEAD reference
+ */
+class Refs {
+private:
+    std::string head_path;      ///< Path to the HEAD file
+
+public:
+    /**
+     * @brief Constructs Refs object and initializes the HEAD path
+     */
+    Refs();
+
+    /**
+     * @brief Reads the commit hash HEAD points to
+     * @param commit_hash Reference to string to receive the commit hash
+     * @return bool True if HEAD exists and holds a hash, false otherwise
+     */
+    bool readHead(std::string& commit_hash) const;
+
+    /**
+     * @brief Points HEAD at a commit
+     * @param commit_hash Hash of the new HEAD commit
+     * @return bool True if HEAD was written successfully, false otherwise
+     */
+    bool updateHead(const std::string& commit_hash);
+};
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef RENAME_DETECTOR_H
+#define RENAME_DETECTOR_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "diff.h"
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Settings for rename and copy detection
+ */
+struct RenameOptions {
+    double threshold = 0.5;             ///< Minimum similarity (0..1) of an inexact pair
+    bool find_copies = false;           ///< Also pair added files with deleted or modified sources
+    std::size_t max_candidates = 256;   ///< Sketch candidates scored per added file, most shared bands first
+    unsigned threads = 0;               ///< Worker thread count (0 selects hardware concurrency)
+};
+
+/**
+ * @brief Counters describing the work done by rename detection
+ */
+struct RenameStats {
+    std::size_t exact = 0;              ///< Renames and copies found by equal hashes
+    std::size_t inexact = 0;            ///< Renames and copies found by similarity
+    std::size_t blobs_sketched = 0;     ///< Blobs read and sketched
+    std::size_t pairs_scored = 0;       ///< Candidate pairs whose similarity was computed
+};
+
+/**
+ * @brief Chunk set and MinHash signature of a blob
+ *
+ * Content is cut into chunks at line ends (and at least every 64 bytes,
+ * so binary data chunks too). The similarity of two blobs is the Jaccard
+ * index of their chunk sets; the signature estimates it from a fixed
+ * number of minimum hashes, which lets similar blobs be found through
+ * hash buckets instead of comparing every pair.
+ */
+struct ContentSketch {
+    static const std::size_t SIGNATURE_SIZE = 64;   ///< Minimum hashes per signature
+
+    std::vector<std::uint64_t> chunks;      ///< Sorted, unique chunk hashes
+    std::vector<std::uint64_t> signature;   ///< MinHash signature (empty for empty content)
+
+    /**
+     * @brief Builds the sketch of some content
+     * @param content The content
+     * @return ContentSketch The sketch
+     */
+    static ContentSketch build(std::string_view content);
+
+    /**
+     * @brief Computes the exact Jaccard similarity of two chunk sets
+     * @param other The sketch to compare with
+     * @return double Similarity between 0 and 1
+     */
+    double similarity(const ContentSketch& other) const;
+};
+
+/**
+ * @brief Pairs added files with deleted (or, for copies, modified) files
+ *
+ * Equal blob hashes are paired first. The remaining files are sketched
+ * once each, bucketed by bands of their signatures, and only files that
+ * share a bucket are scored, so the cost grows with the number of files
+ * rather than with the number of pairs.
+ */
+class RenameDetector {
+private:
+    Storage& storage;           ///< Storage blobs are read from
+    RenameOptions options;      ///< Detection settings
+
+public:
+    /**
+     * @brief Constructs a RenameDetector
+     * @param storage Storage to read blobs from
+     * @param options Detection settings
+     */
+    RenameDetector(Storage& storage, const RenameOptions& options = RenameOptions());
+
+    /**
+     * @brief Replaces matching added and deleted files with renames and copies
+     * @param changes Changes from TreeDiff, rewritten in place (path order is kept)
+     * @param stats Reference to RenameStats to populate
+     * @return bool True if every blob could be read, false otherwise
+     */
+    bool detect(std::vector<FileChange>& changes, RenameStats& stats);
+};
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef REPACK_H
+#define REPACK_H
+
+#include <cstdint>
+#include <string>
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Summary of a repack run
+ */
+struct RepackStats {
+    std::size_t reachable = 0;      ///< Objects reachable from HEAD and the index
+    std::size_t packed = 0;         ///< Objects written to the new pack
+    std::uint64_t bytes = 0;        ///< Uncompressed size of the packed objects
+    std::size_t loose_removed = 0;  ///< Local loose objects deleted after packing
+    std::size_t packs_removed = 0;  ///< Local packs deleted because the shared store has all their objects
+};
+
+/**
+ * @brief Moves reachable loose objects into a pack
+ *
+ * By default the pack is written locally. In shared mode it goes to the
+ * first alternate instead, and local loose objects and whole local packs
+ * that the alternate now holds are deleted, so repositories sharing the
+ * alternate keep only the objects unique to them. Unreachable objects are
+ * left for gc.
+ */
+class Repacker {
+private:
+    Storage& storage;   ///< Storage to repack
+    unsigned threads;   ///< Worker thread count for marking (0 selects hardware concurrency)
+
+public:
+    /**
+     * @brief Constructs a repacker for the given storage
+     * @param storage Storage to repack
+     * @param threads Worker thread count for marking (0 selects hardware concurrency)
+     */
+    explicit Repacker(Storage& storage, unsigned threads = 0);
+
+    /**
+     * @brief Packs reachable objects and deletes the copies that became redundant
+     * @param shared Write the pack into the first alternate instead of locally
+     * @param stats Reference to RepackStats to populate
+     * @return bool True if the pack was written and cleanup succeeded, false otherwise
+     */
+    bool run(bool shared, RepackStats& stats);
+};
+
+} // namespace vcs
+
+#endif
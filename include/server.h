@@ -0,0 +1,59 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+namespace vcs {
+
+/**
+ * @brief Serves newline-delimited commands from a stream or a Unix socket
+ *
+ * Each request line is passed to a handler that writes its complete reply
+ * to an output stream. Keeping one process alive across requests avoids
+ * re-creating storage and re-reading the index for every command.
+ */
+class CommandServer {
+public:
+    /**
+     * @brief Handles one request line and writes the reply
+     * @return bool False to stop serving after this request, true to continue
+     */
+    using Handler = std::function<bool(const std::string& line, std::ostream& out)>;
+
+private:
+    Handler handler;    ///< Callback executing a single request
+
+    /**
+     * @brief Serves requests of one socket connection until it closes
+     * @param fd Connected socket descriptor
+     * @return bool False if the handler asked to stop the server, true otherwise
+     */
+    bool serveConnection(int fd);
+
+public:
+    /**
+     * @brief Constructs a CommandServer dispatching to a handler
+     * @param handler Callback executing a single request
+     */
+    explicit CommandServer(Handler handler);
+
+    /**
+     * @brief Serves requests from an input stream until end of input
+     * @param in Stream to read request lines from
+     * @param out Stream to write replies to (flushed after every reply)
+     */
+    void serveStream(std::istream& in, std::ostream& out);
+
+    /**
+     * @brief Listens on a Unix domain socket and serves connections one by one
+     * @param socket_path Filesystem path of the socket to create
+     * @return bool True if the server stopped on request, false on socket errors
+     */
+    bool serveSocket(const std::string& socket_path);
+};
+
+} // namespace vcs
+
+#endif
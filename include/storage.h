@@ -1,17 +1,44 @@
 #ifndef STORAGE_H
 #define STORAGE_H
 
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <vector>
 #include "object.h"
+#include "object_index.h"
 
 namespace vcs {
 
+/**
+ * @brief Snapshot of object lookup counters for tracing and benchmarks
+ */
+struct StorageCounters {
+    std::uint64_t lookups = 0;          ///< Calls to objectExists
+    std::uint64_t bloom_negatives = 0;  ///< Misses answered in memory by the bloom filter
+    std::uint64_t disk_probes = 0;      ///< Lookups that had to check the object file
+    std::uint64_t false_positives = 0;  ///< Disk probes that found no object
+    std::uint64_t index_scans = 0;      ///< Full scans of the object directory
+};
+
 /**
  * @brief Handles storage and retrieval of VCS objects from disk
+ *
+ * Object directories listed in objects/info/alternates are searched after
+ * the local one and never written to, so many repositories can share one
+ * store. Alternates of alternates are not followed.
  */
 class Storage {
 private:
     std::string objects_path;    ///< Path to the objects directory
+    mutable ObjectIndex object_index;   ///< Bloom-filtered index of stored objects
+    std::vector<std::unique_ptr<Storage>> alternates;   ///< Read-only stores searched after this one
+    mutable std::atomic<std::uint64_t> lookups{0};          ///< Calls to objectExists
+    mutable std::atomic<std::uint64_t> bloom_negatives{0};  ///< Misses answered by the filter
+    mutable std::atomic<std::uint64_t> disk_probes{0};      ///< Lookups that checked the disk
+    mutable std::atomic<std::uint64_t> false_positives{0};  ///< Disk probes that found nothing
     
     /**
      * @brief Generates full file path for an object based on its hash
@@ -20,12 +47,38 @@ private:
      */
     std::string getObjectPath(const std::string& hash) const;
     
+    /**
+     * @brief Writes serialized object data unless the object already exists
+     * @param hash The object's hash
+     * @param data The serialized object data
+     * @return bool True if the object is stored, false otherwise
+     */
+    bool writeObject(const std::string& hash, const std::string& data);
+    
+    /**
+     * @brief Opens the alternate object directories listed in the alternates file
+     */
+    void loadAlternates();
+    
+    /**
+     * @brief Checks whether a directory is this objects directory or one of the alternates
+     * @param path Path to an objects directory
+     * @return bool True if it is already searched, false otherwise
+     */
+    bool isKnownObjectsDir(const std::filesystem::path& path) const;
+    
 public:
     /**
      * @brief Constructs Storage object and initializes objects path
      */
     Storage();
     
+    /**
+     * @brief Constructs Storage for another object directory, without following its alternates
+     * @param objects_path Path to the object directory
+     */
+    explicit Storage(const std::string& objects_path);
+    
     /**
      * @brief Initializes the storage system by creating necessary directories
      * @return bool True if initialization successful, false otherwise
@@ -42,14 +95,14 @@ public:
     /**
      * @brief Stores a Tree object to disk
      * @param tree The Tree object to store
-     * @return bool True if storage successful, false otherwise
+     * @return bool True if storage successful, false if it failed or the tree is malformed
      */
     bool storeTree(const Tree& tree);
     
     /**
      * @brief Stores a Commit object to disk
      * @param commit The Commit object to store
-     * @return bool True if storage successful, false otherwise
+     * @return bool True if storage successful, false if it failed or the commit is malformed
      */
     bool storeCommit(const Commit& commit);
     
@@ -57,7 +110,7 @@ public:
      * @brief Reads a Blob object from disk by its hash
      * @param hash The hash of the Blob to read
      * @param blob Reference to Blob object to populate with data
-     * @return bool True if read successful, false otherwise
+     * @return bool True if read successful and the content matches the hash, false otherwise
      */
     bool readBlob(const std::string& hash, Blob& blob);
     
@@ -80,9 +133,106 @@ public:
     /**
      * @brief Checks if an object exists in storage by its hash
      * @param hash The hash to check
-     * @return bool True if object exists, false otherwise
+     * @return bool True if object exists here or in an alternate, false otherwise
      */
     bool objectExists(const std::string& hash) const;
+    
+    /**
+     * @brief Checks if an object is stored in one of the local pack files
+     * @param hash The hash to check
+     * @return bool True if a local pack contains the object, false otherwise
+     */
+    bool hasPacked(const std::string& hash) const;
+    
+    /**
+     * @brief Adds an object directory to the alternates file and opens it
+     * @param path Path to the other repository's objects directory
+     * @return bool True if the directory is recorded (now or before), false if it is missing or is this store
+     */
+    bool addAlternate(const std::string& path);
+    
+    /**
+     * @brief Gets the alternate stores in the order they are searched
+     * @return const std::vector<std::unique_ptr<Storage>>& The alternates
+     */
+    const std::vector<std::unique_ptr<Storage>>& getAlternates() const;
+    
+    /**
+     * @brief Gets the path of the objects directory
+     * @return std::string Path to the objects directory
+     */
+    std::string getObjectsPath() const;
+    
+    /**
+     * @brief Gets a snapshot of the object lookup counters
+     * @return StorageCounters Current counter values
+     */
+    StorageCounters getCounters() const;
+    
+    /**
+     * @brief Reads the raw serialized data of an object, falling back to the alternates
+     * @param hash The object's hash
+     * @param data Reference to string to receive the object data
+     * @return bool True if read successful, false otherwise
+     */
+    bool readObject(const std::string& hash, std::string& data) const;
+    
+    /**
+     * @brief Rescans the object directories if another process changed them
+     *
+     * Long-running processes call this between requests so that the
+     * in-memory object index does not miss objects stored elsewhere.
+     * Alternates are rescanned as well.
+     */
+    void refresh();
+    
+    /**
+     * @brief Lists the hashes of all loose objects in the local object directory
+     * @return std::vector<std::string> Hashes of stored objects
+     */
+    std::vector<std::string> listObjects() const;
+    
+    /**
+     * @brief Lists the hashes of all objects stored in local pack files
+     * @return std::vector<std::string> Hashes of packed objects
+     */
+    std::vector<std::string> listPackedObjects() const;
+    
+    /**
+     * @brief Gets the directory holding pack files
+     * @return std::string Path to the pack directory
+     */
+    std::string getPackPath() const;
+    
+    /**
+     * @brief Gets size and modification time of a loose object
+     * @param hash The object's hash
+     * @param size Reference to receive the object size in bytes
+     * @param mtime Reference to receive the modification time (seconds since epoch)
+     * @return bool True if the object exists, false otherwise
+     */
+    bool statObject(const std::string& hash, std::uint64_t& size, std::int64_t& mtime) const;
+    
+    /**
+     * @brief Deletes a loose object
+     * @param hash The object's hash
+     * @return bool True if the object was removed, false otherwise
+     */
+    bool removeObject(const std::string& hash);
+    
+    /**
+     * @brief Deletes a loose object unless it was stored or re-added after a cutoff
+     *
+     * The object is first renamed aside and its mtime checked on the renamed
+     * file, so a concurrent store either refreshed it before the check (and it
+     * is put back) or finds it gone and writes it again.
+     *
+     * @param hash The object's hash
+     * @param cutoff Keep the object if its mtime is later than this (seconds since epoch)
+     * @param removed Reference set to true if the object was deleted
+     * @return bool True unless the object could not be renamed or removed
+     */
+    bool removeObjectIfOlder(const std::string& hash, std::int64_t cutoff, bool& removed);
 };
 
 } // namespace vcs
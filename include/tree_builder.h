@@ -0,0 +1,95 @@
+#ifndef TREE_BUILDER_H
+#define TREE_BUILDER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include "object.h"
+#include "storage.h"
+
+namespace vcs {
+
+/**
+ * @brief Builds a hierarchy of Tree objects from a flat list of file paths
+ *
+ * Paths are split on '/' and every directory becomes its own Tree, so
+ * unchanged directories keep the same hash from one commit to the next.
+ * A builder seeded with an existing tree only reads the directories that
+ * files are added to; untouched subtrees are reused by hash.
+ */
+class TreeBuilder {
+private:
+    /**
+     * @brief A directory being assembled in memory
+     */
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>> directories;  ///< Subdirectories by name
+        std::map<std::string, TreeEntry> files;                    ///< File entries by name
+        std::string hash;       ///< Stored tree hash while the directory is unchanged
+        bool loaded = true;     ///< False until the entries of the stored tree are read
+    };
+
+    Storage& storage;   ///< Storage the finished trees are written to
+    Node root;          ///< Root directory of the tree being built
+
+    /**
+     * @brief Reads the entries of a seeded directory that has not been loaded yet
+     * @param node The directory to load
+     * @return bool True if the directory is loaded, false if its tree cannot be read
+     */
+    bool load(Node& node);
+
+    /**
+     * @brief Stores a directory and all of its subdirectories bottom-up
+     * @param node The directory to store
+     * @param hash Reference to string to receive the stored tree hash
+     * @return bool True if all trees were stored, false otherwise
+     */
+    bool writeNode(const Node& node, std::string& hash);
+
+public:
+    /**
+     * @brief Constructs a TreeBuilder writing to the given storage
+     * @param storage Storage to write Tree objects to
+     */
+    explicit TreeBuilder(Storage& storage);
+
+    /**
+     * @brief Starts from the contents of an existing tree
+     * @param tree_hash Hash of the tree to start from
+     * @return bool True if the tree could be read, false otherwise
+     */
+    bool addTree(const std::string& tree_hash);
+
+    /**
+     * @brief Checks whether a path can name a file in a tree
+     *
+     * Empty and "." directory components are ignored. A ".." component
+     * would let checkout write outside the working tree, so it is refused.
+     *
+     * @param path Slash-separated path of the file relative to the root
+     * @return bool True if no component is ".." and the file name is not empty or ".", false otherwise
+     */
+    static bool isValidPath(const std::string& path);
+
+    /**
+     * @brief Adds a file to the tree being built, replacing any entry at that path
+     * @param path Slash-separated path of the file relative to the root
+     * @param blob_hash Hash of the file's blob content
+     * @param mode File permissions mode (default "100644")
+     * @return bool True if the file was added, false if the path is invalid or a seeded tree cannot be read
+     */
+    bool addFile(const std::string& path, const std::string& blob_hash,
+                 const std::string& mode = "100644");
+
+    /**
+     * @brief Stores all trees and returns the hash of the root tree
+     * @param root_hash Reference to string to receive the root tree hash
+     * @return bool True if all trees were stored, false otherwise
+     */
+    bool write(std::string& root_hash);
+};
+
+} // namespace vcs
+
+#endif
@@ -0,0 +1,124 @@
+#include "bloom.h"
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+namespace vcs {
+
+/**
+ * @brief Constructs a bloom filter sized for an expected number of keys
+ * @param expected_keys Number of keys the filter is sized for
+ * @param bits_per_key Bits reserved per key (10 gives about 1% false positives)
+ */
+BloomFilter::BloomFilter(std::size_t expected_keys, unsigned bits_per_key) {
+    std::size_t bit_count = expected_keys * bits_per_key;
+    if (bit_count < 64) bit_count = 64;
+    bits.assign((bit_count + 63) / 64, 0);
+    // k = bits_per_key * ln(2) minimises the false positive rate
+    hash_count = static_cast<unsigned>(bits_per_key * 0.69);
+    if (hash_count < 1) hash_count = 1;
+    if (hash_count > 30) hash_count = 30;
+}
+
+/**
+ * @brief Computes the two base hashes used for double hashing
+ * @param key The key to hash
+ * @param h1 Reference to receive the first hash
+ * @param h2 Reference to receive the second (odd) hash
+ */
+void BloomFilter::baseHashes(const std::string& key, std::uint64_t& h1, std::uint64_t& h2) {
+    h1 = std::hash<std::string>{}(key);
+    // splitmix64 finaliser derives an independent second hash
+    std::uint64_t z = h1 + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    h2 = (z ^ (z >> 31)) | 1;
+}
+
+/**
+ * @brief Adds a key to the filter
+ * @param key The key to add
+ */
+void BloomFilter::add(const std::string& key) {
+    std::uint64_t h1, h2;
+    baseHashes(key, h1, h2);
+    std::uint64_t total = bits.size() * 64;
+    for (unsigned i = 0; i < hash_count; i++) {
+        std::uint64_t bit = (h1 + i * h2) % total;
+        bits[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+/**
+ * @brief Checks whether a key may be present
+ * @param key The key to check
+ * @return bool False if the key is definitely absent, true if it may be present
+ */
+bool BloomFilter::mightContain(const std::string& key) const {
+    std::uint64_t h1, h2;
+    baseHashes(key, h1, h2);
+    std::uint64_t total = bits.size() * 64;
+    for (unsigned i = 0; i < hash_count; i++) {
+        std::uint64_t bit = (h1 + i * h2) % total;
+        if (!(bits[bit / 64] & (1ULL << (bit % 64)))) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the size of the bit array
+ * @return std::size_t Number of bits in the filter
+ */
+std::size_t BloomFilter::bitCount() const {
+    return bits.size() * 64;
+}
+
+/**
+ * @brief Serializes the filter to a single-line text form
+ * @return std::string Probe count and bit array as "<k>:<hex words>"
+ */
+std::string BloomFilter::serialize() const {
+    std::stringstream ss;
+    ss << hash_count << ":" << std::hex << std::setfill('0');
+    for (std::uint64_t word : bits) {
+        ss << std::setw(16) << word;
+    }
+    return ss.str();
+}
+
+/**
+ * @brief Restores a filter from the form produced by serialize()
+ * @param data Serialized filter
+ * @return bool True if the data was well-formed, false otherwise
+ */
+bool BloomFilter::deserialize(const std::string& data) {
+    std::size_t colon = data.find(':');
+    if (colon == std::string::npos || colon == 0) return false;
+    std::size_t hex_length = data.size() - colon - 1;
+    if (hex_length == 0 || hex_length % 16 != 0) return false;
+
+    unsigned probes = 0;
+    for (std::size_t i = 0; i < colon; i++) {
+        if (data[i] < '0' || data[i] > '9') return false;
+        probes = probes * 10 + (data[i] - '0');
+    }
+    if (probes < 1 || probes > 30) return false;
+
+    std::vector<std::uint64_t> words(hex_length / 16);
+    for (std::size_t w = 0; w < words.size(); w++) {
+        std::uint64_t word = 0;
+        for (std::size_t i = 0; i < 16; i++) {
+            char c = data[colon + 1 + w * 16 + i];
+            word <<= 4;
+            if (c >= '0' && c <= '9') word |= c - '0';
+            else if (c >= 'a' && c <= 'f') word |= c - 'a' + 10;
+            else return false;
+        }
+        words[w] = word;
+    }
+    bits.swap(words);
+    hash_count = probes;
+    return true;
+}
+
+} // namespace vcs
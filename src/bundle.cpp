@@ -0,0 +1,280 @@
+#include "bundle.h"
+#include "constants.h"
+#include "object.h"
+#include "object_index.h"
+#include "pack.h"
+#include "reachability.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <unordered_set>
+#include <zlib.h>
+
+namespace vcs {
+
+/**
+ * @brief First line of every bundle file
+ */
+static const char BUNDLE_SIGNATURE[] = "# myvcs bundle v1";
+
+/**
+ * @brief Size of the steps in which object data is read and the buffer grown
+ */
+static const std::uint64_t READ_CHUNK_SIZE = 1 << 20;
+
+/**
+ * @brief Writes a whole buffer to a gzip stream
+ * @param file The gzip stream
+ * @param data Bytes to write
+ * @return bool True if every byte was written, false otherwise
+ */
+static bool writeAll(gzFile file, const std::string& data) {
+    if (data.empty()) return true;
+    return gzwrite(file, data.data(), static_cast<unsigned>(data.size())) ==
+           static_cast<int>(data.size());
+}
+
+/**
+ * @brief Reads exactly the requested number of bytes from a gzip stream
+ *
+ * The buffer grows as data arrives, so a length field claiming more data
+ * than the stream holds fails at the end of the stream instead of
+ * allocating the claimed size up front.
+ *
+ * @param file The gzip stream
+ * @param data Reference to string to receive the bytes
+ * @param size Number of bytes to read (at most MAX_OBJECT_SIZE)
+ * @return bool True if all bytes were read, false otherwise
+ */
+static bool readExact(gzFile file, std::string& data, std::uint64_t size) {
+    if (size > MAX_OBJECT_SIZE) return false;
+    data.clear();
+    while (data.size() < size) {
+        std::size_t done = data.size();
+        std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(size - done, READ_CHUNK_SIZE));
+        data.resize(done + chunk);
+        int got = gzread(file, &data[done], static_cast<unsigned>(chunk));
+        if (got <= 0) return false;
+        data.resize(done + static_cast<std::size_t>(got));
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a non-negative decimal number that must fill the whole string
+ * @param text The text to parse
+ * @param value Reference to receive the number
+ * @return bool True if the text is a number in range, false otherwise
+ */
+static bool parseCount(const std::string& text, std::uint64_t& value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    errno = 0;
+    char* end = nullptr;
+    value = std::strtoull(text.c_str(), &end, 10);
+    return errno == 0 && end == text.c_str() + text.size();
+}
+
+/**
+ * @brief Reads one header line (without the trailing newline) from a gzip stream
+ * @param file The gzip stream
+ * @param line Reference to string to receive the line
+ * @return bool True if a complete line was read, false otherwise
+ */
+static bool readLine(gzFile file, std::string& line) {
+    char buffer[256];
+    if (gzgets(file, buffer, sizeof(buffer)) == nullptr) return false;
+    line = buffer;
+    if (line.empty() || line.back() != '\n') return false;
+    line.pop_back();
+    return true;
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint from a gzip stream
+ * @param file The gzip stream
+ * @param value Reference to receive the value
+ * @return bool True if a complete varint was read, false otherwise
+ */
+static bool readVarint(gzFile file, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = gzgetc(file);
+        if (byte == -1) return false;
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Constructs a Bundle working on the given storage
+ * @param storage Storage to read from and write to
+ */
+Bundle::Bundle(Storage& storage) : storage(storage) {}
+
+/**
+ * @brief Writes a bundle with everything the receiver lacks
+ * @param file_path Path of the bundle file to create
+ * @param tips Commits the receiver should end up with
+ * @param haves Commits the receiver already has
+ * @param stats Reference to BundleStats to populate
+ * @return bool True if the bundle was written, false if objects were missing or on I/O errors
+ */
+bool Bundle::create(const std::string& file_path, const std::vector<std::string>& tips,
+                    const std::vector<std::string>& haves, BundleStats& stats) {
+    stats = BundleStats();
+    ReachabilityWalker walker(storage);
+
+    // Haves unknown here cannot be excluded; they are simply not walked
+    std::unordered_set<std::string> excluded;
+    std::vector<std::string> unknown;
+    walker.mark(haves, {}, excluded, unknown);
+
+    std::unordered_set<std::string> reachable = excluded;
+    std::vector<std::string> missing;
+    walker.mark(tips, {}, reachable, missing, true);
+    if (!missing.empty()) return false;
+
+    std::vector<std::string> objects;
+    objects.reserve(reachable.size() - excluded.size());
+    for (const auto& hash : reachable) {
+        if (!excluded.count(hash)) objects.push_back(hash);
+    }
+
+    std::string header = std::string(BUNDLE_SIGNATURE) + "\n";
+    for (const auto& have : haves) header += "-" + have + "\n";
+    for (const auto& tip : tips) header += tip + "\n";
+    header += "objects " + std::to_string(objects.size()) + "\n\n";
+
+    gzFile file = gzopen(file_path.c_str(), "wb6");
+    if (file == nullptr) return false;
+    bool ok = writeAll(file, header);
+
+    std::string data, record;
+    for (std::size_t i = 0; ok && i < objects.size(); i++) {
+        std::string raw;
+        if (!storage.readObject(objects[i], data) || !hexToRaw(objects[i], raw)) {
+            ok = false;
+            break;
+        }
+        // Record: raw hash, varint length, data
+        record = raw;
+        std::uint64_t length = data.size();
+        while (length >= 0x80) {
+            record.push_back(static_cast<char>((length & 0x7f) | 0x80));
+            length >>= 7;
+        }
+        record.push_back(static_cast<char>(length));
+        ok = writeAll(file, record) && writeAll(file, data);
+        if (!ok) break;
+        stats.objects++;
+        stats.bytes += data.size();
+    }
+
+    if (gzclose(file) != Z_OK) ok = false;
+    if (!ok) std::remove(file_path.c_str());
+    return ok;
+}
+
+/**
+ * @brief Ingests a bundle into a new pack
+ *
+ * Fails, and removes the new pack again, unless every object reachable
+ * from the tips is present afterwards.
+ *
+ * @param file_path Path of the bundle file to read
+ * @param tips Vector receiving the tips recorded in the bundle
+ * @param missing Vector receiving prerequisites this repository lacks
+ * @param incomplete Vector receiving objects the tips need that neither the bundle nor this repository has
+ * @param stats Reference to BundleStats to populate
+ * @return bool True if all objects were ingested and the tips are complete, false otherwise
+ */
+bool Bundle::unbundle(const std::string& file_path, std::vector<std::string>& tips,
+                      std::vector<std::string>& missing, std::vector<std::string>& incomplete,
+                      BundleStats& stats) {
+    stats = BundleStats();
+    gzFile file = gzopen(file_path.c_str(), "rb");
+    if (file == nullptr) return false;
+    gzbuffer(file, 1 << 17);
+
+    std::string line, header;
+    std::uint64_t count = 0;
+    bool ok = readLine(file, line) && line == BUNDLE_SIGNATURE;
+    // The header is untrusted: every line must be a prerequisite, a tip or the count
+    while (ok && readLine(file, line) && !line.empty()) {
+        header += line + "\n";
+        if (line[0] == '-') {
+            std::string have = line.substr(1);
+            ok = isObjectName(have);
+            if (ok && !storage.objectExists(have)) missing.push_back(have);
+        } else if (line.compare(0, 8, "objects ") == 0) {
+            ok = parseCount(line.substr(8), count);
+        } else {
+            ok = isObjectName(line);
+            tips.push_back(line);
+        }
+    }
+    if (!ok || !line.empty() || !missing.empty()) {
+        gzclose(file);
+        return false;
+    }
+
+    // The pack is named after the bundle header, so the same bundle always yields the same name
+    PackWriter writer;
+    std::string pack_name = calculateSimpleHash(header);
+    if (!writer.open(storage.getPackPath(), pack_name)) {
+        gzclose(file);
+        return false;
+    }
+
+    std::string raw, data;
+    std::unordered_set<std::string> seen;
+    for (std::uint64_t i = 0; ok && i < count; i++) {
+        std::uint64_t length;
+        ok = readExact(file, raw, RAW_HASH_SIZE) && readVarint(file, length) &&
+             readExact(file, data, length);
+        if (!ok) break;
+
+        std::string hash = rawToHex(raw);
+        // Objects are checked like fsck does before anything trusts them
+        if (detectObjectType(hash, data).empty()) {
+            ok = false;
+            break;
+        }
+        // A record repeated in the bundle is packed once
+        if (!seen.insert(hash).second || storage.objectExists(hash)) {
+            stats.skipped++;
+            continue;
+        }
+        ok = writer.add(hash, data);
+        if (!ok) break;
+        stats.objects++;
+        stats.bytes += data.size();
+    }
+    gzclose(file);
+
+    if (!ok) {
+        writer.abort();
+        return false;
+    }
+    if (!writer.finish()) return false;
+    storage.refresh();
+
+    // The bundle is only accepted if its tips are complete: every tree and
+    // blob they reference must now be here, from the bundle or from before
+    std::unordered_set<std::string> reachable;
+    ReachabilityWalker walker(storage);
+    walker.mark(tips, {}, reachable, incomplete, true);
+    if (incomplete.empty()) return true;
+    if (stats.objects > 0) {
+        // The index goes first so no reader sees an index without its pack
+        std::string base = storage.getPackPath() + "/pack-" + pack_name;
+        std::remove((base + ".idx").c_str());
+        std::remove((base + ".pack").c_str());
+        storage.refresh();
+    }
+    return false;
+}
+
+} // namespace vcs
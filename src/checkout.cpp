@@ -0,0 +1,127 @@
+#include "checkout.h"
+#include "constants.h"
+#include "parallel.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sys/stat.h>
+
+namespace vcs {
+
+/**
+ * @brief Constructs a Checkout working on the given storage and index
+ * @param storage Storage to read objects from
+ * @param index Index to record restored files in
+ * @param threads Worker thread count (0 selects hardware concurrency)
+ */
+Checkout::Checkout(Storage& storage, Index& index, unsigned threads)
+    : storage(storage), index(index), threads(threads) {}
+
+/**
+ * @brief Checks that a tree entry name is a single safe path component
+ * @param name The entry name
+ * @return bool True unless the name is empty, "." or "..", or contains '/', '\\' or NUL
+ */
+static bool isSafeName(const std::string& name) {
+    return !name.empty() && name != "." && name != ".." &&
+           name.find_first_of(std::string("/\\\0", 3)) == std::string::npos;
+}
+
+/**
+ * @brief Recursively collects files and directories of a tree
+ * @param tree_hash Hash of the tree to walk
+ * @param prefix Path of the tree relative to the checkout root
+ * @param jobs Vector receiving the files to restore
+ * @param directories Vector receiving the directories to create
+ * @return bool True if every tree could be read and every name is safe, false otherwise
+ */
+bool Checkout::collect(const std::string& tree_hash, const std::string& prefix,
+                       std::vector<FileJob>& jobs, std::vector<std::string>& directories) {
+    Tree tree;
+    if (!storage.readTree(tree_hash, tree)) return false;
+
+    for (const auto& entry : tree.entries) {
+        // A crafted tree must not write outside the checkout root
+        if (!isSafeName(entry.name)) return false;
+        std::string path = prefix.empty() ? entry.name : prefix + "/" + entry.name;
+        if (entry.type == types::TREE) {
+            directories.push_back(path);
+            if (!collect(entry.hash, path, jobs, directories)) return false;
+        } else {
+            jobs.push_back({path, entry.hash, entry.mode});
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Restores all files of a tree below a target directory
+ * @param tree_hash Hash of the root tree to restore
+ * @param target_root Directory to restore into ("." for the working directory)
+ * @param stats Reference to CheckoutStats to populate with results
+ * @return bool True if every file was restored, false otherwise
+ */
+bool Checkout::run(const std::string& tree_hash, const std::string& target_root,
+                   CheckoutStats& stats) {
+    std::vector<FileJob> jobs;
+    std::vector<std::string> directories;
+    if (!collect(tree_hash, "", jobs, directories)) return false;
+
+    // Directories are created serially before the workers start, so no
+    // worker ever races another one on create_directories()
+    std::error_code ec;
+    std::filesystem::create_directories(target_root, ec);
+    for (const auto& dir : directories) {
+        std::filesystem::create_directories(target_root + "/" + dir, ec);
+        if (ec) return false;
+    }
+    stats.directories_created = directories.size();
+
+    std::vector<IndexEntry> entries(jobs.size());
+    std::vector<char> written(jobs.size(), 0);
+    std::atomic<std::uint64_t> bytes(0);
+
+    parallelFor(jobs.size(), [&](std::size_t i) {
+        const FileJob& job = jobs[i];
+        Blob blob("");
+        if (!storage.readBlob(job.hash, blob)) return;
+
+        std::string full_path = target_root + "/" + job.path;
+        {
+            std::ofstream file(full_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return;
+            file.write(blob.content.data(), blob.content.size());
+            if (!file.good()) return;
+        }
+        if (job.mode == "100755") {
+            chmod(full_path.c_str(), 0755);
+        }
+
+        struct stat st;
+        IndexEntry entry(job.path, job.hash);
+        entry.staged = false;
+        if (stat(full_path.c_str(), &st) == 0) {
+            entry.file_size = static_cast<std::uint64_t>(st.st_size);
+            entry.mtime = static_cast<std::uint64_t>(st.st_mtime);
+        }
+        entries[i] = entry;
+        written[i] = 1;
+        bytes += blob.content.size();
+    }, threads);
+
+    // One index write for the whole checkout instead of one per file; the
+    // entries only carry stat data, so nothing is staged for the next commit
+    std::vector<IndexEntry> batch;
+    batch.reserve(jobs.size());
+    for (std::size_t i = 0; i < jobs.size(); i++) {
+        if (written[i]) batch.push_back(entries[i]);
+    }
+    stats.files_written = batch.size();
+    stats.failures = jobs.size() - batch.size();
+    stats.bytes_written = bytes.load();
+
+    if (!index.addFiles(batch)) return false;
+    return stats.failures == 0;
+}
+
+} // namespace vcs
@@ -0,0 +1,194 @@
+#include "commit_graph.h"
+#include "constants.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace vcs {
+
+/**
+ * @brief Strips "./" prefixes and trailing slashes from a path
+ * @param path The path to normalize
+ * @return std::string Normalized path
+ */
+static std::string normalizePath(const std::string& path) {
+    std::string result = path;
+    while (result.compare(0, 2, "./") == 0) result.erase(0, 2);
+    while (!result.empty() && result.back() == '/') result.pop_back();
+    return result;
+}
+
+/**
+ * @brief Constructs a CommitGraph for the repository's commit-graph file
+ */
+CommitGraph::CommitGraph() : graph_path(std::string(VCS_DIR) + "/" + COMMIT_GRAPH_FILE) {}
+
+/**
+ * @brief Constructs a CommitGraph backed by a specific file
+ * @param path Path to the commit-graph file
+ */
+CommitGraph::CommitGraph(const std::string& path) : graph_path(path) {}
+
+/**
+ * @brief Loads all entries from disk
+ * @return bool True if the file was read, false if it does not exist
+ */
+bool CommitGraph::load() {
+    std::ifstream file(graph_path);
+    if (!file.is_open()) return false;
+
+    // Format: "<commit> <tree> <parent,parent|-> <filter|->"
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string commit_hash, tree_hash, parents, filter;
+        if (!(iss >> commit_hash >> tree_hash >> parents >> filter)) continue;
+
+        CommitGraphEntry entry;
+        entry.tree_hash = tree_hash;
+        if (parents != "-") {
+            std::istringstream list(parents);
+            std::string parent;
+            while (std::getline(list, parent, ',')) {
+                entry.parent_hashes.push_back(parent);
+            }
+        }
+        entry.has_changed_paths = filter != "-" && entry.changed_paths.deserialize(filter);
+        entries[commit_hash] = entry;
+    }
+    computeGenerations();
+    return true;
+}
+
+/**
+ * @brief Numbers every entry whose ancestors are all in the graph, parents first
+ */
+void CommitGraph::computeGenerations() {
+    // 1 while a commit waits for its parents, 2 once it is numbered
+    std::unordered_map<std::string, int> state;
+    for (const auto& pair : entries) {
+        std::vector<std::string> stack = {pair.first};
+        while (!stack.empty()) {
+            std::string hash = stack.back();
+            int& current = state[hash];
+            if (current == 2) {
+                stack.pop_back();
+                continue;
+            }
+            current = 1;
+            CommitGraphEntry& entry = entries[hash];
+            bool ready = true;
+            for (const auto& parent : entry.parent_hashes) {
+                if (entries.count(parent) && !state.count(parent)) {
+                    stack.push_back(parent);
+                    ready = false;
+                }
+            }
+            if (!ready) continue;
+
+            // A parent outside the graph, or one still waiting (a corrupt cycle), leaves it unnumbered
+            entry.generation = 1;
+            for (const auto& parent : entry.parent_hashes) {
+                auto it = entries.find(parent);
+                if (it == entries.end() || state[parent] != 2 || it->second.generation == 0) {
+                    entry.generation = 0;
+                    break;
+                }
+                entry.generation = std::max(entry.generation, it->second.generation + 1);
+            }
+            state[hash] = 2;
+            stack.pop_back();
+        }
+    }
+}
+
+/**
+ * @brief Adds an entry and appends it to the file on disk
+ * @param commit_hash Hash of the commit
+ * @param entry Graph entry of the commit
+ * @return bool True if the entry was written successfully, false otherwise
+ */
+bool CommitGraph::append(const std::string& commit_hash, const CommitGraphEntry& entry) {
+    std::ofstream file(graph_path, std::ios::app);
+    if (!file.is_open()) return false;
+
+    std::string parents;
+    for (const auto& parent : entry.parent_hashes) {
+        if (!parents.empty()) parents += ",";
+        parents += parent;
+    }
+    file << commit_hash << " " << entry.tree_hash << " "
+         << (parents.empty() ? "-" : parents) << " "
+         << (entry.has_changed_paths ? entry.changed_paths.serialize() : "-") << "\n";
+    if (!file.good()) return false;
+
+    CommitGraphEntry& added = entries[commit_hash];
+    added = entry;
+    added.generation = 1;
+    for (const auto& parent : entry.parent_hashes) {
+        auto it = entries.find(parent);
+        if (it == entries.end() || it->second.generation == 0) {
+            added.generation = 0;
+            break;
+        }
+        added.generation = std::max(added.generation, it->second.generation + 1);
+    }
+    return true;
+}
+
+/**
+ * @brief Looks up the entry of a commit
+ * @param commit_hash Hash of the commit
+ * @return const CommitGraphEntry* The entry, or nullptr if the commit is not in the graph
+ */
+const CommitGraphEntry* CommitGraph::find(const std::string& commit_hash) const {
+    auto it = entries.find(commit_hash);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+/**
+ * @brief Builds the graph entry of a commit from its diff against the first parent
+ * @param commit The commit
+ * @param changes Files changed against the first parent
+ * @return CommitGraphEntry Entry with the changed-path filter filled in
+ */
+CommitGraphEntry CommitGraph::makeEntry(const Commit& commit,
+                                        const std::vector<FileChange>& changes) {
+    CommitGraphEntry entry;
+    entry.tree_hash = commit.tree_hash;
+    entry.parent_hashes = commit.parent_hashes;
+    if (changes.size() > MAX_CHANGED_PATHS) return entry;
+
+    // Every changed file and all of its parent directories go into the filter,
+    // so a query for a directory is answered like a query for a file
+    std::vector<std::string> keys;
+    for (const auto& change : changes) {
+        std::size_t slash = 0;
+        while ((slash = change.path.find('/', slash)) != std::string::npos) {
+            keys.push_back(change.path.substr(0, slash));
+            slash++;
+        }
+        keys.push_back(change.path);
+    }
+
+    entry.changed_paths = BloomFilter(keys.size());
+    for (const auto& key : keys) {
+        entry.changed_paths.add(key);
+    }
+    entry.has_changed_paths = true;
+    return entry;
+}
+
+/**
+ * @brief Checks whether a commit may have changed a file or directory
+ * @param entry Graph entry of the commit
+ * @param path Slash-separated path of a file or directory
+ * @return bool False if the commit definitely did not change the path
+ */
+bool CommitGraph::mayHaveChanged(const CommitGraphEntry& entry, const std::string& path) {
+    if (!entry.has_changed_paths) return true;
+    std::string key = normalizePath(path);
+    return key.empty() || entry.changed_paths.mightContain(key);
+}
+
+} // namespace vcs
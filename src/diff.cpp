@@ -0,0 +1,119 @@
+#include "diff.h"
+#include "constants.h"
+#include <map>
+
+namespace vcs {
+
+/**
+ * @brief Constructs a TreeDiff reading from the given storage
+ * @param storage Storage to read Tree objects from
+ */
+TreeDiff::TreeDiff(Storage& storage) : storage(storage) {}
+
+/**
+ * @brief Reports every file below a tree as added or deleted
+ * @param tree_hash Hash of the tree to walk
+ * @param prefix Path of the tree relative to the root
+ * @param kind Kind of change to report (Added or Deleted)
+ * @param changes Vector receiving the changes
+ * @return bool True if every tree could be read, false otherwise
+ */
+bool TreeDiff::addAll(const std::string& tree_hash, const std::string& prefix,
+                      FileChange::Kind kind, std::vector<FileChange>& changes) {
+    Tree tree;
+    if (!storage.readTree(tree_hash, tree)) return false;
+
+    for (const auto& entry : tree.entries) {
+        std::string path = prefix.empty() ? entry.name : prefix + "/" + entry.name;
+        if (entry.type == types::TREE) {
+            if (!addAll(entry.hash, path, kind, changes)) return false;
+            continue;
+        }
+        FileChange change;
+        change.kind = kind;
+        change.path = path;
+        if (kind == FileChange::Kind::Added) {
+            change.new_hash = entry.hash;
+        } else {
+            change.old_hash = entry.hash;
+        }
+        changes.push_back(change);
+    }
+    return true;
+}
+
+/**
+ * @brief Recursively compares two trees
+ * @param old_hash Hash of the old tree
+ * @param new_hash Hash of the new tree
+ * @param prefix Path of the trees relative to the root
+ * @param changes Vector receiving the changes
+ * @return bool True if every tree could be read, false otherwise
+ */
+bool TreeDiff::diffTrees(const std::string& old_hash, const std::string& new_hash,
+                         const std::string& prefix, std::vector<FileChange>& changes) {
+    if (old_hash == new_hash) return true;
+
+    Tree old_tree, new_tree;
+    if (!storage.readTree(old_hash, old_tree) || !storage.readTree(new_hash, new_tree)) {
+        return false;
+    }
+
+    // Pair entries by name; a name may switch between file and directory
+    std::map<std::string, std::pair<const TreeEntry*, const TreeEntry*>> names;
+    for (const auto& entry : old_tree.entries) names[entry.name].first = &entry;
+    for (const auto& entry : new_tree.entries) names[entry.name].second = &entry;
+
+    for (const auto& pair : names) {
+        const TreeEntry* before = pair.second.first;
+        const TreeEntry* after = pair.second.second;
+        std::string path = prefix.empty() ? pair.first : prefix + "/" + pair.first;
+
+        if (before && after && before->hash == after->hash && before->type == after->type) {
+            continue;
+        }
+
+        bool before_tree = before && before->type == types::TREE;
+        bool after_tree = after && after->type == types::TREE;
+        if (before_tree && after_tree) {
+            if (!diffTrees(before->hash, after->hash, path, changes)) return false;
+            continue;
+        }
+        if (before && after && !before_tree && !after_tree) {
+            changes.push_back({FileChange::Kind::Modified, path, before->hash, after->hash, "", 0});
+            continue;
+        }
+        if (before) {
+            if (before_tree) {
+                if (!addAll(before->hash, path, FileChange::Kind::Deleted, changes)) return false;
+            } else {
+                changes.push_back({FileChange::Kind::Deleted, path, before->hash, "", "", 0});
+            }
+        }
+        if (after) {
+            if (after_tree) {
+                if (!addAll(after->hash, path, FileChange::Kind::Added, changes)) return false;
+            } else {
+                changes.push_back({FileChange::Kind::Added, path, "", after->hash, "", 0});
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Computes the changes between two root trees
+ * @param old_tree_hash Hash of the old root tree (empty for no tree)
+ * @param new_tree_hash Hash of the new root tree (empty for no tree)
+ * @param changes Vector receiving the changes in path order
+ * @return bool True if every tree could be read, false otherwise
+ */
+bool TreeDiff::diff(const std::string& old_tree_hash, const std::string& new_tree_hash,
+                    std::vector<FileChange>& changes) {
+    if (old_tree_hash.empty() && new_tree_hash.empty()) return true;
+    if (old_tree_hash.empty()) return addAll(new_tree_hash, "", FileChange::Kind::Added, changes);
+    if (new_tree_hash.empty()) return addAll(old_tree_hash, "", FileChange::Kind::Deleted, changes);
+    return diffTrees(old_tree_hash, new_tree_hash, "", changes);
+}
+
+} // namespace vcs
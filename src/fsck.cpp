@@ -0,0 +1,170 @@
+#include "fsck.h"
+#include "constants.h"
+#include "index.h"
+#include "pack.h"
+#include "parallel.h"
+#include "refs.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+namespace vcs {
+
+/**
+ * @brief Type and outgoing references of one verified object
+ */
+struct CheckedObject {
+    std::string type;                                       ///< Detected type (empty if corrupt)
+    std::vector<std::pair<std::string, std::string>> refs;  ///< (expected type, hash) references
+};
+
+/**
+ * @brief Detects the type of an object and collects its references
+ * @param hash Name of the object
+ * @param data Raw serialized data of the object
+ * @param object Reference to CheckedObject to populate (type stays empty if corrupt)
+ */
+static void inspectObject(const std::string& hash, const std::string& data, CheckedObject& object) {
+    object.type = detectObjectType(hash, data);
+
+    if (object.type == types::TREE) {
+        TreeParser parser(data);
+        TreeEntryView entry;
+        while (parser.next(entry)) {
+            object.refs.emplace_back(entry.isTree() ? types::TREE : types::BLOB,
+                                     rawToHex(entry.raw_hash));
+        }
+        if (parser.failed()) object.type.clear();
+    } else if (object.type == types::COMMIT) {
+        CommitView view;
+        if (view.parse(data)) {
+            object.refs.emplace_back(types::TREE, rawToHex(view.tree_raw));
+            for (std::size_t p = 0; p < view.parentCount(); p++) {
+                object.refs.emplace_back(types::COMMIT, rawToHex(view.parentRaw(p)));
+            }
+        } else {
+            object.type.clear();
+        }
+    }
+}
+
+/**
+ * @brief Constructs a checker for the given storage
+ * @param storage Storage to verify
+ * @param threads Worker thread count (0 selects hardware concurrency)
+ */
+IntegrityChecker::IntegrityChecker(Storage& storage, unsigned threads)
+    : storage(storage), threads(threads) {}
+
+/**
+ * @brief Checks all objects and references
+ * @param report Reference to FsckReport to populate
+ * @param progress Stream for progress lines (nullptr for none)
+ * @return bool True if no corrupt or missing objects or bad packs were found, false otherwise
+ */
+bool IntegrityChecker::run(FsckReport& report, std::ostream* progress) {
+    // Packs whose index cannot be trusted are left out of every lookup, so report them here
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(storage.getPackPath(), ec), end; !ec && it != end;
+         it.increment(ec)) {
+        PackReader pack;
+        if (it->path().extension() == ".idx" && !pack.open(it->path().string())) {
+            report.bad_packs.push_back(it->path().string());
+        }
+    }
+
+    std::vector<std::string> hashes = storage.listObjects();
+    for (auto& hash : storage.listPackedObjects()) {
+        hashes.push_back(std::move(hash));
+    }
+    std::vector<CheckedObject> checked(hashes.size());
+    std::atomic<std::size_t> done(0);
+    std::atomic<std::uint64_t> bytes(0);
+    std::mutex progress_mutex;
+    std::size_t step = hashes.size() / 20 + 1;
+    auto start = std::chrono::steady_clock::now();
+
+    auto elapsed = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    parallelFor(hashes.size(), [&](std::size_t i) {
+        std::string data;
+        if (storage.readObject(hashes[i], data)) {
+            bytes += data.size();
+            inspectObject(hashes[i], data, checked[i]);
+        }
+
+        std::size_t count = ++done;
+        if (progress && (count % step == 0 || count == hashes.size())) {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            double seconds = elapsed();
+            *progress << "Checking objects: " << count << "/" << hashes.size() << " ("
+                      << std::fixed << std::setprecision(1)
+                      << (seconds > 0 ? bytes.load() / (1024.0 * 1024.0) / seconds : 0.0)
+                      << " MB/s)" << std::endl;
+            progress->unsetf(std::ios::fixed);
+        }
+    }, threads);
+
+    report.objects = hashes.size();
+    report.bytes = bytes.load();
+    report.seconds = elapsed();
+
+    std::unordered_map<std::string, std::string> types_by_hash;
+    for (std::size_t i = 0; i < hashes.size(); i++) {
+        if (checked[i].type.empty()) {
+            report.corrupt.push_back(hashes[i]);
+        } else {
+            types_by_hash[hashes[i]] = checked[i].type;
+        }
+    }
+
+    // Objects outside the scanned directory are read through the alternates and
+    // followed in turn, so history kept only in another store is checked as well
+    std::vector<BrokenLink> pending;
+    auto verify = [&](const std::string& type, const std::string& hash, const std::string& referrer) {
+        pending.push_back({hash, type, referrer});
+        while (!pending.empty()) {
+            BrokenLink ref = std::move(pending.back());
+            pending.pop_back();
+            auto it = types_by_hash.find(ref.hash);
+            if (it == types_by_hash.end()) {
+                std::string data;
+                CheckedObject object;
+                if (storage.readObject(ref.hash, data)) inspectObject(ref.hash, data, object);
+                if (object.type.empty()) {
+                    report.missing.push_back(std::move(ref));
+                    continue;
+                }
+                it = types_by_hash.emplace(ref.hash, object.type).first;
+                for (const auto& next : object.refs) {
+                    pending.push_back({next.second, next.first, ref.hash});
+                }
+            }
+            if (it->second != ref.expected_type) report.missing.push_back(std::move(ref));
+        }
+    };
+
+    for (std::size_t i = 0; i < hashes.size(); i++) {
+        for (const auto& ref : checked[i].refs) {
+            verify(ref.first, ref.second, hashes[i]);
+        }
+    }
+
+    std::string head;
+    if (Refs().readHead(head)) verify(types::COMMIT, head, "HEAD");
+    Index index;
+    for (const auto& path : index.getStagedFiles()) {
+        IndexEntry entry;
+        if (index.getEntry(path, entry)) verify(types::BLOB, entry.blob_hash, "index");
+    }
+
+    return report.corrupt.empty() && report.missing.empty() && report.bad_packs.empty();
+}
+
+} // namespace vcs
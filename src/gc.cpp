@@ -0,0 +1,99 @@
+#include "gc.h"
+#include "index.h"
+#include "reachability.h"
+#include "refs.h"
+#include <ctime>
+#include <unordered_set>
+
+namespace vcs {
+
+/**
+ * @brief Constructs a collector for the given storage
+ * @param storage Storage to collect
+ * @param threads Worker thread count for marking (0 selects hardware concurrency)
+ */
+GarbageCollector::GarbageCollector(Storage& storage, unsigned threads)
+    : storage(storage), threads(threads) {}
+
+/**
+ * @brief Reads the current roots from HEAD and the index file
+ * @param commits Vector receiving the root commits
+ * @param blobs Vector receiving the staged blobs
+ */
+void GarbageCollector::readRoots(std::vector<std::string>& commits,
+                                 std::vector<std::string>& blobs) {
+    std::string head;
+    if (Refs().readHead(head)) commits.push_back(head);
+
+    // A fresh Index reads the file as it is now, not as this process last saw it
+    Index index;
+    for (const auto& path : index.getStagedFiles()) {
+        IndexEntry entry;
+        if (index.getEntry(path, entry)) blobs.push_back(entry.blob_hash);
+    }
+}
+
+/**
+ * @brief Marks reachable objects and sweeps the rest
+ * @param grace_seconds Only remove objects older than this many seconds
+ * @param dry_run Report what would be removed without deleting anything
+ * @param stats Reference to GcStats to populate
+ * @return bool True if every object could be examined and removed, false otherwise
+ *              (nothing is removed if a reachable object is missing)
+ */
+bool GarbageCollector::run(std::int64_t grace_seconds, bool dry_run, GcStats& stats) {
+    std::int64_t cutoff = static_cast<std::int64_t>(std::time(nullptr)) - grace_seconds;
+
+    std::unordered_set<std::string> reachable;
+    std::vector<std::string> missing;
+    ReachabilityWalker walker(storage, threads);
+
+    std::vector<std::string> commits, blobs;
+    readRoots(commits, blobs);
+    walker.mark(commits, blobs, reachable, missing);
+
+    // List candidates only after marking: anything stored later is not swept
+    std::vector<std::string> objects = storage.listObjects();
+
+    // Roots may have moved while marking; extend the mark with the new ones
+    commits.clear();
+    blobs.clear();
+    readRoots(commits, blobs);
+    walker.mark(commits, blobs, reachable, missing);
+    stats.reachable = reachable.size();
+    stats.missing = missing.size();
+
+    // Whatever lies below an unreadable tree or commit would look unreachable;
+    // sweeping then would turn a read error into permanent data loss
+    if (!missing.empty() && !dry_run) return false;
+
+    bool ok = true;
+    for (const auto& hash : objects) {
+        stats.examined++;
+        if (reachable.count(hash)) continue;
+
+        std::uint64_t size;
+        std::int64_t mtime;
+        if (!storage.statObject(hash, size, mtime)) continue;  // removed concurrently
+        if (mtime > cutoff) {
+            stats.kept_recent++;
+            continue;
+        }
+        if (!dry_run) {
+            bool removed;
+            if (!storage.removeObjectIfOlder(hash, cutoff, removed)) {
+                ok = false;
+                continue;
+            }
+            if (!removed) {
+                stats.kept_recent++;  // re-added while sweeping
+                continue;
+            }
+        }
+        stats.removed++;
+        stats.bytes_reclaimed += size;
+    }
+    return ok;
+}
+
+} // namespace vcs
@@ -0,0 +1,425 @@
+#include "grep.h"
+#include "constants.h"
+#include "object.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace vcs {
+
+/**
+ * @brief Bytes inspected for NUL when deciding whether a blob is binary
+ */
+static const std::size_t BINARY_PROBE_SIZE = 8000;
+
+/**
+ * @brief Longest line given to the recursive std::regex matcher (deeper recursion overflows the stack)
+ */
+static const std::size_t MAX_BACKTRACK_LINE = 2048;
+
+/**
+ * @brief Cached blobs, subtrees and matching lines above which the caches are dropped
+ */
+static const std::size_t MAX_CACHED_BLOBS = 200000;
+static const std::size_t MAX_CACHED_TREES = 50000;
+static const std::size_t MAX_CACHED_LINES = 500000;
+
+/**
+ * @brief Converts an ASCII letter to lower case
+ * @param c The character
+ * @return char Lower-case letter, or c unchanged
+ */
+static char toLowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+/**
+ * @brief Converts an ASCII letter to upper case
+ * @param c The character
+ * @return char Upper-case letter, or c unchanged
+ */
+static char toUpperAscii(char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - ('a' - 'A')) : c;
+}
+
+/**
+ * @brief Compares a literal with the bytes at a position
+ * @param data Start of the candidate occurrence
+ * @param needle The literal
+ * @param ignore_case Compare ASCII letters regardless of case
+ * @return bool True if the bytes equal the literal
+ */
+static bool equalsAt(const char* data, std::string_view needle, bool ignore_case) {
+    if (!ignore_case) return std::memcmp(data, needle.data(), needle.size()) == 0;
+    for (std::size_t i = 0; i < needle.size(); i++) {
+        if (toLowerAscii(data[i]) != toLowerAscii(needle[i])) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Extracts literals that every match of a regex must contain
+ *
+ * Only text outside groups and brackets counts, and a pattern with a
+ * top-level alternation has no required literals.
+ *
+ * @param pattern ECMAScript regular expression
+ * @return std::vector<std::string> Required literals, longest first (empty if none were found)
+ */
+std::vector<std::string> TreeGrep::requiredLiterals(const std::string& pattern) {
+    std::vector<std::string> found;
+    std::string run;
+    auto flush = [&]() {
+        if (!run.empty()) found.push_back(run);
+        run.clear();
+    };
+
+    int depth = 0;
+    for (std::size_t i = 0; i < pattern.size(); i++) {
+        char c = pattern[i];
+        if (c == '[') {
+            // Skip the whole class; a ']' right after '[' or '[^' is a member
+            flush();
+            i++;
+            if (i < pattern.size() && pattern[i] == '^') i++;
+            if (i < pattern.size() && pattern[i] == ']') i++;
+            while (i < pattern.size() && pattern[i] != ']') {
+                if (pattern[i] == '\\') i++;
+                i++;
+            }
+            continue;
+        }
+        if (c == '(' || c == ')') {
+            flush();
+            depth += c == '(' ? 1 : -1;
+            continue;
+        }
+        if (depth > 0) {
+            if (c == '\\') i++;
+            continue;
+        }
+        switch (c) {
+            case '|':
+                return {};
+            case '*':
+            case '?':
+            case '{':
+                // The preceding character may be absent
+                if (!run.empty()) run.pop_back();
+                flush();
+                if (c == '{') {
+                    while (i < pattern.size() && pattern[i] != '}') i++;
+                }
+                break;
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+                flush();
+                break;
+            case '\\':
+                if (i + 1 < pattern.size()) {
+                    char escaped = pattern[++i];
+                    if (std::isalnum(static_cast<unsigned char>(escaped))) {
+                        // A class or control escape; its operand is not literal text
+                        flush();
+                        std::size_t operand = 0;
+                        if (escaped == 'x') operand = 2;
+                        else if (escaped == 'u') operand = 4;
+                        else if (escaped == 'c') operand = 1;
+                        if (std::isdigit(static_cast<unsigned char>(escaped))) {
+                            while (i + 1 < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[i + 1]))) i++;
+                        }
+                        i = std::min(i + operand, pattern.size() - 1);
+                    } else {
+                        run.push_back(escaped);
+                    }
+                }
+                break;
+            default:
+                run.push_back(c);
+        }
+    }
+    flush();
+    std::stable_sort(found.begin(), found.end(),
+                     [](const std::string& a, const std::string& b) { return a.size() > b.size(); });
+    return found;
+}
+
+/**
+ * @brief Finds a literal in a buffer
+ * @param haystack Buffer to search
+ * @param needle Literal to find (not empty)
+ * @param ignore_case Compare ASCII letters regardless of case
+ * @return std::size_t Offset of the first occurrence, or std::string_view::npos
+ */
+std::size_t TreeGrep::findLiteral(std::string_view haystack, std::string_view needle, bool ignore_case) {
+    const std::size_t n = needle.size();
+    if (n == 0) return 0;
+    if (n > haystack.size()) return std::string_view::npos;
+    const char* data = haystack.data();
+    const std::size_t last = haystack.size() - n;
+
+    if (!ignore_case && n == 1) {
+        const void* found = std::memchr(data, needle[0], haystack.size());
+        return found ? static_cast<const char*>(found) - data : std::string_view::npos;
+    }
+
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    // Test 16 candidate positions at once: only where both the first and the
+    // last byte of the literal match is the full comparison done
+    const __m128i first_lower = _mm_set1_epi8(ignore_case ? toLowerAscii(needle[0]) : needle[0]);
+    const __m128i first_upper = _mm_set1_epi8(ignore_case ? toUpperAscii(needle[0]) : needle[0]);
+    const __m128i last_lower = _mm_set1_epi8(ignore_case ? toLowerAscii(needle[n - 1]) : needle[n - 1]);
+    const __m128i last_upper = _mm_set1_epi8(ignore_case ? toUpperAscii(needle[n - 1]) : needle[n - 1]);
+    for (; i + 16 <= last + 1; i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + n - 1));
+        __m128i eq_first = _mm_or_si128(_mm_cmpeq_epi8(block_first, first_lower),
+                                        _mm_cmpeq_epi8(block_first, first_upper));
+        __m128i eq_last = _mm_or_si128(_mm_cmpeq_epi8(block_last, last_lower),
+                                       _mm_cmpeq_epi8(block_last, last_upper));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last)));
+        while (mask != 0) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (equalsAt(data + i + bit, needle, ignore_case)) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i <= last; i++) {
+        if (equalsAt(data + i, needle, ignore_case)) return i;
+    }
+    return std::string_view::npos;
+}
+
+/**
+ * @brief Constructs a TreeGrep reading from the given storage
+ * @param storage Storage to read trees and blobs from
+ */
+TreeGrep::TreeGrep(Storage& storage) : storage(storage) {}
+
+/**
+ * @brief Drops the blob and subtree caches
+ */
+void TreeGrep::clearCaches() {
+    blob_cache.clear();
+    tree_cache.clear();
+    cached_lines = 0;
+}
+
+/**
+ * @brief Sets the pattern; the caches are kept only if pattern and settings are unchanged
+ * @param pattern Regular expression or literal
+ * @param options Search settings
+ * @return bool True if the pattern is valid, false otherwise
+ */
+bool TreeGrep::setPattern(const std::string& pattern, const GrepOptions& options) {
+    bool same = (regex || this->options.fixed_strings) && pattern == this->pattern &&
+                options.ignore_case == this->options.ignore_case &&
+                options.fixed_strings == this->options.fixed_strings;
+    this->options = options;
+    if (same) return true;
+
+    clearCaches();
+    this->pattern = pattern;
+    regex.reset();
+    use_line_regex = false;
+    if (options.fixed_strings) {
+        literals.assign(1, pattern);
+        return true;
+    }
+    literals = requiredLiterals(pattern);
+    auto flags = std::regex::ECMAScript | std::regex::optimize;
+    if (options.ignore_case) flags |= std::regex::icase;
+    try {
+        regex.reset(new std::regex(pattern, flags));
+    } catch (const std::regex_error&) {
+        this->pattern.clear();
+        return false;
+    }
+    use_line_regex = line_regex.compile(pattern, options.ignore_case);
+    return true;
+}
+
+/**
+ * @brief Searches the content of one blob
+ * @param data The blob content
+ * @param result Reference to BlobResult to populate
+ * @return bool False if the prefilter ruled the blob out, true otherwise
+ */
+bool TreeGrep::searchBlob(std::string_view data, BlobResult& result) const {
+    result.binary = std::memchr(data.data(), '\0', std::min(data.size(), BINARY_PROBE_SIZE)) != nullptr;
+
+    std::size_t pos = 0;
+    std::size_t line_number = 1;
+    std::size_t counted = 0;
+    while (pos < data.size()) {
+        std::size_t line_start = pos;
+        std::size_t line_end;
+        if (!literals.empty()) {
+            std::size_t found = findLiteral(data.substr(pos), literals[0], options.ignore_case);
+            if (found == std::string_view::npos) return pos > 0;
+            found += pos;
+            std::size_t newline = found == 0 ? std::string_view::npos : data.rfind('\n', found - 1);
+            if (newline != std::string_view::npos && newline + 1 > line_start) line_start = newline + 1;
+            line_end = data.find('\n', found);
+        } else {
+            line_end = data.find('\n', pos);
+        }
+        if (line_end == std::string_view::npos) line_end = data.size();
+
+        std::string_view line = data.substr(line_start, line_end - line_start);
+        bool matched = true;
+        for (std::size_t i = 1; matched && i < literals.size(); i++) {
+            matched = findLiteral(line, literals[i], options.ignore_case) != std::string_view::npos;
+        }
+        if (matched && regex) {
+            if (use_line_regex) {
+                matched = line_regex.search(line);
+            } else if (line.size() <= MAX_BACKTRACK_LINE) {
+                matched = std::regex_search(line.begin(), line.end(), *regex);
+            } else {
+                matched = false;
+                result.skipped++;
+            }
+        }
+        if (matched) {
+            line_number += std::count(data.begin() + counted, data.begin() + line_start, '\n');
+            counted = line_start;
+            if (result.binary) {
+                // One match is enough to report a binary file
+                result.lines.assign(1, {0, std::string()});
+                return true;
+            }
+            result.lines.emplace_back(line_number, std::string(line));
+        }
+        pos = line_end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Searches every file below a tree
+ * @param tree_hash Hash of the root tree
+ * @param matches Vector receiving matches in path and line order
+ * @param stats Reference to GrepStats to populate
+ * @return bool True if every tree and blob could be read, false otherwise
+ */
+bool TreeGrep::search(const std::string& tree_hash, std::vector<GrepMatch>& matches, GrepStats& stats) {
+    stats = GrepStats();
+    matches.clear();
+    // The caches outlive requests for the same pattern; a long-running server keeps them bounded
+    if (blob_cache.size() > MAX_CACHED_BLOBS || tree_cache.size() > MAX_CACHED_TREES ||
+        cached_lines > MAX_CACHED_LINES) {
+        clearCaches();
+    }
+
+    // Walk the trees; cached subtrees are answered without being read
+    std::vector<std::pair<std::string, std::string>> files;     // Path, blob hash
+    std::vector<std::pair<std::string, std::string>> visited;   // Prefix, tree hash
+    std::vector<std::pair<std::string, std::string>> pending = {{"", tree_hash}};
+    while (!pending.empty()) {
+        auto item = std::move(pending.back());
+        pending.pop_back();
+        const std::string& prefix = item.first;
+
+        auto cached = tree_cache.find(item.second);
+        if (cached != tree_cache.end()) {
+            stats.tree_cache_hits++;
+            for (const auto& match : cached->second) {
+                matches.push_back({prefix.empty() ? match.path : prefix + "/" + match.path,
+                                   match.line_number, match.line});
+            }
+            continue;
+        }
+
+        Tree tree;
+        if (!storage.readTree(item.second, tree)) return false;
+        for (const auto& entry : tree.entries) {
+            std::string path = prefix.empty() ? entry.name : prefix + "/" + entry.name;
+            if (entry.type == types::TREE) {
+                pending.emplace_back(std::move(path), entry.hash);
+            } else {
+                files.emplace_back(std::move(path), entry.hash);
+            }
+        }
+        visited.push_back(std::move(item));
+    }
+    stats.files = files.size();
+
+    // Search every blob that is not cached yet, once, on all workers
+    std::vector<std::string> todo;
+    for (const auto& file : files) {
+        if (blob_cache.count(file.second)) {
+            stats.blob_cache_hits++;
+        } else if (blob_cache.emplace(file.second, BlobResult()).second) {
+            todo.push_back(file.second);
+        }
+    }
+    std::vector<BlobResult> results(todo.size());
+    std::atomic<bool> ok(true);
+    std::atomic<std::size_t> prefiltered(0), binary(0), skipped(0);
+    std::atomic<std::uint64_t> bytes(0);
+    parallelFor(todo.size(), [&](std::size_t i) {
+        Blob blob("");
+        if (!storage.readBlob(todo[i], blob)) {
+            ok = false;
+            return;
+        }
+        bytes += blob.content.size();
+        if (!searchBlob(blob.content, results[i])) prefiltered++;
+        if (results[i].binary) binary++;
+        skipped += results[i].skipped;
+    }, options.threads);
+    if (!ok) {
+        for (const auto& hash : todo) blob_cache.erase(hash);
+        return false;
+    }
+    for (std::size_t i = 0; i < todo.size(); i++) {
+        cached_lines += results[i].lines.size();
+        blob_cache[todo[i]] = std::move(results[i]);
+    }
+    stats.blobs_searched = todo.size();
+    stats.blobs_prefiltered = prefiltered;
+    stats.binary_files = binary;
+    stats.bytes_searched = bytes;
+    stats.lines_skipped = skipped;
+
+    for (const auto& file : files) {
+        for (const auto& line : blob_cache[file.second].lines) {
+            matches.push_back({file.first, line.first, line.second});
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const GrepMatch& a, const GrepMatch& b) {
+        return a.path != b.path ? a.path < b.path : a.line_number < b.line_number;
+    });
+
+    // Remember the matches of every tree read, relative to that tree
+    for (const auto& tree : visited) {
+        const std::string& prefix = tree.first;
+        std::vector<GrepMatch>& cached = tree_cache[tree.second];
+        cached_lines -= cached.size();
+        cached.clear();
+        if (prefix.empty()) {
+            cached = matches;
+        } else {
+            auto first = std::lower_bound(matches.begin(), matches.end(), prefix + "/",
+                                          [](const GrepMatch& m, const std::string& key) { return m.path < key; });
+            std::string end_key = prefix + "0";     // '0' sorts right after '/'
+            for (auto it = first; it != matches.end() && it->path < end_key; ++it) {
+                cached.push_back({it->path.substr(prefix.size() + 1), it->line_number, it->line});
+            }
+        }
+        cached_lines += cached.size();
+    }
+    return true;
+}
+
+} // namespace vcs
@@ -0,0 +1,123 @@
+#include "history.h"
+#include <unordered_set>
+
+namespace vcs {
+
+/**
+ * @brief Constructs a History walker
+ * @param storage Storage to read commits and trees from
+ * @param graph Commit graph with cached parents and changed-path filters
+ */
+History::History(Storage& storage, CommitGraph& graph) : storage(storage), graph(graph) {}
+
+/**
+ * @brief Gets tree and parents of a commit, preferring the commit graph
+ * @param commit_hash Hash of the commit
+ * @param entry Reference to CommitGraphEntry to populate
+ * @return bool True if the commit is known, false otherwise
+ */
+bool History::lookup(const std::string& commit_hash, CommitGraphEntry& entry) {
+    const CommitGraphEntry* cached = graph.find(commit_hash);
+    if (cached) {
+        entry = *cached;
+        return true;
+    }
+    // Commits written before the graph existed have no filter
+    Commit commit;
+    if (!storage.readCommit(commit_hash, commit)) return false;
+    entry = CommitGraphEntry();
+    entry.tree_hash = commit.tree_hash;
+    entry.parent_hashes = commit.parent_hashes;
+    return true;
+}
+
+/**
+ * @brief Lists commits reachable from a start commit, newest first
+ * @param start_hash Hash of the commit to start from
+ * @param path Only list commits changing this file or directory (empty for all)
+ * @param commits Vector receiving the matching commit hashes
+ * @param stats Reference to HistoryStats to populate
+ * @param use_filters Consult changed-path filters before diffing (default true)
+ * @return bool True if the walk completed, false if a commit or tree was missing
+ */
+bool History::log(const std::string& start_hash, const std::string& path,
+                  std::vector<std::string>& commits, HistoryStats& stats, bool use_filters) {
+    std::string prefix = path;
+    while (prefix.compare(0, 2, "./") == 0) prefix.erase(0, 2);
+    while (!prefix.empty() && prefix.back() == '/') prefix.pop_back();
+
+    TreeDiff differ(storage);
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> pending = {start_hash};
+    seen.insert(start_hash);
+
+    while (!pending.empty()) {
+        std::string hash = pending.back();
+        pending.pop_back();
+        stats.commits_visited++;
+
+        CommitGraphEntry entry;
+        if (!lookup(hash, entry)) return false;
+
+        // Push parents in reverse so the first parent is walked first
+        for (auto it = entry.parent_hashes.rbegin(); it != entry.parent_hashes.rend(); ++it) {
+            if (seen.insert(*it).second) pending.push_back(*it);
+        }
+
+        if (prefix.empty()) {
+            commits.push_back(hash);
+            continue;
+        }
+        if (use_filters && !CommitGraph::mayHaveChanged(entry, prefix)) {
+            stats.filter_skipped++;
+            continue;
+        }
+
+        std::string parent_tree;
+        if (!entry.parent_hashes.empty()) {
+            CommitGraphEntry parent;
+            if (!lookup(entry.parent_hashes.front(), parent)) return false;
+            parent_tree = parent.tree_hash;
+        }
+
+        std::vector<FileChange> changes;
+        stats.trees_diffed++;
+        if (!differ.diff(parent_tree, entry.tree_hash, changes)) return false;
+        for (const auto& change : changes) {
+            if (change.path == prefix || change.path.compare(0, prefix.size() + 1, prefix + "/") == 0) {
+                commits.push_back(hash);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Checks whether one commit is reachable from another through parents
+ * @param ancestor Hash of the possible ancestor
+ * @param descendant Hash of the commit to walk back from
+ * @param result Reference set to true if ancestor is descendant or one of its ancestors
+ * @return bool True if the walk completed, false if a commit was missing
+ */
+bool History::isAncestor(const std::string& ancestor, const std::string& descendant, bool& result) {
+    result = false;
+    std::unordered_set<std::string> seen = {descendant};
+    std::vector<std::string> pending = {descendant};
+    while (!pending.empty()) {
+        std::string hash = pending.back();
+        pending.pop_back();
+        if (hash == ancestor) {
+            result = true;
+            return true;
+        }
+        CommitGraphEntry entry;
+        if (!lookup(hash, entry)) return false;
+        for (const auto& parent : entry.parent_hashes) {
+            if (seen.insert(parent).second) pending.push_back(parent);
+        }
+    }
+    return true;
+}
+
+} // namespace vcs
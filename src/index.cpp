@@ -3,13 +3,15 @@
 #include <fstream>
 #include <sstream>
 #include <ctime>
+#include <cstdio>
+#include <filesystem>
 
 namespace vcs {
 
 /**
  * @brief Default constructor for IndexEntry
  */
-IndexEntry::IndexEntry() : timestamp(0) {}
+IndexEntry::IndexEntry() : timestamp(0), file_size(0), mtime(0), staged(true) {}
 
 /**
  * @brief Constructs an IndexEntry with file path and blob hash
@@ -17,15 +19,75 @@ IndexEntry::IndexEntry() : timestamp(0) {}
  * @param hash The blob hash of file content
  */
 IndexEntry::IndexEntry(const std::string& path, const std::string& hash)
-: file_path(path), blob_hash(hash) {
+: file_path(path), blob_hash(hash), file_size(0), mtime(0), staged(true) {
     timestamp = std::time(nullptr);
 }
 
 /**
- * @brief Constructs Index object and loads existing index from disk
+ * @brief Parses the fields of an index entry
+ * @param iss Stream positioned at the entry's path
+ * @param entry Reference to IndexEntry to populate
+ * @return bool True if path, hash and timestamp were present, false otherwise
  */
-Index::Index() {
+static bool parseEntry(std::istringstream& iss, IndexEntry& entry) {
+    std::string path, hash;
+    std::uint64_t ts;
+    if (!(iss >> path >> hash >> ts)) return false;
+    entry = IndexEntry(path, hash);
+    entry.timestamp = ts;
+    // Stat data and the staged flag are optional so indexes written by older versions still load
+    int staged;
+    if (iss >> entry.file_size >> entry.mtime >> staged) entry.staged = staged != 0;
+    return true;
+}
+
+/**
+ * @brief Writes the fields of an index entry as one line
+ * @param out Stream to write to
+ * @param entry The entry
+ */
+static void writeEntry(std::ostream& out, const IndexEntry& entry) {
+    out << entry.file_path << " " 
+        << entry.blob_hash << " " 
+        << entry.timestamp << " "
+        << entry.file_size << " "
+        << entry.mtime << " "
+        << (entry.staged ? 1 : 0) << "\n";
+}
+
+/**
+ * @brief Constructs Index object; the index file is read on first access
+ */
+Index::Index() : loaded(false), split(false), base_count(0), delta_count(0) {
     index_path = std::string(VCS_DIR) + "/" + INDEX_FILE;
+    base_path = std::string(VCS_DIR) + "/" + INDEX_BASE_FILE;
+}
+
+/**
+ * @brief Describes the current state of the index files on disk
+ * @return std::string Size and mtime of the index and base files
+ */
+std::string Index::diskStamp() const {
+    std::string stamp;
+    for (const auto& path : {index_path, base_path}) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            stamp += "-;";
+            continue;
+        }
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        stamp += std::to_string(size) + ":" + std::to_string(mtime.time_since_epoch().count()) + ";";
+    }
+    return stamp;
+}
+
+/**
+ * @brief Reads the index file on first access
+ */
+void Index::ensureLoaded() const {
+    if (loaded) return;
+    loaded = true;
     loadFromDisk();
 }
 
@@ -33,19 +95,52 @@ Index::Index() {
  * @brief Loads index entries from disk storage
  * @return bool True if load successful, false otherwise
  */
-bool Index::loadFromDisk() {
+bool Index::loadFromDisk() const {
+    // Taken before reading so that a change during the read causes a reload
+    loaded_stamp = diskStamp();
+    entries.clear();
+    base_count = 0;
+    delta_count = 0;
+    std::string line;
+    IndexEntry entry;
+    std::ifstream base(base_path);
+    split = base.is_open();
+    if (split) {
+        while (std::getline(base, line)) {
+            std::istringstream iss(line);
+            if (parseEntry(iss, entry)) entries[entry.file_path] = entry;
+        }
+        base_count = entries.size();
+    }
+    
     std::ifstream file(index_path);
-    if (!file.is_open()) return false;
+    if (!file.is_open()) return split;
     
-    std::string line;
+    bool first = true;
     while (std::getline(file, line)) {
         std::istringstream iss(line);
-        std::string path, hash;
-        std::uint64_t ts;
-        if (iss >> path >> hash >> ts) {
-            entries[path] = IndexEntry(path, hash);
-            entries[path].timestamp = ts;
+        if (split && first && line.compare(0, 2, "+ ") != 0 && line.compare(0, 2, "- ") != 0) {
+            // A full index next to a base is left by setSplit(false) interrupted
+            // before it removed the base; the full index supersedes the base
+            entries.clear();
+            split = false;
+            base_count = 0;
+            std::remove(base_path.c_str());
+        }
+        first = false;
+        if (!split) {
+            if (parseEntry(iss, entry)) entries[entry.file_path] = entry;
+            continue;
         }
+        // Change log: later lines win over earlier ones and over the base
+        std::string op, path;
+        iss >> op;
+        if (op == "+" && parseEntry(iss, entry)) {
+            entries[entry.file_path] = entry;
+        } else if (op == "-" && iss >> path) {
+            entries.erase(path);
+        }
+        delta_count++;
     }
     return true;
 }
@@ -55,14 +150,82 @@ bool Index::loadFromDisk() {
  * @return bool True if save successful, false otherwise
  */
 bool Index::saveToDisk() {
-    std::ofstream file(index_path);
-    if (!file.is_open()) return false;
+    // Written aside and renamed into place, so a crash leaves the old or the new index
+    std::string tmp_path = index_path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        if (!file.is_open()) return false;
+        for (const auto& pair : entries) {
+            writeEntry(file, pair.second);
+        }
+        if (!file.good()) return false;
+    }
+    return std::rename(tmp_path.c_str(), index_path.c_str()) == 0;
+}
+
+/**
+ * @brief Rewrites the base index with all entries and empties the change log
+ * @return bool True if save successful, false otherwise
+ */
+bool Index::writeBase() {
+    std::string tmp_path = base_path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        if (!file.is_open()) return false;
+        for (const auto& pair : entries) {
+            writeEntry(file, pair.second);
+        }
+        if (!file.good()) return false;
+    }
+    // The log is dropped only after the new base is in place, so a crash loses nothing
+    if (std::rename(tmp_path.c_str(), base_path.c_str()) != 0) return false;
+    std::remove(index_path.c_str());
+    base_count = entries.size();
+    delta_count = 0;
+    return true;
+}
+
+/**
+ * @brief Persists changed entries: appended to the change log in split mode, a full save otherwise
+ * @param updated Entries that were added or replaced
+ * @param removed Paths that were removed
+ * @return bool True if save successful, false otherwise
+ */
+bool Index::saveChanges(const std::vector<const IndexEntry*>& updated,
+                        const std::vector<std::string>& removed) {
+    // Our own write must not look like a foreign change to refresh(), unless
+    // the files had already been changed by someone else
+    std::string before = diskStamp();
+    bool ok = appendChanges(updated, removed);
+    if (before == loaded_stamp) loaded_stamp = diskStamp();
+    return ok;
+}
+
+/**
+ * @brief Writes changed entries without tracking the on-disk state
+ * @param updated Entries that were added or replaced
+ * @param removed Paths that were removed
+ * @return bool True if save successful, false otherwise
+ */
+bool Index::appendChanges(const std::vector<const IndexEntry*>& updated,
+                          const std::vector<std::string>& removed) {
+    if (!split) return saveToDisk();
     
-    for (const auto& pair : entries) {
-        file << pair.second.file_path << " " 
-             << pair.second.blob_hash << " " 
-             << pair.second.timestamp << "\n";
+    std::size_t lines = updated.size() + removed.size();
+    std::size_t limit = base_count * MAX_DELTA_PERCENT / 100;
+    if (limit < MIN_FOLD_ENTRIES) limit = MIN_FOLD_ENTRIES;
+    if (delta_count + lines > limit) return writeBase();
+    
+    std::ofstream file(index_path, std::ios::app);
+    if (!file.is_open()) return false;
+    for (const IndexEntry* entry : updated) {
+        file << "+ ";
+        writeEntry(file, *entry);
     }
+    for (const auto& path : removed) {
+        file << "- " << path << "\n";
+    }
+    delta_count += lines;
     return file.good();
 }
 
@@ -73,8 +236,29 @@ bool Index::saveToDisk() {
  * @return bool True if add successful, false otherwise
  */
 bool Index::addFile(const std::string& file_path, const std::string& blob_hash) {
-    entries[file_path] = IndexEntry(file_path, blob_hash);
-    return saveToDisk();
+    ensureLoaded();
+    IndexEntry& entry = entries[file_path];
+    entry = IndexEntry(file_path, blob_hash);
+    return saveChanges({&entry}, {});
+}
+
+/**
+ * @brief Adds or updates many entries and writes the index to disk once
+ * @param batch Entries to stage or stat data to record (replaces entries with the same path, except that stat data never replaces a staged entry)
+ * @return bool True if the index was saved successfully, false otherwise
+ */
+bool Index::addFiles(const std::vector<IndexEntry>& batch) {
+    ensureLoaded();
+    std::vector<const IndexEntry*> updated;
+    updated.reserve(batch.size());
+    for (const auto& entry : batch) {
+        IndexEntry& stored = entries[entry.file_path];
+        // Stat data never replaces content the user staged
+        if (!entry.staged && stored.staged && !stored.file_path.empty()) continue;
+        stored = entry;
+        updated.push_back(&stored);
+    }
+    return saveChanges(updated, {});
 }
 
 /**
@@ -83,10 +267,11 @@ bool Index::addFile(const std::string& file_path, const std::string& blob_hash)
  * @return bool True if remove successful, false if file not found
  */
 bool Index::removeFile(const std::string& file_path) {
+    ensureLoaded();
     auto it = entries.find(file_path);
     if (it != entries.end()) {
         entries.erase(it);
-        return saveToDisk();
+        return saveChanges({}, {file_path});
     }
     return false;
 }
@@ -97,7 +282,23 @@ bool Index::removeFile(const std::string& file_path) {
  * @return bool True if file is staged, false otherwise
  */
 bool Index::containsFile(const std::string& file_path) const {
-    return entries.find(file_path) != entries.end();
+    ensureLoaded();
+    auto it = entries.find(file_path);
+    return it != entries.end() && it->second.staged;
+}
+
+/**
+ * @brief Looks up the staged entry for a file
+ * @param file_path Path to the file to look up
+ * @param entry Reference to IndexEntry to populate with data
+ * @return bool True if file is staged, false otherwise
+ */
+bool Index::getEntry(const std::string& file_path, IndexEntry& entry) const {
+    ensureLoaded();
+    auto it = entries.find(file_path);
+    if (it == entries.end() || !it->second.staged) return false;
+    entry = it->second;
+    return true;
 }
 
 /**
@@ -105,9 +306,10 @@ bool Index::containsFile(const std::string& file_path) const {
  * @return std::vector<std::string> List of staged file paths
  */
 std::vector<std::string> Index::getStagedFiles() const {
+    ensureLoaded();
     std::vector<std::string> result;
     for (const auto& pair : entries) {
-        result.push_back(pair.first);
+        if (pair.second.staged) result.push_back(pair.first);
     }
     return result;
 }
@@ -117,15 +319,85 @@ std::vector<std::string> Index::getStagedFiles() const {
  * @return bool True if index is empty, false otherwise
  */
 bool Index::isClean() const {
-    return entries.empty();
+    ensureLoaded();
+    for (const auto& pair : entries) {
+        if (pair.second.staged) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Switches split mode on or off, rewriting the index in the new layout
+ * @param enable True to keep a base index plus a change log, false for a single file
+ * @return bool True if the index was rewritten successfully, false otherwise
+ */
+bool Index::setSplit(bool enable) {
+    ensureLoaded();
+    if (enable) {
+        split = true;
+        return writeBase();
+    }
+    split = false;
+    base_count = 0;
+    delta_count = 0;
+    // The full index replaces the change log atomically; a crash before the base
+    // is removed is recognised on load, where the full index wins over the base
+    if (!saveToDisk()) return false;
+    std::remove(base_path.c_str());
+    return true;
+}
+
+/**
+ * @brief Checks whether the index is in split mode
+ * @return bool True if entries are kept in a base index plus a change log
+ */
+bool Index::isSplit() const {
+    ensureLoaded();
+    return split;
+}
+
+/**
+ * @brief Gets the number of entries in the base index
+ * @return std::size_t Base entries (0 outside split mode)
+ */
+std::size_t Index::baseSize() const {
+    ensureLoaded();
+    return base_count;
+}
+
+/**
+ * @brief Gets the number of lines in the change log
+ * @return std::size_t Change log lines (0 outside split mode)
+ */
+std::size_t Index::deltaSize() const {
+    ensureLoaded();
+    return delta_count;
+}
+
+/**
+ * @brief Drops the loaded entries if another process changed the index files
+ *
+ * Long-running processes call this between requests so that they never
+ * act on, or overwrite, a stale copy of the index.
+ */
+void Index::refresh() {
+    if (loaded && diskStamp() != loaded_stamp) loaded = false;
 }
 
 /**
  * @brief Clears all entries from the index and removes index file from disk
+ *
+ * Split mode stays on: the base is emptied instead of removed.
  */
 void Index::clear() {
+    loaded = true;
     entries.clear();
-    std::remove(index_path.c_str());
+    split = std::filesystem::exists(base_path);
+    if (split) {
+        writeBase();
+    } else {
+        std::remove(index_path.c_str());
+    }
 }
 
 } // namespace vcs
\ No newline at end of file
@@ -0,0 +1,486 @@
+#include "line_regex.h"
+#include <cctype>
+
+namespace vcs {
+
+/**
+ * @brief Nesting depth of groups beyond which a pattern is not compiled
+ */
+static const int MAX_NESTING = 100;
+
+/**
+ * @brief Repetition count beyond which a "{n,m}" quantifier is not compiled
+ */
+static const int MAX_REPEAT = 1000;
+
+/**
+ * @brief Program size beyond which a pattern is not compiled
+ */
+static const std::size_t MAX_PROGRAM_SIZE = 20000;
+
+/**
+ * @brief Checks whether a byte is a word character for "\w" and "\b"
+ * @param c The byte
+ * @return bool True for ASCII letters, digits and '_'
+ */
+static bool isWordByte(unsigned char c) {
+    return std::isalnum(c) || c == '_';
+}
+
+/**
+ * @brief Parses a hexadecimal number of a fixed length
+ * @param text Source text
+ * @param pos Position of the first digit, advanced past the digits on success
+ * @param digits Number of digits
+ * @param value Reference to receive the number
+ * @return bool True if enough hexadecimal digits were present, false otherwise
+ */
+static bool parseHex(const std::string& text, std::size_t& pos, int digits, unsigned& value) {
+    value = 0;
+    for (int i = 0; i < digits; i++) {
+        if (pos + i >= text.size() || !std::isxdigit(static_cast<unsigned char>(text[pos + i]))) return false;
+        char c = text[pos + i];
+        value = value * 16 + (std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : (std::tolower(c) - 'a' + 10));
+    }
+    pos += digits;
+    return true;
+}
+
+/**
+ * @brief Adds a node to the parsed pattern
+ * @param node The node
+ * @return int Index of the node
+ */
+int LineRegex::addNode(Node node) {
+    nodes.push_back(std::move(node));
+    return static_cast<int>(nodes.size() - 1);
+}
+
+/**
+ * @brief Adds a byte set, folding case if required, and a node consuming it
+ * @param set Bytes the node accepts
+ * @return int Index of the node
+ */
+int LineRegex::addClass(std::bitset<256> set) {
+    if (ignore_case) {
+        for (int c = 'a'; c <= 'z'; c++) {
+            if (set[c] || set[c - 'a' + 'A']) {
+                set[c] = true;
+                set[c - 'a' + 'A'] = true;
+            }
+        }
+    }
+    classes.push_back(set);
+    Node node(Node::Kind::Class);
+    node.value = static_cast<int>(classes.size() - 1);
+    return addNode(node);
+}
+
+/**
+ * @brief Expands a class escape ("\d", "\w", "\s" and their negations)
+ * @param escaped Letter after the backslash
+ * @param set Byte set the class is added to
+ * @return bool True if the letter names a class, false otherwise
+ */
+bool LineRegex::parseClassEscape(char escaped, std::bitset<256>& set) {
+    std::bitset<256> members;
+    switch (std::tolower(static_cast<unsigned char>(escaped))) {
+        case 'd':
+            for (int c = '0'; c <= '9'; c++) members[c] = true;
+            break;
+        case 'w':
+            for (int c = 0; c < 256; c++) members[c] = isWordByte(static_cast<unsigned char>(c));
+            break;
+        case 's':
+            for (int c = '\t'; c <= '\r'; c++) members[c] = true;
+            members[' '] = true;
+            break;
+        default:
+            return false;
+    }
+    if (std::isupper(static_cast<unsigned char>(escaped))) members.flip();
+    set |= members;
+    return true;
+}
+
+/**
+ * @brief Decodes an escape that stands for one byte (control, "\0", "\xHH", "\uHHHH", "\cX")
+ * @param escaped Letter after the backslash (its operand follows at pos)
+ * @param value Reference to receive the byte
+ * @return bool True if the escape stands for a single byte, false otherwise
+ */
+bool LineRegex::parseCharEscape(char escaped, unsigned char& value) {
+    unsigned code;
+    switch (escaped) {
+        case 't': value = '\t'; return true;
+        case 'n': value = '\n'; return true;
+        case 'r': value = '\r'; return true;
+        case 'f': value = '\f'; return true;
+        case 'v': value = '\v'; return true;
+        case '0':
+            value = 0;
+            return pos >= source.size() || !std::isdigit(static_cast<unsigned char>(source[pos]));
+        case 'x':
+            if (!parseHex(source, pos, 2, code)) return false;
+            value = static_cast<unsigned char>(code);
+            return true;
+        case 'u':
+            // Lines are matched byte by byte, so only code points of one byte are supported
+            if (!parseHex(source, pos, 4, code) || code > 0xFF) return false;
+            value = static_cast<unsigned char>(code);
+            return true;
+        case 'c':
+            if (pos >= source.size() || !std::isalpha(static_cast<unsigned char>(source[pos]))) return false;
+            value = static_cast<unsigned char>(source[pos++] % 32);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Parses a bracket expression after its opening '['
+ * @param set Reference to receive the accepted bytes
+ * @return bool True if the expression is supported and closed, false otherwise
+ */
+bool LineRegex::parseBracket(std::bitset<256>& set) {
+    bool negate = pos < source.size() && source[pos] == '^';
+    if (negate) pos++;
+    // Reads one member; a class escape is merged into set and yields no byte
+    auto member = [&](unsigned char& value, bool& is_class) {
+        is_class = false;
+        char c = source[pos++];
+        if (c == '[' && pos < source.size() &&
+            (source[pos] == ':' || source[pos] == '=' || source[pos] == '.')) {
+            return false;   // POSIX classes inside brackets are left to std::regex
+        }
+        if (c != '\\') {
+            value = static_cast<unsigned char>(c);
+            return true;
+        }
+        if (pos >= source.size()) return false;
+        char escaped = source[pos++];
+        if (parseClassEscape(escaped, set)) {
+            is_class = true;
+            return true;
+        }
+        if (escaped == 'b') {
+            value = '\b';
+            return true;
+        }
+        if (parseCharEscape(escaped, value)) return true;
+        if (std::isalnum(static_cast<unsigned char>(escaped))) return false;
+        value = static_cast<unsigned char>(escaped);
+        return true;
+    };
+
+    while (pos < source.size() && source[pos] != ']') {
+        unsigned char low, high;
+        bool is_class;
+        if (!member(low, is_class)) return false;
+        if (is_class) continue;
+        high = low;
+        if (pos + 1 < source.size() && source[pos] == '-' && source[pos + 1] != ']') {
+            pos++;
+            if (!member(high, is_class) || is_class || high < low) return false;
+        }
+        for (int c = low; c <= high; c++) set[c] = true;
+    }
+    if (pos >= source.size()) return false;
+    pos++;
+
+    if (ignore_case) {
+        for (int c = 'a'; c <= 'z'; c++) {
+            if (set[c] || set[c - 'a' + 'A']) {
+                set[c] = true;
+                set[c - 'a' + 'A'] = true;
+            }
+        }
+    }
+    if (negate) set.flip();
+    return true;
+}
+
+/**
+ * @brief Parses alternatives separated by '|'
+ * @param depth Group nesting depth
+ * @return int Index of the node (-1 on failure)
+ */
+int LineRegex::parseAlternation(int depth) {
+    if (depth > MAX_NESTING) return -1;
+    Node node(Node::Kind::Alternate);
+    int first = parseConcat(depth);
+    if (first < 0) return -1;
+    node.children.push_back(first);
+    while (pos < source.size() && source[pos] == '|') {
+        pos++;
+        int next = parseConcat(depth);
+        if (next < 0) return -1;
+        node.children.push_back(next);
+    }
+    return node.children.size() == 1 ? first : addNode(node);
+}
+
+/**
+ * @brief Parses a sequence of quantified atoms
+ * @param depth Group nesting depth
+ * @return int Index of the node (-1 on failure)
+ */
+int LineRegex::parseConcat(int depth) {
+    Node node(Node::Kind::Concat);
+    while (pos < source.size() && source[pos] != '|' && source[pos] != ')') {
+        int child = parseRepeat(depth);
+        if (child < 0) return -1;
+        node.children.push_back(child);
+    }
+    return addNode(node);
+}
+
+/**
+ * @brief Parses an atom with an optional quantifier
+ * @param depth Group nesting depth
+ * @return int Index of the node (-1 on failure)
+ */
+int LineRegex::parseRepeat(int depth) {
+    int atom = parseAtom(depth);
+    if (atom < 0 || pos >= source.size()) return atom;
+
+    Node node(Node::Kind::Repeat);
+    node.children.push_back(atom);
+    char c = source[pos];
+    if (c == '*' || c == '+' || c == '?') {
+        pos++;
+        node.min = c == '+' ? 1 : 0;
+        node.max = c == '?' ? 1 : -1;
+    } else if (c == '{') {
+        pos++;
+        auto number = [&](int& value) {
+            std::size_t start = pos;
+            value = 0;
+            while (pos < source.size() && std::isdigit(static_cast<unsigned char>(source[pos]))) {
+                value = value * 10 + (source[pos++] - '0');
+                if (value > MAX_REPEAT) return false;
+            }
+            return pos > start;
+        };
+        if (!number(node.min)) return -1;
+        node.max = node.min;
+        if (pos < source.size() && source[pos] == ',') {
+            pos++;
+            node.max = -1;
+            if (pos < source.size() && source[pos] != '}' && (!number(node.max) || node.max < node.min)) return -1;
+        }
+        if (pos >= source.size() || source[pos] != '}') return -1;
+        pos++;
+    } else {
+        return atom;
+    }
+    // Lazy quantifiers match the same lines as greedy ones
+    if (pos < source.size() && source[pos] == '?') pos++;
+    return addNode(node);
+}
+
+/**
+ * @brief Parses a literal, class, group or assertion
+ * @param depth Group nesting depth
+ * @return int Index of the node (-1 on failure)
+ */
+int LineRegex::parseAtom(int depth) {
+    char c = source[pos++];
+    std::bitset<256> set;
+    switch (c) {
+        case '(': {
+            if (pos < source.size() && source[pos] == '?') {
+                if (pos + 1 >= source.size() || source[pos + 1] != ':') return -1;   // lookahead
+                pos += 2;
+            }
+            int inner = parseAlternation(depth + 1);
+            if (inner < 0 || pos >= source.size() || source[pos] != ')') return -1;
+            pos++;
+            return inner;
+        }
+        case '[':
+            return parseBracket(set) ? addClass(set) : -1;
+        case '.':
+            set.set();
+            set['\n'] = false;
+            set['\r'] = false;
+            return addClass(set);
+        case '^':
+        case '$': {
+            Node node(Node::Kind::Assert);
+            node.value = static_cast<int>(c == '^' ? Inst::Op::LineStart : Inst::Op::LineEnd);
+            return addNode(node);
+        }
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            return -1;
+        case '\\': {
+            if (pos >= source.size()) return -1;
+            char escaped = source[pos++];
+            if (escaped == 'b' || escaped == 'B') {
+                Node node(Node::Kind::Assert);
+                node.value = static_cast<int>(escaped == 'b' ? Inst::Op::WordBoundary : Inst::Op::NotWordBoundary);
+                return addNode(node);
+            }
+            if (parseClassEscape(escaped, set)) return addClass(set);
+            unsigned char value;
+            if (parseCharEscape(escaped, value)) {
+                set[value] = true;
+                return addClass(set);
+            }
+            // Backreferences and unknown letter escapes
+            if (std::isalnum(static_cast<unsigned char>(escaped))) return -1;
+            set[static_cast<unsigned char>(escaped)] = true;
+            return addClass(set);
+        }
+        default:
+            set[static_cast<unsigned char>(c)] = true;
+            return addClass(set);
+    }
+}
+
+/**
+ * @brief Appends the instructions of a node to the program
+ * @param node Index of the node
+ * @return bool True if the program stays within its size limit, false otherwise
+ */
+bool LineRegex::emit(int node) {
+    if (program.size() > MAX_PROGRAM_SIZE) return false;
+    const Node& n = nodes[node];
+    switch (n.kind) {
+        case Node::Kind::Class:
+            program.push_back({Inst::Op::Class, n.value});
+            return true;
+        case Node::Kind::Assert:
+            program.push_back({static_cast<Inst::Op>(n.value)});
+            return true;
+        case Node::Kind::Concat:
+            for (int child : n.children) {
+                if (!emit(child)) return false;
+            }
+            return true;
+        case Node::Kind::Alternate: {
+            std::vector<std::size_t> jumps;
+            for (std::size_t i = 0; i < n.children.size(); i++) {
+                std::size_t split = program.size();
+                bool last = i + 1 == n.children.size();
+                if (!last) program.push_back({Inst::Op::Split, static_cast<int>(split + 1)});
+                if (!emit(n.children[i])) return false;
+                if (!last) {
+                    jumps.push_back(program.size());
+                    program.push_back({Inst::Op::Jump});
+                    program[split].arg2 = static_cast<int>(program.size());
+                }
+            }
+            for (std::size_t jump : jumps) program[jump].arg = static_cast<int>(program.size());
+            return true;
+        }
+        case Node::Kind::Repeat: {
+            int child = n.children[0];
+            for (int i = 0; i < n.min; i++) {
+                if (!emit(child)) return false;
+            }
+            if (n.max < 0) {
+                std::size_t split = program.size();
+                program.push_back({Inst::Op::Split, static_cast<int>(split + 1)});
+                if (!emit(child)) return false;
+                program.push_back({Inst::Op::Jump, static_cast<int>(split)});
+                program[split].arg2 = static_cast<int>(program.size());
+                return true;
+            }
+            std::vector<std::size_t> splits;
+            for (int i = n.min; i < n.max; i++) {
+                splits.push_back(program.size());
+                program.push_back({Inst::Op::Split, static_cast<int>(program.size() + 1)});
+                if (!emit(child)) return false;
+            }
+            for (std::size_t split : splits) program[split].arg2 = static_cast<int>(program.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Compiles a pattern
+ * @param pattern ECMAScript regular expression
+ * @param ignore_case Match ASCII letters regardless of case
+ * @return bool True if the pattern was compiled, false if it is invalid or not regular
+ */
+bool LineRegex::compile(const std::string& pattern, bool ignore_case) {
+    program.clear();
+    classes.clear();
+    nodes.clear();
+    source = pattern;
+    pos = 0;
+    this->ignore_case = ignore_case;
+
+    int root = parseAlternation(0);
+    bool ok = root >= 0 && pos == source.size() && emit(root) && program.size() <= MAX_PROGRAM_SIZE;
+    nodes.clear();
+    source.clear();
+    if (!ok) {
+        program.clear();
+        return false;
+    }
+    program.push_back({Inst::Op::Match});
+    return true;
+}
+
+/**
+ * @brief Checks whether the pattern matches anywhere in a line
+ * @param line Text of the line without its line end
+ * @return bool True if some substring matches, false otherwise
+ */
+bool LineRegex::search(std::string_view line) const {
+    if (program.empty()) return false;
+    const std::size_t none = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> marks(program.size(), none);
+    std::vector<int> current, next, stack;
+
+    // Follows jumps, splits and assertions from pc at position i; the byte-consuming
+    // states reached are added to list. Returns true once Match is reached.
+    auto addThread = [&](std::vector<int>& list, int start, std::size_t i) {
+        stack.assign(1, start);
+        while (!stack.empty()) {
+            int pc = stack.back();
+            stack.pop_back();
+            if (marks[pc] == i) continue;
+            marks[pc] = i;
+            const Inst& inst = program[pc];
+            bool before = i > 0 && isWordByte(static_cast<unsigned char>(line[i - 1]));
+            bool after = i < line.size() && isWordByte(static_cast<unsigned char>(line[i]));
+            switch (inst.op) {
+                case Inst::Op::Class: list.push_back(pc); break;
+                case Inst::Op::Split: stack.push_back(inst.arg2); stack.push_back(inst.arg); break;
+                case Inst::Op::Jump: stack.push_back(inst.arg); break;
+                case Inst::Op::LineStart: if (i == 0) stack.push_back(pc + 1); break;
+                case Inst::Op::LineEnd: if (i == line.size()) stack.push_back(pc + 1); break;
+                case Inst::Op::WordBoundary: if (before != after) stack.push_back(pc + 1); break;
+                case Inst::Op::NotWordBoundary: if (before == after) stack.push_back(pc + 1); break;
+                case Inst::Op::Match: return true;
+            }
+        }
+        return false;
+    };
+
+    for (std::size_t i = 0;; i++) {
+        // A match may start at every position
+        if (addThread(current, 0, i)) return true;
+        if (i == line.size() || current.empty()) {
+            if (i == line.size()) return false;
+            continue;
+        }
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        next.clear();
+        for (int pc : current) {
+            if (classes[program[pc].arg][c] && addThread(next, pc + 1, i + 1)) return true;
+        }
+        current.swap(next);
+    }
+}
+
+} // namespace vcs
@@ -3,10 +3,26 @@
 #include <vector>
 #include <fstream>
 #include <ctime>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include "constants.h"
 #include "storage.h"
 #include "index.h"
 #include "object.h"
+#include "tree_builder.h"
+#include "checkout.h"
+#include "refs.h"
+#include "commit_graph.h"
+#include "history.h"
+#include "server.h"
+#include "gc.h"
+#include "fsck.h"
+#include "bundle.h"
+#include "rename_detector.h"
+#include "grep.h"
+#include "repack.h"
+#include "merge.h"
 
 namespace vcs {
 
@@ -20,6 +36,23 @@ class VCSController {
 private:
     Storage storage;    ///< Handles object storage operations
     Index index;        ///< Manages staging area (index)
+    Refs refs;          ///< Reads and updates HEAD
+    CommitGraph commit_graph;   ///< Cached commit metadata and changed-path filters
+    TreeGrep tree_grep;         ///< Searches committed trees, caching results between requests
+
+    /**
+     * @brief Reads the whole content of a working file
+     * @param file_path Path to the file to read
+     * @param content Reference to string to receive the content
+     * @return bool True if the file could be read, false otherwise
+     */
+    bool readFile(const std::string& file_path, std::string& content) {
+        std::ifstream file(file_path, std::ios::binary);
+        if (!file.is_open()) return false;
+        content.assign((std::istreambuf_iterator<char>(file)), 
+                       std::istreambuf_iterator<char>());
+        return true;
+    }
 
     /**
      * @brief Gets current timestamp as string
@@ -34,7 +67,7 @@ public:
     /**
      * @brief Constructs VCSController and initializes storage
      */
-    VCSController() {
+    VCSController() : tree_grep(storage) {
         storage.initialize();
     }
 
@@ -52,14 +85,15 @@ public:
      * @return bool True if file added successfully, false otherwise
      */
     bool add(const std::string& file_path) {
-        std::ifstream file(file_path);
-        if (!file.is_open()) {
+        if (!TreeBuilder::isValidPath(file_path)) {
+            std::cerr << "Error: Invalid path " << file_path << std::endl;
+            return false;
+        }
+        std::string content;
+        if (!readFile(file_path, content)) {
             std::cerr << "Error: Cannot open file " << file_path << std::endl;
             return false;
         }
-
-        std::string content((std::istreambuf_iterator<char>(file)), 
-                           std::istreambuf_iterator<char>());
         
         Blob blob(content, file_path);
         if (!storage.storeBlob(blob)) {
@@ -70,6 +104,24 @@ public:
         return index.addFile(file_path, blob.hash);
     }
 
+    /**
+     * @brief Switches the index between a single file and a base plus change log
+     * @param enable True for split mode, false for a single file
+     * @return bool True if the index was rewritten successfully, false otherwise
+     */
+    bool updateIndex(bool enable) {
+        if (!index.setSplit(enable)) {
+            std::cerr << "Error: Failed to rewrite index" << std::endl;
+            return false;
+        }
+        if (enable) {
+            std::cout << "Split index enabled (" << index.baseSize() << " entries in base)" << std::endl;
+        } else {
+            std::cout << "Split index disabled" << std::endl;
+        }
+        return true;
+    }
+
     /**
      * @brief Creates a new commit from staged changes
      * @param message Commit message describing the changes
@@ -82,30 +134,53 @@ public:
             return false;
         }
 
-        // Create tree from staged files
-        Tree tree;
+        // Start from the parent's snapshot so files not restaged are kept
+        std::string parent_hash;
+        std::string parent_tree;
+        if (refs.readHead(parent_hash)) {
+            Commit parent;
+            if (!storage.readCommit(parent_hash, parent)) {
+                std::cerr << "Error: Cannot read HEAD commit " << parent_hash << std::endl;
+                return false;
+            }
+            parent_tree = parent.tree_hash;
+        }
+
+        // Create tree hierarchy from the parent tree and the staged files
+        TreeBuilder builder(storage);
+        if (!parent_tree.empty() && !builder.addTree(parent_tree)) {
+            std::cerr << "Error: Cannot read tree " << parent_tree << std::endl;
+            return false;
+        }
         auto staged_files = index.getStagedFiles();
         for (const auto& file_path : staged_files) {
-            TreeEntry entry;
-            entry.mode = "100644";
-            entry.type = types::BLOB;
-            entry.hash = index.containsFile(file_path) ? "hash_placeholder" : ""; // TODO: Get actual hash
-            entry.name = file_path;
-            tree.addEntry(entry);
-        }
-        tree.hash = tree.calculateHash();
-        
-        if (!storage.storeTree(tree)) {
+            // An index written by an older version may still hold such a path
+            if (!TreeBuilder::isValidPath(file_path)) {
+                std::cerr << "Error: Invalid path " << file_path << " in the index" << std::endl;
+                return false;
+            }
+            IndexEntry entry;
+            if (index.getEntry(file_path, entry) && !builder.addFile(file_path, entry.blob_hash)) {
+                std::cerr << "Error: Cannot read tree for " << file_path << std::endl;
+                return false;
+            }
+        }
+
+        std::string tree_hash;
+        if (!builder.write(tree_hash)) {
             std::cerr << "Error: Failed to store tree" << std::endl;
             return false;
         }
 
-        // Create commit object
+        // Create commit object on top of the current HEAD
         Commit commit;
-        commit.tree_hash = tree.hash;
+        commit.tree_hash = tree_hash;
         commit.author = author;
         commit.message = message;
         commit.timestamp = getCurrentTimestamp();
+        if (!parent_hash.empty()) {
+            commit.parent_hashes.push_back(parent_hash);
+        }
         commit.hash = commit.calculateHash();
 
         if (!storage.storeCommit(commit)) {
@@ -113,12 +188,595 @@ public:
             return false;
         }
 
+        // Record changed paths so path-limited log can skip this commit cheaply
+        std::vector<FileChange> changes;
+        TreeDiff differ(storage);
+        if (differ.diff(parent_tree, commit.tree_hash, changes)) {
+            commit_graph.append(commit.hash, CommitGraph::makeEntry(commit, changes));
+        }
+
+        if (!refs.updateHead(commit.hash)) {
+            std::cerr << "Error: Failed to update HEAD" << std::endl;
+            return false;
+        }
+
         // Clear index after successful commit
         index.clear();
-        std::cout << "Committed: " << message << std::endl;
+        std::cout << "Committed " << commit.hash << ": " << message << std::endl;
+        return true;
+    }
+
+    /**
+     * @brief Restores the files of a commit or tree into the working directory
+     * @param name Hash of a commit or of a tree object, or "HEAD"
+     * @return bool True if every file was restored, false otherwise
+     */
+    bool checkout(const std::string& name) {
+        std::string hash;
+        if (!resolveCommit(name, hash)) {
+            std::cerr << "Error: Cannot resolve " << name << std::endl;
+            return false;
+        }
+        std::string tree_hash = hash;
+        Commit commit;
+        if (storage.readCommit(hash, commit)) {
+            tree_hash = commit.tree_hash;
+        }
+
+        Checkout worker(storage, index);
+        CheckoutStats stats;
+        bool ok = worker.run(tree_hash, ".", stats);
+        if (!ok && stats.failures == 0) {
+            std::cerr << "Error: Cannot read tree " << tree_hash << " or it has unsafe paths" << std::endl;
+            return false;
+        }
+        if (stats.failures > 0) {
+            std::cerr << "Error: Failed to restore " << stats.failures << " files" << std::endl;
+        }
+        std::cout << "Restored " << stats.files_written << " files ("
+                  << stats.bytes_written << " bytes)" << std::endl;
+        return ok;
+    }
+
+    /**
+     * @brief Prints the history of HEAD, optionally limited to a path
+     * @param path Only show commits changing this file or directory (empty for all)
+     * @return bool True if the history could be walked, false otherwise
+     */
+    bool log(const std::string& path) {
+        std::string head;
+        if (!refs.readHead(head)) {
+            std::cerr << "Error: No commits yet" << std::endl;
+            return false;
+        }
+
+        commit_graph.load();
+        History history(storage, commit_graph);
+        std::vector<std::string> commits;
+        HistoryStats stats;
+        if (!history.log(head, path, commits, stats)) {
+            std::cerr << "Error: History is incomplete" << std::endl;
+            return false;
+        }
+
+        for (const auto& hash : commits) {
+            Commit commit;
+            storage.readCommit(hash, commit);
+            std::cout << "commit " << hash << std::endl;
+            std::cout << "    " << commit.message << std::endl;
+        }
+        if (std::getenv("MYVCS_TRACE")) {
+            std::cerr << "trace: commits visited " << stats.commits_visited
+                      << ", skipped by filter " << stats.filter_skipped
+                      << ", trees diffed " << stats.trees_diffed << std::endl;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Prints the file changes between two commits or trees
+     * @param old_name Old commit or tree hash, or "HEAD"
+     * @param new_name New commit or tree hash, or "HEAD"
+     * @param options Rename detection settings (threshold 0 disables detection)
+     * @return bool True if both trees could be compared, false otherwise
+     */
+    bool diff(const std::string& old_name, const std::string& new_name, const RenameOptions& options) {
+        std::string trees[2];
+        const std::string* names[2] = {&old_name, &new_name};
+        for (int i = 0; i < 2; i++) {
+            if (!resolveCommit(*names[i], trees[i])) {
+                std::cerr << "Error: Cannot resolve " << *names[i] << std::endl;
+                return false;
+            }
+            Commit commit;
+            if (storage.readCommit(trees[i], commit)) {
+                trees[i] = commit.tree_hash;
+            }
+        }
+
+        TreeDiff differ(storage);
+        std::vector<FileChange> changes;
+        if (!differ.diff(trees[0], trees[1], changes)) {
+            std::cerr << "Error: Cannot read trees" << std::endl;
+            return false;
+        }
+        if (options.threshold > 0) {
+            RenameDetector detector(storage, options);
+            RenameStats stats;
+            if (!detector.detect(changes, stats)) {
+                std::cerr << "Error: Cannot read blobs for rename detection" << std::endl;
+                return false;
+            }
+        }
+
+        for (const auto& change : changes) {
+            switch (change.kind) {
+                case FileChange::Kind::Added:
+                    std::cout << "A\t" << change.path << std::endl;
+                    break;
+                case FileChange::Kind::Deleted:
+                    std::cout << "D\t" << change.path << std::endl;
+                    break;
+                case FileChange::Kind::Modified:
+                    std::cout << "M\t" << change.path << std::endl;
+                    break;
+                case FileChange::Kind::Renamed:
+                case FileChange::Kind::Copied:
+                    std::cout << (change.kind == FileChange::Kind::Renamed ? "R" : "C")
+                              << change.similarity << "\t" << change.old_path << " -> "
+                              << change.path << std::endl;
+                    break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Searches the files of a commit or tree for a pattern
+     * @param pattern Regular expression (or literal with fixed_strings)
+     * @param name Commit or tree hash, or "HEAD"
+     * @param options Search settings
+     * @param matches Vector receiving the matches in path and line order
+     * @param error Reference to string receiving the reason of a failure
+     * @return bool True if the search completed, false otherwise
+     */
+    bool grep(const std::string& pattern, const std::string& name, const GrepOptions& options,
+              std::vector<GrepMatch>& matches, std::string& error) {
+        std::string tree_hash;
+        Commit commit;
+        if (!resolveCommit(name, tree_hash)) {
+            error = "cannot resolve " + name;
+            return false;
+        }
+        if (storage.readCommit(tree_hash, commit)) {
+            tree_hash = commit.tree_hash;
+        }
+        if (!tree_grep.setPattern(pattern, options)) {
+            error = "invalid pattern " + pattern;
+            return false;
+        }
+        GrepStats stats;
+        if (!tree_grep.search(tree_hash, matches, stats)) {
+            error = "cannot read tree " + tree_hash;
+            return false;
+        }
+        if (stats.lines_skipped > 0) {
+            std::cerr << "Warning: " << stats.lines_skipped << " long lines were not searched "
+                      << "(backreferences and lookahead need short lines)" << std::endl;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Writes a search match as "path:line:text" or "Binary file path matches"
+     * @param match The match
+     * @param out Stream to write to
+     */
+    static void printMatch(const GrepMatch& match, std::ostream& out) {
+        if (match.line_number == 0) {
+            out << "Binary file " << match.path << " matches\n";
+        } else {
+            out << match.path << ":" << match.line_number << ":" << match.line << "\n";
+        }
+    }
+
+    /**
+     * @brief Removes unreachable loose objects older than a grace period
+     * @param grace_seconds Only remove objects older than this many seconds
+     * @param dry_run Report what would be removed without deleting anything
+     * @return bool True if the collection completed, false otherwise
+     */
+    bool gc(std::int64_t grace_seconds, bool dry_run) {
+        GarbageCollector collector(storage);
+        GcStats stats;
+        bool ok = collector.run(grace_seconds, dry_run, stats);
+        storage.refresh();
+
+        std::cout << (dry_run ? "Would remove " : "Removed ") << stats.removed
+                  << " unreachable objects, " << stats.bytes_reclaimed << " bytes ("
+                  << stats.reachable << " reachable, " << stats.kept_recent
+                  << " kept within grace period)" << std::endl;
+        if (stats.missing > 0) {
+            std::cerr << "Error: " << stats.missing << " referenced objects are missing"
+                      << (dry_run ? "" : ", nothing was removed") << std::endl;
+        } else if (!ok) {
+            std::cerr << "Error: Some objects could not be removed" << std::endl;
+        }
+        return ok && stats.missing == 0;
+    }
+
+    /**
+     * @brief Lists the alternate object directories, or adds one
+     * @param path Objects directory to add (empty to only list)
+     * @return bool True if the alternate could be added, false otherwise
+     */
+    bool alternates(const std::string& path) {
+        if (!path.empty() && !storage.addAlternate(path)) {
+            std::cerr << "Error: Cannot use " << path << " as an alternate object directory" << std::endl;
+            return false;
+        }
+        for (const auto& alternate : storage.getAlternates()) {
+            std::cout << alternate->getObjectsPath() << std::endl;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Packs reachable loose objects, locally or into the shared alternate
+     * @param shared Move objects into the first alternate
+     * @return bool True if the repack completed, false otherwise
+     */
+    bool repack(bool shared) {
+        if (shared && storage.getAlternates().empty()) {
+            std::cerr << "Error: No alternate object directory configured" << std::endl;
+            return false;
+        }
+        Repacker repacker(storage);
+        RepackStats stats;
+        bool ok = repacker.run(shared, stats);
+        std::cout << "Packed " << stats.packed << " of " << stats.reachable << " reachable objects ("
+                  << stats.bytes << " bytes)" << (shared ? " into the shared store" : "")
+                  << ", removed " << stats.loose_removed << " loose objects and "
+                  << stats.packs_removed << " packs" << std::endl;
+        if (!ok) {
+            std::cerr << "Error: Repack did not complete" << std::endl;
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Verifies hashes of all objects and the references between them
+     * @return bool True if the repository is intact, false otherwise
+     */
+    bool fsck() {
+        IntegrityChecker checker(storage);
+        FsckReport report;
+        bool ok = checker.run(report, &std::cerr);
+
+        for (const auto& hash : report.corrupt) {
+            std::cout << "corrupt " << hash << std::endl;
+        }
+        for (const auto& link : report.missing) {
+            std::cout << "missing " << link.expected_type << " " << link.hash
+                      << " (referenced by " << link.referrer << ")" << std::endl;
+        }
+        for (const auto& path : report.bad_packs) {
+            std::cout << "bad pack " << path << std::endl;
+        }
+        double mb = report.bytes / (1024.0 * 1024.0);
+        std::cout << "Checked " << report.objects << " objects, " << report.bytes << " bytes in "
+                  << report.seconds << " s (" << (report.seconds > 0 ? mb / report.seconds : 0)
+                  << " MB/s): " << report.corrupt.size() << " corrupt, "
+                  << report.missing.size() << " missing" << std::endl;
+        return ok;
+    }
+
+    /**
+     * @brief Resolves "HEAD" to the current commit, leaving other names unchanged
+     * @param name Commit hash or "HEAD"
+     * @param hash Reference to string to receive the commit hash
+     * @return bool True if the name could be resolved, false otherwise
+     */
+    bool resolveCommit(const std::string& name, std::string& hash) {
+        if (name != "HEAD") {
+            hash = name;
+            return true;
+        }
+        return refs.readHead(hash);
+    }
+
+    /**
+     * @brief Writes a bundle for a commit range
+     *
+     * Ranges are "<tip>" or "<have>..<tip>"; further "^<have>" arguments
+     * exclude more commits the receiver already has.
+     *
+     * @param file_path Path of the bundle file to create
+     * @param ranges Range arguments from the command line
+     * @return bool True if the bundle was written, false otherwise
+     */
+    bool bundleCreate(const std::string& file_path, const std::vector<std::string>& ranges) {
+        std::vector<std::string> tips, haves;
+        for (const auto& range : ranges) {
+            std::string hash;
+            std::size_t dots = range.find("..");
+            bool ok;
+            if (!range.empty() && range[0] == '^') {
+                ok = resolveCommit(range.substr(1), hash);
+                haves.push_back(hash);
+            } else if (dots != std::string::npos) {
+                ok = resolveCommit(range.substr(0, dots), hash);
+                haves.push_back(hash);
+                ok = ok && resolveCommit(range.substr(dots + 2), hash);
+                tips.push_back(hash);
+            } else {
+                ok = resolveCommit(range, hash);
+                tips.push_back(hash);
+            }
+            if (!ok) {
+                std::cerr << "Error: Cannot resolve " << range << std::endl;
+                return false;
+            }
+        }
+        if (tips.empty()) {
+            std::cerr << "Error: No tip commit specified" << std::endl;
+            return false;
+        }
+
+        Bundle bundle(storage);
+        BundleStats stats;
+        if (!bundle.create(file_path, tips, haves, stats)) {
+            std::cerr << "Error: Cannot create bundle " << file_path << std::endl;
+            return false;
+        }
+        std::cout << "Wrote " << stats.objects << " objects, " << stats.bytes
+                  << " bytes to " << file_path << std::endl;
+        return true;
+    }
+
+    /**
+     * @brief Ingests a bundle into a new pack
+     * @param file_path Path of the bundle file to read
+     * @param update_head Also move HEAD to the bundle's first tip if it descends from HEAD
+     * @return bool True if the bundle was ingested (and HEAD moved if asked), false otherwise
+     */
+    bool unbundle(const std::string& file_path, bool update_head) {
+        Bundle bundle(storage);
+        BundleStats stats;
+        std::vector<std::string> tips, missing, incomplete;
+        if (!bundle.unbundle(file_path, tips, missing, incomplete, stats)) {
+            for (const auto& hash : missing) {
+                std::cerr << "Error: Missing prerequisite commit " << hash << std::endl;
+            }
+            for (const auto& hash : incomplete) {
+                std::cerr << "Error: Bundle tips need missing object " << hash << std::endl;
+            }
+            if (missing.empty() && incomplete.empty()) {
+                std::cerr << "Error: Cannot read bundle " << file_path << std::endl;
+            }
+            return false;
+        }
+        std::cout << "Unpacked " << stats.objects << " objects, " << stats.bytes << " bytes ("
+                  << stats.skipped << " already present)" << std::endl;
+        for (const auto& tip : tips) {
+            std::cout << "tip " << tip << std::endl;
+        }
+        if (!update_head || tips.empty()) return true;
+
+        // Only fast-forward: moving HEAD to an unrelated tip would orphan its history
+        std::string head;
+        if (refs.readHead(head) && head != tips.front()) {
+            commit_graph.load();
+            History history(storage, commit_graph);
+            bool descends;
+            if (!history.isAncestor(head, tips.front(), descends)) {
+                std::cerr << "Error: History of " << tips.front() << " is incomplete" << std::endl;
+                return false;
+            }
+            if (!descends) {
+                std::cerr << "Error: " << tips.front() << " does not descend from HEAD " << head
+                          << "; HEAD not updated" << std::endl;
+                return false;
+            }
+        }
+        if (!refs.updateHead(tips.front())) {
+            std::cerr << "Error: Failed to update HEAD" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Merges two commits in memory and records a merge commit
+     *
+     * Neither the working directory nor the index is touched. Conflicts are
+     * listed as "conflict <kind> <path>" and no commit is created. If one
+     * side already contains the other, no commit is created either: theirs
+     * is reported as merged already, or ours is fast-forwarded to theirs.
+     *
+     * @param ours_name Our commit hash or "HEAD"
+     * @param theirs_name Their commit hash or "HEAD"
+     * @param message Commit message (a default one if empty)
+     * @param update_head Also move HEAD, which must be ours, to the result
+     * @return bool True if the merge was clean (committed, up to date or fast-forwarded), false otherwise
+     */
+    bool mergeTree(const std::string& ours_name, const std::string& theirs_name,
+                   const std::string& message, bool update_head) {
+        std::string ours, theirs;
+        if (!resolveCommit(ours_name, ours) || !resolveCommit(theirs_name, theirs)) {
+            std::cerr << "Error: Cannot resolve commits to merge" << std::endl;
+            return false;
+        }
+
+        // HEAD may only move from ours; merging elsewhere would drop HEAD's history
+        std::string head;
+        if (update_head && (!refs.readHead(head) || head != ours)) {
+            std::cerr << "Error: --update-head requires " << ours_name << " to be HEAD" << std::endl;
+            return false;
+        }
+
+        commit_graph.load();
+        TreeMerger merger(storage, &commit_graph);
+        std::string base;
+        if (!merger.findMergeBase(ours, theirs, base)) {
+            std::cerr << "Error: Cannot merge " << ours << " and " << theirs << std::endl;
+            return false;
+        }
+        if (base == theirs) {
+            std::cout << "Already up to date" << std::endl;
+            return true;
+        }
+        if (base == ours) {
+            // Their history contains ours: no merge commit is needed
+            if (update_head && !refs.updateHead(theirs)) {
+                std::cerr << "Error: Failed to update HEAD" << std::endl;
+                return false;
+            }
+            std::cout << "Fast-forward " << ours << ".." << theirs << std::endl;
+            return true;
+        }
+
+        MergeResult result;
+        MergeStats stats;
+        if (!merger.merge(ours, theirs, base, result, stats)) {
+            std::cerr << "Error: Cannot merge " << ours << " and " << theirs << std::endl;
+            return false;
+        }
+        std::cout << "base " << (result.base_hash.empty() ? "none" : result.base_hash) << std::endl;
+        std::cout << "tree " << result.tree_hash << std::endl;
+        if (!result.conflicts.empty()) {
+            static const char* kinds[] = {"content", "binary", "modify/delete", "file/directory"};
+            for (const auto& conflict : result.conflicts) {
+                std::cout << "conflict " << kinds[static_cast<int>(conflict.kind)] << " "
+                          << conflict.path << std::endl;
+            }
+            std::cerr << "Error: Merge has " << result.conflicts.size() << " conflicts" << std::endl;
+            return false;
+        }
+
+        Commit commit;
+        commit.tree_hash = result.tree_hash;
+        commit.parent_hashes = {ours, theirs};
+        commit.author = "user";
+        commit.message = message.empty() ? "Merge " + theirs + " into " + ours : message;
+        commit.timestamp = getCurrentTimestamp();
+        commit.hash = commit.calculateHash();
+        if (!storage.storeCommit(commit)) {
+            std::cerr << "Error: Failed to store commit" << std::endl;
+            return false;
+        }
+
+        // Changed paths are recorded against the first parent, as for ordinary commits
+        Commit parent;
+        std::vector<FileChange> changes;
+        TreeDiff differ(storage);
+        if (storage.readCommit(ours, parent) && differ.diff(parent.tree_hash, commit.tree_hash, changes)) {
+            commit_graph.append(commit.hash, CommitGraph::makeEntry(commit, changes));
+        }
+
+        if (update_head && !refs.updateHead(commit.hash)) {
+            std::cerr << "Error: Failed to update HEAD" << std::endl;
+            return false;
+        }
+        std::cout << "Merged " << commit.hash << " (" << stats.trees_read << " trees read, "
+                  << stats.subtrees_skipped << " subtrees skipped, " << stats.blobs_merged
+                  << " files merged)" << std::endl;
         return true;
     }
 
+    /**
+     * @brief Executes one batch request and writes its reply
+     *
+     * Requests are "add <path>", "hash-object <path>", "cat-object <hash>",
+     * "exists <hash>", "grep <pattern>" (searches HEAD), "status" and "quit".
+     * Failures are answered with
+     * "error <message>" so a client can keep reading one reply per request.
+     *
+     * @param line The request line
+     * @param out Stream to write the reply to
+     * @return bool False if the request asks to stop serving, true otherwise
+     */
+    bool handleRequest(const std::string& line, std::ostream& out) {
+        std::size_t space = line.find(' ');
+        std::string command = line.substr(0, space);
+        std::string arg = space == std::string::npos ? "" : line.substr(space + 1);
+
+        // Pick up objects and index changes made by other processes since the last request
+        storage.refresh();
+        index.refresh();
+
+        if (command == "add" || command == "hash-object") {
+            if (command == "add" && !TreeBuilder::isValidPath(arg)) {
+                out << "error invalid path " << arg << "\n";
+                return true;
+            }
+            std::string content;
+            if (!readFile(arg, content)) {
+                out << "error cannot open " << arg << "\n";
+                return true;
+            }
+            Blob blob(content, arg);
+            if (command == "add" &&
+                (!storage.storeBlob(blob) || !index.addFile(arg, blob.hash))) {
+                out << "error cannot add " << arg << "\n";
+                return true;
+            }
+            out << blob.hash << "\n";
+        }
+        else if (command == "cat-object") {
+            std::string data;
+            if (!storage.readObject(arg, data)) {
+                out << arg << " missing\n";
+                return true;
+            }
+            out << arg << " " << data.size() << "\n";
+            out.write(data.data(), data.size());
+            out << "\n";
+        }
+        else if (command == "exists") {
+            out << (storage.objectExists(arg) ? "yes" : "no") << "\n";
+        }
+        else if (command == "grep") {
+            std::vector<GrepMatch> matches;
+            std::string error;
+            if (!grep(arg, "HEAD", GrepOptions(), matches, error)) {
+                out << "error " << error << "\n";
+                return true;
+            }
+            out << "matches " << matches.size() << "\n";
+            for (const auto& match : matches) {
+                printMatch(match, out);
+            }
+        }
+        else if (command == "status") {
+            auto staged_files = index.getStagedFiles();
+            out << "staged " << staged_files.size() << "\n";
+            for (const auto& file : staged_files) {
+                out << file << "\n";
+            }
+        }
+        else if (command == "quit") {
+            return false;
+        }
+        else {
+            out << "error unknown command " << command << "\n";
+        }
+        return true;
+    }
+
+    /**
+     * @brief Prints object lookup counters to stderr when MYVCS_TRACE is set
+     */
+    void printTrace() const {
+        if (!std::getenv("MYVCS_TRACE")) return;
+        StorageCounters counters = storage.getCounters();
+        std::cerr << "trace: object lookups " << counters.lookups
+                  << ", bloom negatives " << counters.bloom_negatives
+                  << ", disk probes " << counters.disk_probes
+                  << ", false positives " << counters.false_positives
+                  << ", index scans " << counters.index_scans << std::endl;
+    }
+
     /**
      * @brief Shows current status of the staging area
      * 
@@ -142,7 +800,22 @@ void printUsage() {
     std::cout << "  init    - Initialize repository" << std::endl;
     std::cout << "  add     - Add file to index" << std::endl;
     std::cout << "  commit  - Create commit" << std::endl;
+    std::cout << "  update-index --split-index | --no-split-index - Keep index changes in a small log" << std::endl;
     std::cout << "  status  - Show status" << std::endl;
+    std::cout << "  log [-- <path>] - Show commit history" << std::endl;
+    std::cout << "  diff [-M<percent>] [-C] [--no-renames] <old> <new> - Show changes with renames and copies" << std::endl;
+    std::cout << "  grep [-i] [-F] <pattern> [<commit>] - Search files of a commit without checking it out" << std::endl;
+    std::cout << "  merge-tree [-m <message>] [--update-head] <ours> <theirs> - Merge two commits without touching files" << std::endl;
+    std::cout << "  checkout <hash> - Restore files of a commit or tree (alias: restore)" << std::endl;
+    std::cout << "  hash-object <file> | cat-object <hash> | exists <hash> - Inspect objects" << std::endl;
+    std::cout << "  gc [--prune=<seconds>] [--dry-run] - Remove unreachable objects" << std::endl;
+    std::cout << "  fsck    - Verify object hashes and connectivity" << std::endl;
+    std::cout << "  alternates [add <objects-dir>] - List or add shared object directories" << std::endl;
+    std::cout << "  repack [--shared] - Pack reachable objects (into the first alternate with --shared)" << std::endl;
+    std::cout << "  bundle create <file> <range>... - Write commits and their objects to one file" << std::endl;
+    std::cout << "  bundle unbundle <file> [--update-head] - Ingest a bundle into a pack" << std::endl;
+    std::cout << "  batch   - Answer newline-delimited requests from stdin" << std::endl;
+    std::cout << "  serve <socket> - Answer requests on a Unix socket until \"quit\"" << std::endl;
 }
 
 } // namespace vcs
@@ -172,23 +845,232 @@ int main(int argc, char* argv[]) {
             std::cerr << "Error: No file specified" << std::endl;
             return 1;
         }
-        controller.add(argv[2]);
+        if (!controller.add(argv[2])) {
+            return 1;
+        }
     }
     else if (command == "commit") {
         if (argc < 3) {
             std::cerr << "Error: No commit message specified" << std::endl;
             return 1;
         }
-        controller.commit(argv[2]);
+        if (!controller.commit(argv[2])) {
+            return 1;
+        }
+    }
+    else if (command == "update-index") {
+        std::string option = argc >= 3 ? argv[2] : "";
+        if (option != "--split-index" && option != "--no-split-index") {
+            std::cerr << "Error: Specify --split-index or --no-split-index" << std::endl;
+            return 1;
+        }
+        if (!controller.updateIndex(option == "--split-index")) {
+            return 1;
+        }
     }
     else if (command == "status") {
         controller.status();
     }
+    else if (command == "log") {
+        std::string path;
+        if (argc >= 4 && std::string(argv[2]) == "--") {
+            path = argv[3];
+        }
+        if (!controller.log(path)) {
+            return 1;
+        }
+    }
+    else if (command == "diff") {
+        vcs::RenameOptions options;
+        std::vector<std::string> names;
+        for (int i = 2; i < argc; i++) {
+            std::string option = argv[i];
+            if (option.compare(0, 2, "-M") == 0) {
+                if (option.size() > 2) {
+                    char* end = nullptr;
+                    double percent = std::strtod(option.c_str() + 2, &end);
+                    if (*end != '\0' || !(percent > 0 && percent <= 100)) {
+                        std::cerr << "Error: Invalid similarity " << option << ", expected -M<1-100>" << std::endl;
+                        return 1;
+                    }
+                    options.threshold = percent / 100;
+                }
+            } else if (option == "-C") {
+                options.find_copies = true;
+            } else if (option == "--no-renames") {
+                options.threshold = 0;
+            } else {
+                names.push_back(option);
+            }
+        }
+        if (names.size() != 2) {
+            std::cerr << "Error: Specify two commits or trees" << std::endl;
+            return 1;
+        }
+        if (!controller.diff(names[0], names[1], options)) {
+            return 1;
+        }
+    }
+    else if (command == "grep") {
+        vcs::GrepOptions options;
+        std::vector<std::string> args;
+        for (int i = 2; i < argc; i++) {
+            std::string option = argv[i];
+            if (option == "-i") {
+                options.ignore_case = true;
+            } else if (option == "-F") {
+                options.fixed_strings = true;
+            } else {
+                args.push_back(option);
+            }
+        }
+        if (args.empty() || args.size() > 2) {
+            std::cerr << "Error: Usage: grep [-i] [-F] <pattern> [<commit>]" << std::endl;
+            return 1;
+        }
+        std::vector<vcs::GrepMatch> matches;
+        std::string error;
+        if (!controller.grep(args[0], args.size() > 1 ? args[1] : "HEAD", options, matches, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        for (const auto& match : matches) {
+            vcs::VCSController::printMatch(match, std::cout);
+        }
+        if (matches.empty()) {
+            return 1;
+        }
+    }
+    else if (command == "checkout" || command == "restore") {
+        if (argc < 3) {
+            std::cerr << "Error: No commit or tree specified" << std::endl;
+            return 1;
+        }
+        if (!controller.checkout(argv[2])) {
+            return 1;
+        }
+    }
+    else if (command == "hash-object" || command == "cat-object" || command == "exists") {
+        if (argc < 3) {
+            std::cerr << "Error: No argument specified" << std::endl;
+            return 1;
+        }
+        controller.handleRequest(command + " " + argv[2], std::cout);
+    }
+    else if (command == "gc") {
+        std::int64_t grace = vcs::GarbageCollector::DEFAULT_GRACE_SECONDS;
+        bool dry_run = false;
+        for (int i = 2; i < argc; i++) {
+            std::string option = argv[i];
+            if (option == "--dry-run") {
+                dry_run = true;
+            } else if (option.compare(0, 8, "--prune=") == 0) {
+                const char* value = option.c_str() + 8;
+                char* end = nullptr;
+                errno = 0;
+                grace = std::strtoll(value, &end, 10);
+                // Digits only: strtoll would also take signs, spaces and a number prefix like "2.weeks"
+                if (!std::isdigit(static_cast<unsigned char>(*value)) || *end != '\0' || errno == ERANGE) {
+                    std::cerr << "Error: Invalid prune " << option << ", expected --prune=<seconds>" << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: Unknown option " << option << std::endl;
+                return 1;
+            }
+        }
+        if (!controller.gc(grace, dry_run)) {
+            return 1;
+        }
+    }
+    else if (command == "merge-tree") {
+        std::string message;
+        bool update_head = false;
+        std::vector<std::string> commits;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "-m" && i + 1 < argc) {
+                message = argv[++i];
+            } else if (arg == "--update-head") {
+                update_head = true;
+            } else {
+                commits.push_back(arg);
+            }
+        }
+        if (commits.size() != 2) {
+            std::cerr << "Error: Usage: merge-tree [-m <message>] [--update-head] <ours> <theirs>" << std::endl;
+            return 1;
+        }
+        if (!controller.mergeTree(commits[0], commits[1], message, update_head)) {
+            return 1;
+        }
+    }
+    else if (command == "fsck") {
+        if (!controller.fsck()) {
+            return 1;
+        }
+    }
+    else if (command == "alternates") {
+        std::string path;
+        if (argc >= 3) {
+            if (std::string(argv[2]) != "add" || argc < 4) {
+                std::cerr << "Error: Usage: alternates [add <objects-dir>]" << std::endl;
+                return 1;
+            }
+            path = argv[3];
+        }
+        if (!controller.alternates(path)) {
+            return 1;
+        }
+    }
+    else if (command == "repack") {
+        bool shared = argc >= 3 && std::string(argv[2]) == "--shared";
+        if (argc >= 3 && !shared) {
+            std::cerr << "Error: Unknown option " << argv[2] << std::endl;
+            return 1;
+        }
+        if (!controller.repack(shared)) {
+            return 1;
+        }
+    }
+    else if (command == "bundle") {
+        std::string action = argc >= 3 ? argv[2] : "";
+        if ((action != "create" && action != "unbundle") || argc < 4) {
+            std::cerr << "Error: Usage: bundle create <file> <range>... | bundle unbundle <file>" << std::endl;
+            return 1;
+        }
+        bool ok;
+        if (action == "create") {
+            ok = controller.bundleCreate(argv[3], std::vector<std::string>(argv + 4, argv + argc));
+        } else {
+            ok = controller.unbundle(argv[3], argc >= 5 && std::string(argv[4]) == "--update-head");
+        }
+        if (!ok) {
+            return 1;
+        }
+    }
+    else if (command == "batch" || command == "serve") {
+        vcs::CommandServer server([&controller](const std::string& line, std::ostream& out) {
+            return controller.handleRequest(line, out);
+        });
+        if (command == "batch") {
+            server.serveStream(std::cin, std::cout);
+        } else {
+            if (argc < 3) {
+                std::cerr << "Error: No socket path specified" << std::endl;
+                return 1;
+            }
+            if (!server.serveSocket(argv[2])) {
+                return 1;
+            }
+        }
+    }
     else {
         std::cerr << "Unknown command: " << command << std::endl;
         vcs::printUsage();
         return 1;
     }
 
+    controller.printTrace();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,572 @@
+#include "merge.h"
+#include "constants.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace vcs {
+
+/**
+ * @brief Edit distance beyond which a line diff gives up and treats the middle as replaced
+ */
+static const int MAX_DIFF_COST = 4096;
+
+/**
+ * @brief Bytes inspected for NUL when deciding whether a blob is binary
+ */
+static const std::size_t BINARY_PROBE_SIZE = 8000;
+
+/**
+ * @brief Splits text into lines, each keeping its line end
+ * @param text The text
+ * @return std::vector<std::string_view> Lines (the last one may lack a line end)
+ */
+static std::vector<std::string_view> splitLines(const std::string& text) {
+    std::vector<std::string_view> lines;
+    std::size_t start = 0;
+    while (start < text.size()) {
+        std::size_t end = text.find('\n', start);
+        end = end == std::string::npos ? text.size() : end + 1;
+        lines.emplace_back(text.data() + start, end - start);
+        start = end;
+    }
+    return lines;
+}
+
+/**
+ * @brief Finds a longest common subsequence of two line sequences (Myers' O(ND) diff)
+ *
+ * Common leading and trailing lines are matched first; if the middle needs
+ * more than MAX_DIFF_COST edits it is treated as entirely replaced.
+ *
+ * @param a First sequence
+ * @param b Second sequence
+ * @return std::vector<std::pair<int, int>> Matched index pairs in increasing order
+ */
+static std::vector<std::pair<int, int>> matchLines(const std::vector<std::string_view>& a,
+                                                   const std::vector<std::string_view>& b) {
+    int n = static_cast<int>(a.size());
+    int m = static_cast<int>(b.size());
+    int prefix = 0;
+    while (prefix < n && prefix < m && a[prefix] == b[prefix]) prefix++;
+    int suffix = 0;
+    while (suffix < n - prefix && suffix < m - prefix && a[n - 1 - suffix] == b[m - 1 - suffix]) suffix++;
+
+    std::vector<std::pair<int, int>> matches;
+    for (int i = 0; i < prefix; i++) matches.emplace_back(i, i);
+
+    // Myers over the middle part, keeping the frontier of every round for backtracking
+    int N = n - prefix - suffix;
+    int M = m - prefix - suffix;
+    auto equal = [&](int x, int y) { return a[prefix + x] == b[prefix + y]; };
+    int limit = std::min(N + M, MAX_DIFF_COST);
+    std::vector<int> v(2 * limit + 3, 0);
+    const int offset = limit + 1;
+    std::vector<std::vector<int>> trace;
+    int found = -1;
+    for (int d = 0; d <= limit && found < 0 && N + M > 0; d++) {
+        std::vector<int> round(2 * d + 1);
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                        ? v[offset + k + 1] : v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < N && y < M && equal(x, y)) {
+                x++;
+                y++;
+            }
+            v[offset + k] = x;
+            round[k + d] = x;
+            if (x >= N && y >= M) found = d;
+        }
+        trace.push_back(std::move(round));
+    }
+
+    std::vector<std::pair<int, int>> middle;
+    if (found >= 0) {
+        int x = N, y = M;
+        for (int d = found; d > 0; d--) {
+            const std::vector<int>& previous = trace[d - 1];
+            int k = x - y;
+            auto at = [&](int kk) { return previous[kk + d - 1]; };
+            int prev_k = (k == -d || (k != d && at(k - 1) < at(k + 1))) ? k + 1 : k - 1;
+            int prev_x = at(prev_k);
+            int prev_y = prev_x - prev_k;
+            while (x > prev_x && y > prev_y) {
+                middle.emplace_back(x - 1, y - 1);
+                x--;
+                y--;
+            }
+            x = prev_x;
+            y = prev_y;
+        }
+        while (x > 0 && y > 0) {
+            middle.emplace_back(x - 1, y - 1);
+            x--;
+            y--;
+        }
+        std::reverse(middle.begin(), middle.end());
+    }
+    for (const auto& match : middle) matches.emplace_back(prefix + match.first, prefix + match.second);
+    for (int i = suffix; i > 0; i--) matches.emplace_back(n - i, m - i);
+    return matches;
+}
+
+/**
+ * @brief Merges text line by line against a common base
+ * @param base Base version
+ * @param ours Our version
+ * @param theirs Their version
+ * @param ours_label Label after the "<<<<<<<" marker
+ * @param theirs_label Label after the ">>>>>>>" marker
+ * @param merged Reference to string receiving the result
+ * @return bool True if the merge is clean, false if conflict markers were written
+ */
+bool TreeMerger::mergeText(const std::string& base, const std::string& ours, const std::string& theirs,
+                           const std::string& ours_label, const std::string& theirs_label,
+                           std::string& merged) {
+    std::vector<std::string_view> b = splitLines(base), o = splitLines(ours), t = splitLines(theirs);
+    int nb = static_cast<int>(b.size()), no = static_cast<int>(o.size()), nt = static_cast<int>(t.size());
+
+    // For every base line, the matching line on each side (-1 if changed there)
+    std::vector<int> in_ours(nb, -1), in_theirs(nb, -1);
+    for (const auto& match : matchLines(b, o)) in_ours[match.first] = match.second;
+    for (const auto& match : matchLines(b, t)) in_theirs[match.first] = match.second;
+
+    auto append = [&merged](const std::vector<std::string_view>& lines, int from, int to) {
+        for (int i = from; i < to; i++) merged.append(lines[i].data(), lines[i].size());
+    };
+    auto sameLines = [](const std::vector<std::string_view>& x, int x_from, int x_to,
+                        const std::vector<std::string_view>& y, int y_from, int y_to) {
+        return x_to - x_from == y_to - y_from && std::equal(x.begin() + x_from, x.begin() + x_to, y.begin() + y_from);
+    };
+    auto endLine = [&merged]() {
+        if (!merged.empty() && merged.back() != '\n') merged.push_back('\n');
+    };
+
+    merged.clear();
+    bool clean = true;
+    int i = 0, j = 0, k = 0;
+    while (i < nb || j < no || k < nt) {
+        // Stable run: the base lines are unchanged on both sides
+        int run = 0;
+        while (i + run < nb && in_ours[i + run] == j + run && in_theirs[i + run] == k + run) run++;
+        if (run > 0) {
+            append(b, i, i + run);
+            i += run;
+            j += run;
+            k += run;
+            continue;
+        }
+
+        // Unstable chunk up to the next base line kept by both sides
+        int next = i;
+        while (next < nb && (in_ours[next] < 0 || in_theirs[next] < 0)) next++;
+        int o_end = next < nb ? in_ours[next] : no;
+        int t_end = next < nb ? in_theirs[next] : nt;
+
+        if (sameLines(b, i, next, o, j, o_end)) {
+            append(t, k, t_end);
+        } else if (sameLines(b, i, next, t, k, t_end) || sameLines(o, j, o_end, t, k, t_end)) {
+            append(o, j, o_end);
+        } else {
+            clean = false;
+            endLine();
+            merged += "<<<<<<< " + ours_label + "\n";
+            append(o, j, o_end);
+            endLine();
+            merged += "=======\n";
+            append(t, k, t_end);
+            endLine();
+            merged += ">>>>>>> " + theirs_label + "\n";
+        }
+        i = next;
+        j = o_end;
+        k = t_end;
+    }
+    return clean;
+}
+
+/**
+ * @brief Constructs a TreeMerger working on the given storage
+ * @param storage Storage to read from and write to
+ * @param graph Commit graph used to walk history without reading commits (may be null)
+ */
+TreeMerger::TreeMerger(Storage& storage, const CommitGraph* graph)
+    : storage(storage), graph(graph), commits_walked(0) {}
+
+/**
+ * @brief Merges two versions of a file against their base
+ * @param base Hash of the base blob (empty if absent)
+ * @param ours Hash of our blob
+ * @param theirs Hash of their blob
+ * @param result Reference to receive the merged blob hash
+ * @param clean Reference set to false if conflict markers were written
+ * @param binary Reference set to true if a side is binary (result is ours)
+ * @return bool True if every blob could be read and written, false otherwise
+ */
+bool TreeMerger::mergeBlobs(const std::string& base, const std::string& ours, const std::string& theirs,
+                            std::string& result, bool& clean, bool& binary) {
+    Blob blobs[3] = {Blob(""), Blob(""), Blob("")};
+    const std::string* hashes[3] = {&base, &ours, &theirs};
+    binary = false;
+    for (int i = 0; i < 3; i++) {
+        if (hashes[i]->empty()) continue;
+        if (!storage.readBlob(*hashes[i], blobs[i])) return false;
+        const std::string& content = blobs[i].content;
+        if (std::memchr(content.data(), '\0', std::min(content.size(), BINARY_PROBE_SIZE))) binary = true;
+    }
+    if (binary) {
+        clean = false;
+        result = ours;
+        return true;
+    }
+
+    std::string merged;
+    clean = mergeText(blobs[0].content, blobs[1].content, blobs[2].content, ours_label, theirs_label, merged);
+    Blob blob(merged);
+    if (!storage.storeBlob(blob)) return false;
+    result = blob.hash;
+    return true;
+}
+
+/**
+ * @brief Recursively merges three trees
+ * @param base Hash of the base tree (empty if absent)
+ * @param ours Hash of our tree (empty if absent)
+ * @param theirs Hash of their tree (empty if absent)
+ * @param prefix Path of the trees relative to the root
+ * @param result Reference to receive the merged tree hash (empty if it has no entries)
+ * @param conflicts Vector receiving conflicts
+ * @param stats Reference to MergeStats to update
+ * @return bool True if every object could be read and written, false otherwise
+ */
+bool TreeMerger::mergeTrees(const std::string& base, const std::string& ours, const std::string& theirs,
+                            const std::string& prefix, std::string& result,
+                            std::vector<MergeConflict>& conflicts, MergeStats& stats) {
+    // Equal hashes decide the whole subtree without reading it
+    if (ours == theirs || base == theirs) {
+        result = ours;
+        stats.subtrees_skipped++;
+        return true;
+    }
+    if (base == ours) {
+        result = theirs;
+        stats.subtrees_skipped++;
+        return true;
+    }
+
+    Tree trees[3];
+    const std::string* hashes[3] = {&base, &ours, &theirs};
+    std::map<std::string, std::array<const TreeEntry*, 3>> names;
+    for (int side = 0; side < 3; side++) {
+        if (hashes[side]->empty()) continue;
+        if (!storage.readTree(*hashes[side], trees[side])) return false;
+        stats.trees_read++;
+    }
+    for (int side = 0; side < 3; side++) {
+        for (const auto& entry : trees[side].entries) {
+            auto inserted = names.emplace(entry.name, std::array<const TreeEntry*, 3>{{nullptr, nullptr, nullptr}});
+            inserted.first->second[side] = &entry;
+        }
+    }
+
+    auto same = [](const TreeEntry* x, const TreeEntry* y) {
+        if (!x || !y) return x == y;
+        return x->hash == y->hash && x->type == y->type && x->mode == y->mode;
+    };
+    auto hashOf = [](const TreeEntry* entry) { return entry ? entry->hash : std::string(); };
+
+    std::map<std::string, TreeEntry> merged;
+    for (const auto& pair : names) {
+        const TreeEntry* b = pair.second[0];
+        const TreeEntry* o = pair.second[1];
+        const TreeEntry* t = pair.second[2];
+        std::string path = prefix.empty() ? pair.first : prefix + "/" + pair.first;
+
+        // One side unchanged: take the other (which may be a deletion)
+        const TreeEntry* taken = nullptr;
+        bool decided = true;
+        if (same(o, t) || same(b, t)) {
+            taken = o;
+        } else if (same(b, o)) {
+            taken = t;
+        } else {
+            decided = false;
+        }
+        if (decided) {
+            if (taken) merged[pair.first] = *taken;
+            if (taken && taken->type == types::TREE) stats.subtrees_skipped++;
+            continue;
+        }
+
+        bool b_tree = b && b->type == types::TREE;
+        bool o_tree = o && o->type == types::TREE;
+        bool t_tree = t && t->type == types::TREE;
+        bool o_blob = o && !o_tree;
+        bool t_blob = t && !t_tree;
+
+        if (!o_blob && !t_blob) {
+            std::string subtree;
+            if (!mergeTrees(b_tree ? b->hash : "", o_tree ? o->hash : "", t_tree ? t->hash : "",
+                            path, subtree, conflicts, stats)) {
+                return false;
+            }
+            if (!subtree.empty()) {
+                TreeEntry entry = o ? *o : *t;
+                entry.hash = subtree;
+                merged[pair.first] = entry;
+            }
+        } else if (o_blob && t_blob) {
+            std::string blob_hash;
+            bool clean, binary;
+            if (!mergeBlobs(b && !b_tree ? b->hash : "", o->hash, t->hash, blob_hash, clean, binary)) {
+                return false;
+            }
+            stats.blobs_merged++;
+            TreeEntry entry = *o;
+            entry.hash = blob_hash;
+            merged[pair.first] = entry;
+            if (!clean) {
+                conflicts.push_back({binary ? MergeConflict::Kind::Binary : MergeConflict::Kind::Content,
+                                     path, hashOf(b), o->hash, t->hash});
+            }
+        } else if (!o || !t) {
+            // Modified on one side, deleted on the other: keep the modification
+            merged[pair.first] = o ? *o : *t;
+            conflicts.push_back({MergeConflict::Kind::ModifyDelete, path, hashOf(b), hashOf(o), hashOf(t)});
+        } else {
+            merged[pair.first] = *o;
+            conflicts.push_back({MergeConflict::Kind::FileDirectory, path, hashOf(b), o->hash, t->hash});
+        }
+    }
+
+    if (merged.empty()) {
+        result.clear();
+        return true;
+    }
+    Tree tree;
+    for (const auto& pair : merged) {
+        tree.addEntry(pair.second);
+    }
+    tree.hash = tree.calculateHash();
+    if (!storage.storeTree(tree)) return false;
+    result = tree.hash;
+    return true;
+}
+
+/**
+ * @brief Gets the parents of a commit from the commit graph, or from the commit itself
+ * @param hash Commit hash
+ * @param parents Vector receiving the parent hashes
+ * @return bool True if the commit could be found, false otherwise
+ */
+bool TreeMerger::parentsOf(const std::string& hash, std::vector<std::string>& parents) {
+    const CommitGraphEntry* entry = graph ? graph->find(hash) : nullptr;
+    if (entry) {
+        parents = entry->parent_hashes;
+        return true;
+    }
+    Commit commit;
+    if (!storage.readCommit(hash, commit)) return false;
+    parents = commit.parent_hashes;
+    return true;
+}
+
+/**
+ * @brief Gets the generation number of a commit for ordering walks
+ * @param hash Commit hash
+ * @return std::uint64_t Generation from the commit graph (the maximum if unknown)
+ */
+std::uint64_t TreeMerger::generationOf(const std::string& hash) const {
+    const CommitGraphEntry* entry = graph ? graph->find(hash) : nullptr;
+    // An unnumbered commit may descend from anything, so it is treated as the newest
+    return entry && entry->generation ? entry->generation : UINT64_MAX;
+}
+
+/**
+ * @brief Adds a commit and its ancestors down to a generation to a set
+ * @param start Commit hash to start from
+ * @param min_generation Commits numbered below this are neither added nor walked
+ * @param seen Set receiving the commits; commits already in it are not walked again
+ * @return bool True if all commits could be read, false otherwise
+ */
+bool TreeMerger::collectAncestors(const std::string& start, std::uint64_t min_generation,
+                                  std::unordered_set<std::string>& seen) {
+    if (generationOf(start) < min_generation || !seen.insert(start).second) return true;
+    std::vector<std::string> pending = {start};
+    std::vector<std::string> parents;
+    while (!pending.empty()) {
+        std::string hash = std::move(pending.back());
+        pending.pop_back();
+        commits_walked++;
+        if (!parentsOf(hash, parents)) return false;
+        for (const auto& parent : parents) {
+            if (generationOf(parent) >= min_generation && seen.insert(parent).second) {
+                pending.push_back(parent);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Finds a best common ancestor of two commits
+ *
+ * A best common ancestor is not an ancestor of another common ancestor.
+ * Criss-cross histories have several; the one with the newest timestamp
+ * (then the smallest hash) is chosen.
+ *
+ * @param a First commit hash
+ * @param b Second commit hash
+ * @param base Reference to receive the merge base (empty if there is none)
+ * @return bool True if all commits could be read, false otherwise
+ */
+bool TreeMerger::findMergeBase(const std::string& a, const std::string& b, std::string& base) {
+    base.clear();
+    commits_walked = 0;
+    if (a == b) {
+        base = a;
+        return true;
+    }
+
+    // Commits are painted with the sides that reach them, highest generation
+    // first. A commit reached from both sides is a common ancestor and passes
+    // STALE on to its own ancestors, which cannot be best bases; the walk ends
+    // once only stale commits are queued, so history below the bases is not
+    // read. Paint only ever grows and a commit is queued again when its paint
+    // changes, so the result does not depend on the order (or on timestamps);
+    // generations only make the early stop come sooner.
+    enum : unsigned { FROM_A = 1, FROM_B = 2, STALE = 4, CANDIDATE = 8 };
+    std::unordered_map<std::string, unsigned> paint = {{a, FROM_A}, {b, FROM_B}};
+    std::set<std::pair<std::uint64_t, std::string>> queue = {{generationOf(a), a}, {generationOf(b), b}};
+    std::size_t active = 2;     // Queued commits that are not stale
+    std::vector<std::string> candidates, parents;
+    while (active > 0) {
+        auto top = std::prev(queue.end());
+        std::string hash = top->second;
+        queue.erase(top);
+        commits_walked++;
+        unsigned flags = paint[hash];
+        if (!(flags & STALE)) active--;
+        if ((flags & (FROM_A | FROM_B | STALE)) == (FROM_A | FROM_B)) {
+            if (!(flags & CANDIDATE)) {
+                paint[hash] |= CANDIDATE;
+                candidates.push_back(hash);
+            }
+            flags |= STALE;
+        }
+        flags &= FROM_A | FROM_B | STALE;
+
+        if (!parentsOf(hash, parents)) return false;
+        for (const auto& parent : parents) {
+            unsigned& parent_flags = paint[parent];
+            if ((parent_flags | flags) == parent_flags) continue;
+            std::pair<std::uint64_t, std::string> entry(generationOf(parent), parent);
+            bool queued = queue.count(entry) > 0;
+            if (queued && !(parent_flags & STALE) && (flags & STALE)) active--;
+            if (!queued && !((parent_flags | flags) & STALE)) active++;
+            parent_flags |= flags;
+            if (!queued) queue.insert(entry);
+        }
+    }
+
+    // Candidates reached by STALE paint lie below another candidate; the walk
+    // may end before that paint reaches every one, so the rest are checked
+    // against each other below the lowest candidate generation
+    std::vector<std::string> remaining;
+    std::uint64_t min_generation = UINT64_MAX;
+    for (const auto& hash : candidates) {
+        if (paint[hash] & STALE) continue;
+        remaining.push_back(hash);
+        min_generation = std::min(min_generation, generationOf(hash));
+    }
+    std::unordered_set<std::string> below;
+    std::vector<Commit> commits(remaining.size());
+    for (std::size_t i = 0; i < remaining.size(); i++) {
+        if (!storage.readCommit(remaining[i], commits[i])) return false;
+        if (remaining.size() == 1) break;
+        for (const auto& parent : commits[i].parent_hashes) {
+            if (!collectAncestors(parent, min_generation, below)) return false;
+        }
+    }
+    std::int64_t newest = 0;
+    for (std::size_t i = 0; i < remaining.size(); i++) {
+        if (below.count(remaining[i])) continue;
+        std::int64_t timestamp = std::strtoll(commits[i].timestamp.c_str(), nullptr, 10);
+        if (base.empty() || timestamp > newest || (timestamp == newest && remaining[i] < base)) {
+            base = remaining[i];
+            newest = timestamp;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the number of commits the last merge base search visited
+ * @return std::size_t Commits visited (0 before the first search)
+ */
+std::size_t TreeMerger::commitsWalked() const {
+    return commits_walked;
+}
+
+/**
+ * @brief Merges the trees of two commits
+ * @param ours Our commit hash
+ * @param theirs Their commit hash
+ * @param result Reference to MergeResult to populate
+ * @param stats Reference to MergeStats to populate
+ * @return bool True if the merge could be computed, false if objects were missing
+ */
+bool TreeMerger::merge(const std::string& ours, const std::string& theirs, MergeResult& result, MergeStats& stats) {
+    std::string base;
+    if (!findMergeBase(ours, theirs, base)) return false;
+    return merge(ours, theirs, base, result, stats);
+}
+
+/**
+ * @brief Merges the trees of two commits against a merge base found earlier
+ * @param ours Our commit hash
+ * @param theirs Their commit hash
+ * @param base Merge base from findMergeBase (empty if the histories are unrelated)
+ * @param result Reference to MergeResult to populate
+ * @param stats Reference to MergeStats to populate
+ * @return bool True if the merge could be computed, false if objects were missing
+ */
+bool TreeMerger::merge(const std::string& ours, const std::string& theirs, const std::string& base,
+                       MergeResult& result, MergeStats& stats) {
+    result = MergeResult();
+    stats = MergeStats();
+    Commit ours_commit, theirs_commit, base_commit;
+    if (!storage.readCommit(ours, ours_commit) || !storage.readCommit(theirs, theirs_commit)) return false;
+    result.base_hash = base;
+
+    std::string base_tree;
+    if (!result.base_hash.empty()) {
+        if (!storage.readCommit(result.base_hash, base_commit)) return false;
+        base_tree = base_commit.tree_hash;
+    }
+
+    ours_label = ours;
+    theirs_label = theirs;
+    if (!mergeTrees(base_tree, ours_commit.tree_hash, theirs_commit.tree_hash, "", result.tree_hash,
+                    result.conflicts, stats)) {
+        return false;
+    }
+    if (result.tree_hash.empty()) {
+        // Everything was deleted: the result is the empty tree
+        Tree empty;
+        empty.hash = empty.calculateHash();
+        if (!storage.storeTree(empty)) return false;
+        result.tree_hash = empty.hash;
+    }
+    return true;
+}
+
+} // namespace vcs
@@ -1,4 +1,5 @@
 #include "object.h"
+#include "constants.h"
 #include <sstream>
 #include <iomanip>
 #include <functional>
@@ -10,13 +11,134 @@ namespace vcs {
  * @param input The string to hash
  * @return std::string Hexadecimal representation of the hash
  */
-std::string calculateSimpleHash(const std::string& input) {
-    std::size_t hash = std::hash<std::string>{}(input);
+std::string calculateSimpleHash(std::string_view input) {
+    // std::hash<std::string_view> matches std::hash<std::string> for equal bytes
+    std::size_t hash = std::hash<std::string_view>{}(input);
     std::stringstream ss;
     ss << std::hex << std::setw(16) << std::setfill('0') << hash;
     return ss.str();
 }
 
+/**
+ * @brief Detects the type of stored object data by matching it against its name
+ * @param hash The object name
+ * @param data The stored object data
+ * @return std::string "blob", "tree" or "commit", or empty if the data does not match the hash
+ */
+std::string detectObjectType(const std::string& hash, std::string_view data) {
+    // The data is copied into one buffer with room for the longest prefix;
+    // "blob:" and "tree:" are written over bytes 2-6 and "commit:" over
+    // bytes 0-6. Each candidate type costs one hash of the whole buffer, so
+    // the type the leading bytes suggest is tried first: a commit starts
+    // with its tree field ('t', length 8) and a tree with a file mode.
+    std::string buffer;
+    buffer.reserve(data.size() + 7);
+    buffer.append("  blob:");
+    buffer.append(data.data(), data.size());
+
+    auto matches = [&](const std::string& type) {
+        if (type == types::COMMIT) {
+            buffer.replace(0, 7, "commit:");
+            return calculateSimpleHash(buffer) == hash;
+        }
+        buffer.replace(0, 7, "  " + type + ":");
+        return calculateSimpleHash(std::string_view(buffer.data() + 2, buffer.size() - 2)) == hash;
+    };
+
+    const std::string* order[3] = {&types::BLOB, &types::TREE, &types::COMMIT};
+    if (data.size() >= 2 && data[0] == 't' && data[1] == RAW_HASH_SIZE) {
+        std::swap(order[0], order[2]);
+    } else if (data.substr(0, 6) == "40000 " || data.substr(0, 7) == "100644 " || data.substr(0, 7) == "100755 ") {
+        std::swap(order[0], order[1]);
+    }
+    for (const std::string* type : order) {
+        if (matches(*type)) return *type;
+    }
+    return "";
+}
+
+/**
+ * @brief Converts a hex object hash to its raw binary form
+ * @param hex The hex hash (16 lowercase hex digits)
+ * @param raw Reference to string to receive the raw bytes
+ * @return bool True if the hash was well-formed, false otherwise
+ */
+bool hexToRaw(std::string_view hex, std::string& raw) {
+    if (hex.size() != RAW_HASH_SIZE * 2) return false;
+    std::string result(RAW_HASH_SIZE, '\0');
+    for (std::size_t i = 0; i < hex.size(); i++) {
+        char c = hex[i];
+        int nibble;
+        if (c >= '0' && c <= '9') nibble = c - '0';
+        else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+        else return false;
+        result[i / 2] = static_cast<char>((result[i / 2] << 4) | nibble);
+    }
+    raw = result;
+    return true;
+}
+
+/**
+ * @brief Converts a raw binary object hash to hex
+ * @param raw The raw hash bytes
+ * @return std::string The hex hash
+ */
+std::string rawToHex(std::string_view raw) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(raw.size() * 2, '0');
+    for (std::size_t i = 0; i < raw.size(); i++) {
+        unsigned char byte = static_cast<unsigned char>(raw[i]);
+        hex[i * 2] = digits[byte >> 4];
+        hex[i * 2 + 1] = digits[byte & 0x0f];
+    }
+    return hex;
+}
+
+/**
+ * @brief Appends an unsigned LEB128 varint
+ * @param out String to append to
+ * @param value Value to encode
+ */
+static void appendVarint(std::string& out, std::size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint and advances past it
+ * @param data Data to read from (advanced on success)
+ * @param value Reference to receive the decoded value
+ * @return bool True if a complete varint was read, false otherwise
+ */
+static bool readVarint(std::string_view& data, std::size_t& value) {
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < data.size() && i < 10; i++) {
+        unsigned char byte = static_cast<unsigned char>(data[i]);
+        result |= static_cast<std::size_t>(byte & 0x7f) << (7 * i);
+        if (!(byte & 0x80)) {
+            data.remove_prefix(i + 1);
+            value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Appends one length-prefixed commit field
+ * @param out String to append to
+ * @param tag One-byte field tag
+ * @param value Field value
+ */
+static void appendField(std::string& out, char tag, std::string_view value) {
+    out.push_back(tag);
+    appendVarint(out, value.size());
+    out.append(value.data(), value.size());
+}
+
 /**
  * @brief Constructs a Blob with content and optional file path
  * @param content The file content to store
@@ -48,11 +170,115 @@ void Tree::addEntry(const TreeEntry& entry) {
  * @return std::string Serialized tree representation
  */
 std::string Tree::serialize() const {
-    std::stringstream ss;
+    std::string out;
+    out.reserve(entries.size() * 32);
+    std::string raw;
     for(const auto& entry : entries) {
-        ss << entry.mode << " " << entry.type << " " << entry.hash << " " << entry.name << "\n";
+        out += entry.mode;
+        out.push_back(' ');
+        out += entry.name;
+        out.push_back('\0');
+        // Storage refuses trees with malformed hashes (isValid), so the zeros
+        // written here only ever feed a hash calculation
+        if (!hexToRaw(entry.hash, raw)) raw.assign(RAW_HASH_SIZE, '\0');
+        out += raw;
     }
-    return ss.str();
+    return out;
+}
+
+/**
+ * @brief Parses a serialized tree
+ * @param data The serialized tree
+ * @param tree Reference to Tree object to populate (hash is left empty)
+ * @return bool True if the data was well-formed, false otherwise
+ */
+bool Tree::parse(std::string_view data, Tree& tree) {
+    Tree result;
+    TreeParser parser(data);
+    TreeEntryView view;
+    while (parser.next(view)) {
+        TreeEntry entry;
+        entry.mode = std::string(view.mode);
+        entry.type = view.isTree() ? types::TREE : types::BLOB;
+        entry.hash = rawToHex(view.raw_hash);
+        entry.name = std::string(view.name);
+        result.entries.push_back(entry);
+    }
+    if (parser.failed()) return false;
+    tree = result;
+    return true;
+}
+
+/**
+ * @brief Checks whether the entry refers to a subtree
+ * @return bool True for directory entries, false for files
+ */
+bool TreeEntryView::isTree() const {
+    return mode == "40000";
+}
+
+/**
+ * @brief Constructs a parser over serialized tree data
+ * @param data The serialized tree (must outlive the parser and its views)
+ */
+TreeParser::TreeParser(std::string_view data) : data(data), error(false) {}
+
+/**
+ * @brief Parses the next entry
+ * @param entry Reference to TreeEntryView to populate
+ * @return bool True if an entry was read, false at the end or on malformed data
+ */
+bool TreeParser::next(TreeEntryView& entry) {
+    if (data.empty() || error) return false;
+
+    std::size_t space = data.find(' ');
+    std::size_t nul = data.find('\0', space == std::string_view::npos ? 0 : space);
+    if (space == std::string_view::npos || space == 0 || nul == std::string_view::npos ||
+        nul == space + 1 || data.size() - nul - 1 < RAW_HASH_SIZE) {
+        error = true;
+        return false;
+    }
+    for (std::size_t i = 0; i < space; i++) {
+        if (data[i] < '0' || data[i] > '7') {
+            error = true;
+            return false;
+        }
+    }
+
+    entry.mode = data.substr(0, space);
+    entry.name = data.substr(space + 1, nul - space - 1);
+    entry.raw_hash = data.substr(nul + 1, RAW_HASH_SIZE);
+    data.remove_prefix(nul + 1 + RAW_HASH_SIZE);
+    return true;
+}
+
+/**
+ * @brief Checks whether parsing stopped on malformed data
+ * @return bool True if the data was malformed, false otherwise
+ */
+bool TreeParser::failed() const {
+    return error;
+}
+
+/**
+ * @brief Checks that the tree can be serialized without losing information
+ * @return bool True if every entry has a well-formed hash, a mode matching its type
+ *              (40000 for trees, 100644 or 100755 for blobs) and a non-empty name without NUL
+ */
+bool Tree::isValid() const {
+    std::string raw;
+    for (const auto& entry : entries) {
+        if (!hexToRaw(entry.hash, raw)) return false;
+        if (entry.type == types::TREE) {
+            if (entry.mode != "40000") return false;
+        } else if (entry.type == types::BLOB) {
+            if (entry.mode != "100644" && entry.mode != "100755") return false;
+        } else {
+            return false;
+        }
+        if (entry.name.empty() || entry.name.find('\0') != std::string::npos) return false;
+    }
+    return true;
 }
 
 /**
@@ -63,20 +289,112 @@ std::string Tree::calculateHash() const {
     return calculateSimpleHash("tree:" + serialize());
 }
 
+/**
+ * @brief Checks that the commit can be serialized without losing information
+ * @return bool True if the tree and parent hashes are well-formed
+ */
+bool Commit::isValid() const {
+    std::string raw;
+    if (!hexToRaw(tree_hash, raw)) return false;
+    for (const auto& parent : parent_hashes) {
+        if (!hexToRaw(parent, raw)) return false;
+    }
+    return true;
+}
+
 /**
  * @brief Serializes the commit to string format for storage
  * @return std::string Serialized commit representation
  */
 std::string Commit::serialize() const {
-    std::stringstream ss;
-    ss << "tree " << tree_hash << "\n";
+    std::string out;
+    std::string raw;
+    if (!hexToRaw(tree_hash, raw)) raw.assign(RAW_HASH_SIZE, '\0');
+    appendField(out, 't', raw);
+
+    std::string parents;
     for(const auto& parent : parent_hashes) {
-        ss << "parent " << parent << "\n";
+        if (!hexToRaw(parent, raw)) raw.assign(RAW_HASH_SIZE, '\0');
+        parents += raw;
     }
-    ss << "author " << author << "\n";
-    ss << "timestamp " << timestamp << "\n";
-    ss << "\n" << message << "\n";
-    return ss.str();
+    appendField(out, 'p', parents);
+    appendField(out, 'a', author);
+    appendField(out, 'd', timestamp);
+    appendField(out, 'm', message);
+    return out;
+}
+
+/**
+ * @brief Parses a serialized commit
+ * @param data The serialized commit
+ * @param commit Reference to Commit object to populate (hash is left empty)
+ * @return bool True if the data was well-formed, false otherwise
+ */
+bool Commit::parse(std::string_view data, Commit& commit) {
+    CommitView view;
+    if (!view.parse(data)) return false;
+
+    Commit result;
+    result.tree_hash = rawToHex(view.tree_raw);
+    for (std::size_t i = 0; i < view.parentCount(); i++) {
+        result.parent_hashes.push_back(rawToHex(view.parentRaw(i)));
+    }
+    result.author = std::string(view.author);
+    result.timestamp = std::string(view.timestamp);
+    result.message = std::string(view.message);
+    commit = result;
+    return true;
+}
+
+/**
+ * @brief Parses a serialized commit
+ * @param data The serialized commit (must outlive the view)
+ * @return bool True if the data was well-formed, false otherwise
+ */
+bool CommitView::parse(std::string_view data) {
+    bool has_tree = false;
+    while (!data.empty()) {
+        char tag = data.front();
+        data.remove_prefix(1);
+        std::size_t length;
+        if (!readVarint(data, length) || length > data.size()) return false;
+        std::string_view value = data.substr(0, length);
+        data.remove_prefix(length);
+
+        switch (tag) {
+            case 't':
+                if (value.size() != RAW_HASH_SIZE) return false;
+                tree_raw = value;
+                has_tree = true;
+                break;
+            case 'p':
+                if (value.size() % RAW_HASH_SIZE != 0) return false;
+                parents_raw = value;
+                break;
+            case 'a': author = value; break;
+            case 'd': timestamp = value; break;
+            case 'm': message = value; break;
+            default: break;  // unknown fields are skipped for forward compatibility
+        }
+    }
+    return has_tree;
+}
+
+/**
+ * @brief Gets the number of parents
+ * @return std::size_t Number of parent commits
+ */
+std::size_t CommitView::parentCount() const {
+    return parents_raw.size() / RAW_HASH_SIZE;
+}
+
+/**
+ * @brief Gets the raw hash of a parent
+ * @param i Index of the parent (less than parentCount())
+ * @return std::string_view Raw hash of the parent
+ */
+std::string_view CommitView::parentRaw(std::size_t i) const {
+    return parents_raw.substr(i * RAW_HASH_SIZE, RAW_HASH_SIZE);
 }
 
 /**
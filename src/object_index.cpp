@@ -0,0 +1,339 @@
+#include "object_index.h"
+#include "constants.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unistd.h>
+
+namespace vcs {
+
+/**
+ * @brief Checks whether a file name has the form of an object hash
+ * @param name The file name to check
+ * @return bool True if the name is a 16-digit lowercase hex hash
+ */
+bool isObjectName(const std::string& name) {
+    if (name.size() != 16) return false;
+    for (char c : name) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Constructs an ObjectIndex for an object directory
+ * @param objects_path Path to the object directory
+ */
+ObjectIndex::ObjectIndex(const std::string& objects_path)
+    : objects_path(objects_path), loaded(false), packs_loaded(false), dirty(false), scans(0),
+      key_count(0), capacity(0) {}
+
+/**
+ * @brief Saves the filter if objects were added and no other process changed the directory
+ */
+ObjectIndex::~ObjectIndex() {
+    if (!loaded || !dirty) return;
+    // Objects stored by another process since the scan are not in the filter
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(objects_path, ec);
+    if (ec || mtime != scanned_mtime) return;
+    auto pack_mtime = std::filesystem::last_write_time(objects_path + "/" + PACK_DIR, ec);
+    if (pack_mtime != scanned_pack_mtime) return;
+    writeLocked();
+}
+
+/**
+ * @brief Opens the index of every pack in the pack directory (mutex held)
+ */
+void ObjectIndex::openPacksLocked() {
+    packs.clear();
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(objects_path + "/" + PACK_DIR, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".idx") continue;
+        PackReader reader;
+        if (reader.open(it->path().string())) packs.push_back(std::move(reader));
+    }
+    packs_loaded = true;
+}
+
+/**
+ * @brief Scans the object directory and rebuilds and saves the filter (mutex held)
+ */
+void ObjectIndex::scanLocked() {
+    std::vector<std::string> hashes;
+    std::error_code ec;
+    // The saved filter lives in a subdirectory so that writing it leaves the
+    // directory mtime alone; only creating that subdirectory changes it
+    std::filesystem::create_directory(
+        (std::filesystem::path(objects_path) / OBJECT_INDEX_FILE).parent_path(), ec);
+    // Taken before the scan so that files added during the scan cause a rescan
+    scanned_mtime = std::filesystem::last_write_time(objects_path, ec);
+    for (std::filesystem::directory_iterator it(objects_path, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (isObjectName(name)) hashes.push_back(name);
+    }
+
+    // Packed objects join the same filter, so one lookup covers every pack
+    scanned_pack_mtime = std::filesystem::last_write_time(objects_path + "/" + PACK_DIR, ec);
+    openPacksLocked();
+    for (const auto& pack : packs) {
+        for (auto& hash : pack.hashes()) {
+            hashes.push_back(std::move(hash));
+        }
+    }
+
+    // Leave room to grow so that a run of stores does not force a rescan
+    capacity = hashes.size() * 2 + 1024;
+    bloom = BloomFilter(capacity);
+    for (const auto& hash : hashes) {
+        bloom.add(hash);
+    }
+    key_count = hashes.size();
+    loaded = true;
+    scans++;
+    dirty = !writeLocked();
+}
+
+/**
+ * @brief Reads the saved filter if it matches the current directory mtimes (mutex held)
+ * @return bool True if the filter was read, false if it is missing, stale or malformed
+ */
+bool ObjectIndex::readLocked() {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(objects_path, ec);
+    if (ec) return false;
+    auto pack_mtime = std::filesystem::last_write_time(objects_path + "/" + PACK_DIR, ec);
+
+    std::ifstream file(objects_path + "/" + OBJECT_INDEX_FILE);
+    std::string magic, filter;
+    std::filesystem::file_time_type::rep saved_mtime, saved_pack_mtime;
+    std::size_t saved_keys, saved_capacity;
+    if (!std::getline(file, magic) || magic != "object-index 1" ||
+        !(file >> saved_mtime >> saved_pack_mtime >> saved_keys >> saved_capacity >> filter)) {
+        return false;
+    }
+    // Any store, removal or repack since the save changed one of the mtimes
+    if (saved_mtime != mtime.time_since_epoch().count() ||
+        saved_pack_mtime != pack_mtime.time_since_epoch().count() || saved_keys > saved_capacity) {
+        return false;
+    }
+    BloomFilter saved;
+    if (!saved.deserialize(filter) || saved.bitCount() == 0) return false;
+
+    bloom = std::move(saved);
+    key_count = saved_keys;
+    capacity = saved_capacity;
+    scanned_mtime = mtime;
+    scanned_pack_mtime = pack_mtime;
+    // The pack indexes are only needed once a packed object is looked up
+    packs.clear();
+    packs_loaded = false;
+    loaded = true;
+    dirty = false;
+    return true;
+}
+
+/**
+ * @brief Saves the filter with the directory mtimes it reflects (mutex held)
+ * @return bool True if the file was written, false otherwise
+ */
+bool ObjectIndex::writeLocked() {
+    std::string path = objects_path + "/" + OBJECT_INDEX_FILE;
+    std::string temp_path = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file.is_open()) return false;
+        file << "object-index 1\n"
+             << scanned_mtime.time_since_epoch().count() << "\n"
+             << scanned_pack_mtime.time_since_epoch().count() << "\n"
+             << key_count << " " << capacity << "\n"
+             << bloom.serialize() << "\n";
+        file.close();
+        if (!file.good()) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    // Renamed into place so a concurrent reader never sees a partial filter
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+/**
+ * @brief Reads the saved filter, or scans the directory if it is missing or stale (mutex held)
+ */
+void ObjectIndex::loadLocked() {
+    if (!readLocked()) scanLocked();
+}
+
+/**
+ * @brief Checks whether an object may exist, loading the index on first use
+ * @param hash The object hash to check
+ * @return bool False if the object is definitely absent, true if it may exist
+ */
+bool ObjectIndex::mightContain(const std::string& hash) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (loaded) return bloom.mightContain(hash);
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!loaded) loadLocked();
+    return bloom.mightContain(hash);
+}
+
+/**
+ * @brief Loads the index if it has not been loaded yet (shared lock not held)
+ */
+void ObjectIndex::ensureLoaded() {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (loaded) return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!loaded) loadLocked();
+}
+
+/**
+ * @brief Opens the pack indexes if they have not been opened yet (shared lock not held)
+ */
+void ObjectIndex::ensurePacksLoaded() {
+    ensureLoaded();
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (packs_loaded) return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!loaded) loadLocked();
+    if (packs_loaded) return;
+    // A pack written since the filter was saved holds objects the filter lacks
+    std::error_code ec;
+    auto pack_mtime = std::filesystem::last_write_time(objects_path + "/" + PACK_DIR, ec);
+    if (pack_mtime != scanned_pack_mtime) {
+        scanLocked();
+    } else {
+        openPacksLocked();
+    }
+}
+
+/**
+ * @brief Checks whether an object is stored in one of the packs
+ * @param hash The object hash to check
+ * @return bool True if a pack contains the object, false otherwise
+ */
+bool ObjectIndex::containsPacked(const std::string& hash) {
+    std::uint64_t key;
+    if (!hashToKey(hash, key)) return false;
+    ensurePacksLoaded();
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const auto& pack : packs) {
+        if (pack.contains(key)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Reads an object from the pack that contains it
+ * @param hash The object hash to read
+ * @param data Reference to string to receive the object data
+ * @return bool True if the object was found and read, false otherwise
+ */
+bool ObjectIndex::readPacked(const std::string& hash, std::string& data) {
+    std::uint64_t key;
+    if (!hashToKey(hash, key)) return false;
+    ensurePacksLoaded();
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const auto& pack : packs) {
+        if (pack.contains(key)) return pack.read(key, data);
+    }
+    return false;
+}
+
+/**
+ * @brief Lists the hashes of all packed objects
+ * @return std::vector<std::string> Hashes of objects in all packs
+ */
+std::vector<std::string> ObjectIndex::packedObjects() {
+    ensurePacksLoaded();
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::string> result;
+    for (const auto& pack : packs) {
+        for (auto& hash : pack.hashes()) {
+            result.push_back(std::move(hash));
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Records a newly stored object
+ * @param hash The hash of the stored object
+ * @param previous_mtime Directory mtime taken just before the object was written
+ */
+void ObjectIndex::add(const std::string& hash, std::filesystem::file_time_type previous_mtime) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!loaded) return;  // the object is picked up by the scan on first lookup
+    bloom.add(hash);
+    key_count++;
+    dirty = true;
+    // Our own store changed the directory; do not mistake it for a foreign change.
+    // If the directory had already changed since the scan, another process stored
+    // objects the filter does not know, so the next refresh must still rescan.
+    if (previous_mtime == scanned_mtime) {
+        std::error_code ec;
+        scanned_mtime = std::filesystem::last_write_time(objects_path, ec);
+    }
+    // An overfull filter degrades to always-positive; rescan at a larger size
+    if (key_count > capacity) loaded = false;
+}
+
+/**
+ * @brief Drops the index so the next lookup rescans the directory
+ */
+void ObjectIndex::reset() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    loaded = false;
+}
+
+/**
+ * @brief Rescans the directory if it was modified since the filter was built
+ */
+void ObjectIndex::refreshIfChanged() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!loaded) return;
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(objects_path, ec);
+    if (!ec && mtime == scanned_mtime) {
+        auto pack_mtime = std::filesystem::last_write_time(objects_path + "/" + PACK_DIR, ec);
+        if (pack_mtime == scanned_pack_mtime) return;
+    }
+    // Done now rather than on the next lookup, so a repack or gc leaves a
+    // current filter on disk; a filter saved by the other process is reused
+    loadLocked();
+}
+
+/**
+ * @brief Gets the number of objects known to the index
+ * @return std::size_t Number of indexed objects (0 if not loaded yet)
+ */
+std::size_t ObjectIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return loaded ? key_count : 0;
+}
+
+/**
+ * @brief Gets the number of full directory scans made so far
+ * @return std::size_t Number of scans (0 while the saved filter was enough)
+ */
+std::size_t ObjectIndex::scanCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return scans;
+}
+
+} // namespace vcs
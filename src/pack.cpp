@@ -0,0 +1,312 @@
+#include "pack.h"
+#include "constants.h"
+#include "object.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <zlib.h>
+
+namespace vcs {
+
+/**
+ * @brief Magic bytes at the start of a pack file
+ */
+static const char PACK_MAGIC[4] = {'M', 'V', 'P', 'K'};
+
+/**
+ * @brief Magic bytes at the start of a pack index file
+ */
+static const char INDEX_MAGIC[4] = {'M', 'V', 'I', 'X'};
+
+/**
+ * @brief Bytes of the pack header (magic and version) and of the index header (magic, version, count)
+ */
+static const std::uint64_t PACK_HEADER_SIZE = 12;
+static const std::uint64_t INDEX_HEADER_SIZE = 20;
+
+/**
+ * @brief Bytes of one index entry (key and offset)
+ */
+static const std::uint64_t INDEX_ENTRY_SIZE = 16;
+
+/**
+ * @brief Upper bound of zlib's compression ratio, used to reject impossible sizes
+ */
+static const std::uint64_t MAX_DEFLATE_RATIO = 1032;
+
+/**
+ * @brief Writes a 64-bit value in little-endian byte order
+ * @param out Stream to write to
+ * @param value Value to write
+ */
+static void writeU64(std::ostream& out, std::uint64_t value) {
+    char bytes[8];
+    for (int i = 0; i < 8; i++) bytes[i] = static_cast<char>(value >> (8 * i));
+    out.write(bytes, 8);
+}
+
+/**
+ * @brief Reads a 64-bit value in little-endian byte order
+ * @param in Stream to read from
+ * @param value Reference to receive the value
+ * @return bool True if 8 bytes were read, false otherwise
+ */
+static bool readU64(std::istream& in, std::uint64_t& value) {
+    unsigned char bytes[8];
+    if (!in.read(reinterpret_cast<char*>(bytes), 8)) return false;
+    value = 0;
+    for (int i = 7; i >= 0; i--) value = (value << 8) | bytes[i];
+    return true;
+}
+
+/**
+ * @brief Writes an unsigned LEB128 varint
+ * @param out Stream to write to
+ * @param value Value to write
+ * @return std::uint64_t Number of bytes written
+ */
+static std::uint64_t writeVarint(std::ostream& out, std::uint64_t value) {
+    std::uint64_t written = 0;
+    while (value >= 0x80) {
+        out.put(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+        written++;
+    }
+    out.put(static_cast<char>(value));
+    return written + 1;
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint
+ * @param in Stream to read from
+ * @param value Reference to receive the value
+ * @return bool True if a complete varint was read, false otherwise
+ */
+static bool readVarint(std::istream& in, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == EOF) return false;
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Converts a hex object hash to its numeric key
+ * @param hash The hex hash
+ * @param key Reference to receive the key
+ * @return bool True if the hash was well-formed, false otherwise
+ */
+bool hashToKey(const std::string& hash, std::uint64_t& key) {
+    std::string raw;
+    if (!hexToRaw(hash, raw)) return false;
+    key = 0;
+    for (char byte : raw) key = (key << 8) | static_cast<unsigned char>(byte);
+    return true;
+}
+
+/**
+ * @brief Loads the index of a pack
+ * @param idx_path Path to the ".idx" file (the ".pack" file must sit next to it)
+ * @return bool True if the index was read and is consistent with both files, false otherwise
+ */
+bool PackReader::open(const std::string& idx_path) {
+    std::ifstream file(idx_path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    // Sizes come from disk and are checked against the files before anything is allocated
+    std::error_code ec;
+    std::uint64_t idx_size = std::filesystem::file_size(idx_path, ec);
+    if (ec) return false;
+    std::string path = idx_path.substr(0, idx_path.size() - 4) + ".pack";
+    std::uint64_t file_size = std::filesystem::file_size(path, ec);
+    if (ec || file_size < PACK_HEADER_SIZE) return false;
+
+    char magic[4];
+    std::uint64_t version, count;
+    if (!file.read(magic, 4) || !std::equal(magic, magic + 4, INDEX_MAGIC) ||
+        !readU64(file, version) || version != 1 || !readU64(file, count) ||
+        count != (idx_size - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE ||
+        idx_size != INDEX_HEADER_SIZE + count * INDEX_ENTRY_SIZE) {
+        return false;
+    }
+
+    std::vector<PackEntry> loaded(static_cast<std::size_t>(count));
+    for (std::size_t i = 0; i < loaded.size(); i++) {
+        PackEntry& entry = loaded[i];
+        if (!readU64(file, entry.key) || !readU64(file, entry.offset)) return false;
+        // Lookups are binary searches, and every record must start inside the pack
+        if ((i > 0 && entry.key <= loaded[i - 1].key) || entry.offset < PACK_HEADER_SIZE ||
+            entry.offset >= file_size) {
+            return false;
+        }
+    }
+    entries.swap(loaded);
+    pack_path = path;
+    pack_size = file_size;
+    return true;
+}
+
+/**
+ * @brief Checks whether the pack contains an object
+ * @param key Numeric key of the object hash
+ * @return bool True if the object is in the pack, false otherwise
+ */
+bool PackReader::contains(std::uint64_t key) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                               [](const PackEntry& entry, std::uint64_t k) { return entry.key < k; });
+    return it != entries.end() && it->key == key;
+}
+
+/**
+ * @brief Reads and decompresses an object from the pack
+ * @param key Numeric key of the object hash
+ * @param data Reference to string to receive the object data
+ * @return bool True if the object was read successfully, false otherwise
+ */
+bool PackReader::read(std::uint64_t key, std::string& data) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                               [](const PackEntry& entry, std::uint64_t k) { return entry.key < k; });
+    if (it == entries.end() || it->key != key) return false;
+
+    // Every read opens its own stream so concurrent readers do not share a position
+    std::ifstream file(pack_path, std::ios::binary);
+    if (!file.is_open() || !file.seekg(static_cast<std::streamoff>(it->offset))) return false;
+
+    std::uint64_t raw_size, stored_size;
+    if (!readVarint(file, raw_size) || !readVarint(file, stored_size)) return false;
+    std::streamoff position = file.tellg();
+    if (position < 0 || stored_size > pack_size - static_cast<std::uint64_t>(position) ||
+        raw_size > MAX_OBJECT_SIZE || raw_size > stored_size * MAX_DEFLATE_RATIO + 64) {
+        return false;
+    }
+    std::string stored(stored_size, '\0');
+    if (!file.read(&stored[0], static_cast<std::streamsize>(stored_size))) return false;
+
+    std::string result(raw_size, '\0');
+    uLongf length = static_cast<uLongf>(raw_size);
+    if (uncompress(reinterpret_cast<Bytef*>(&result[0]), &length,
+                   reinterpret_cast<const Bytef*>(stored.data()),
+                   static_cast<uLong>(stored_size)) != Z_OK || length != raw_size) {
+        return false;
+    }
+    data.swap(result);
+    return true;
+}
+
+/**
+ * @brief Lists the hashes of all objects in the pack
+ * @return std::vector<std::string> Hex hashes of packed objects
+ */
+std::vector<std::string> PackReader::hashes() const {
+    std::vector<std::string> result;
+    result.reserve(entries.size());
+    std::string raw(RAW_HASH_SIZE, '\0');
+    for (const auto& entry : entries) {
+        for (std::size_t i = 0; i < RAW_HASH_SIZE; i++) {
+            raw[i] = static_cast<char>(entry.key >> (8 * (RAW_HASH_SIZE - 1 - i)));
+        }
+        result.push_back(rawToHex(raw));
+    }
+    return result;
+}
+
+/**
+ * @brief Starts a new pack in a directory
+ * @param pack_dir Directory to create the pack in
+ * @param name Pack name (file names become "pack-<name>.pack/.idx")
+ * @return bool True if the pack file could be created, false otherwise
+ */
+bool PackWriter::open(const std::string& pack_dir, const std::string& name) {
+    base_path = pack_dir + "/pack-" + name;
+    entries.clear();
+    pack.open(base_path + ".pack.tmp", std::ios::binary | std::ios::trunc);
+    if (!pack.is_open()) return false;
+
+    pack.write(PACK_MAGIC, 4);
+    writeU64(pack, 1);
+    offset = 12;
+    return pack.good();
+}
+
+/**
+ * @brief Compresses and appends an object
+ * @param hash The object's hash
+ * @param data The object data
+ * @return bool True if the object was written successfully, false otherwise
+ */
+bool PackWriter::add(const std::string& hash, const std::string& data) {
+    PackEntry entry;
+    if (!hashToKey(hash, entry.key)) return false;
+    entry.offset = offset;
+
+    uLongf stored_size = compressBound(static_cast<uLong>(data.size()));
+    std::string stored(stored_size, '\0');
+    if (compress(reinterpret_cast<Bytef*>(&stored[0]), &stored_size,
+                 reinterpret_cast<const Bytef*>(data.data()),
+                 static_cast<uLong>(data.size())) != Z_OK) {
+        return false;
+    }
+
+    offset += writeVarint(pack, data.size());
+    offset += writeVarint(pack, stored_size);
+    pack.write(stored.data(), static_cast<std::streamsize>(stored_size));
+    offset += stored_size;
+    if (!pack.good()) return false;
+
+    entries.push_back(entry);
+    return true;
+}
+
+/**
+ * @brief Gets the number of objects added so far
+ * @return std::size_t Number of objects in the pack
+ */
+std::size_t PackWriter::size() const {
+    return entries.size();
+}
+
+/**
+ * @brief Writes the index and moves both files into place (an empty pack is discarded)
+ * @return bool True if the pack was completed successfully, false otherwise
+ */
+bool PackWriter::finish() {
+    if (entries.empty()) {
+        abort();
+        return true;
+    }
+    pack.close();
+    if (pack.fail()) return false;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const PackEntry& a, const PackEntry& b) { return a.key < b.key; });
+    {
+        std::ofstream index(base_path + ".idx.tmp", std::ios::binary | std::ios::trunc);
+        if (!index.is_open()) return false;
+        index.write(INDEX_MAGIC, 4);
+        writeU64(index, 1);
+        writeU64(index, entries.size());
+        for (const auto& entry : entries) {
+            writeU64(index, entry.key);
+            writeU64(index, entry.offset);
+        }
+        if (!index.good()) return false;
+    }
+
+    // The pack goes first: an index is only ever visible next to a complete pack
+    return std::rename((base_path + ".pack.tmp").c_str(), (base_path + ".pack").c_str()) == 0 &&
+           std::rename((base_path + ".idx.tmp").c_str(), (base_path + ".idx").c_str()) == 0;
+}
+
+/**
+ * @brief Discards the pack being written
+ */
+void PackWriter::abort() {
+    pack.close();
+    std::remove((base_path + ".pack.tmp").c_str());
+    entries.clear();
+}
+
+} // namespace vcs
@@ -0,0 +1,96 @@
+#include "reachability.h"
+#include "constants.h"
+#include "parallel.h"
+
+namespace vcs {
+
+/**
+ * @brief Constructs a walker reading from the given storage
+ * @param storage Storage to read objects from
+ * @param threads Worker thread count (0 selects hardware concurrency)
+ */
+ReachabilityWalker::ReachabilityWalker(Storage& storage, unsigned threads)
+    : storage(storage), threads(threads) {}
+
+/**
+ * @brief Adds all objects reachable from the roots to a set
+ *
+ * Objects already in the set are not walked again, so the walk can be
+ * repeated with new roots to extend an earlier result.
+ *
+ * @param commit_roots Commits to start from (e.g. HEAD)
+ * @param blob_roots Blobs that must be kept (e.g. staged files)
+ * @param reachable Set receiving the hashes of all reachable objects
+ * @param missing Vector receiving referenced commits and trees that could not be read
+ * @param check_blobs Also report blobs that do not exist (default false)
+ */
+void ReachabilityWalker::mark(const std::vector<std::string>& commit_roots,
+                              const std::vector<std::string>& blob_roots,
+                              std::unordered_set<std::string>& reachable,
+                              std::vector<std::string>& missing,
+                              bool check_blobs) {
+    // Commits form a chain, so they are walked serially and only collect root trees
+    std::vector<std::string> frontier;
+    std::vector<std::string> pending;
+    for (const auto& hash : commit_roots) {
+        if (reachable.insert(hash).second) pending.push_back(hash);
+    }
+    while (!pending.empty()) {
+        std::string hash = pending.back();
+        pending.pop_back();
+        Commit commit;
+        if (!storage.readCommit(hash, commit)) {
+            missing.push_back(hash);
+            continue;
+        }
+        if (reachable.insert(commit.tree_hash).second) frontier.push_back(commit.tree_hash);
+        for (const auto& parent : commit.parent_hashes) {
+            if (reachable.insert(parent).second) pending.push_back(parent);
+        }
+    }
+
+    std::vector<std::string> blobs;
+    for (const auto& hash : blob_roots) {
+        if (reachable.insert(hash).second) blobs.push_back(hash);
+    }
+
+    // Each level of trees is read in parallel; results are merged serially
+    while (!frontier.empty()) {
+        std::vector<std::vector<TreeEntry>> children(frontier.size());
+        std::vector<char> failed(frontier.size(), 0);
+        parallelFor(frontier.size(), [&](std::size_t i) {
+            Tree tree;
+            if (storage.readTree(frontier[i], tree)) {
+                children[i].swap(tree.entries);
+            } else {
+                failed[i] = 1;
+            }
+        }, threads);
+
+        std::vector<std::string> next;
+        for (std::size_t i = 0; i < frontier.size(); i++) {
+            if (failed[i]) missing.push_back(frontier[i]);
+            for (const auto& entry : children[i]) {
+                if (!reachable.insert(entry.hash).second) continue;
+                if (entry.type == types::TREE) {
+                    next.push_back(entry.hash);
+                } else {
+                    blobs.push_back(entry.hash);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+
+    if (check_blobs) {
+        std::vector<char> present(blobs.size(), 0);
+        parallelFor(blobs.size(), [&](std::size_t i) {
+            present[i] = storage.objectExists(blobs[i]) ? 1 : 0;
+        }, threads);
+        for (std::size_t i = 0; i < blobs.size(); i++) {
+            if (!present[i]) missing.push_back(blobs[i]);
+        }
+    }
+}
+
+} // namespace vcs
@@ -0,0 +1,46 @@
+#include "refs.h"
+#include "constants.h"
+#include <cstdio>
+#include <fstream>
+
+namespace vcs {
+
+/**
+ * @brief Constructs Refs object and initializes the HEAD path
+ */
+Refs::Refs() {
+    head_path = std::string(VCS_DIR) + "/" + HEAD_FILE;
+}
+
+/**
+ * @brief Reads the commit hash HEAD points to
+ * @param commit_hash Reference to string to receive the commit hash
+ * @return bool True if HEAD exists and holds a hash, false otherwise
+ */
+bool Refs::readHead(std::string& commit_hash) const {
+    std::ifstream file(head_path);
+    if (!file.is_open()) return false;
+    std::string hash;
+    if (!(file >> hash)) return false;
+    commit_hash = hash;
+    return true;
+}
+
+/**
+ * @brief Points HEAD at a commit
+ * @param commit_hash Hash of the new HEAD commit
+ * @return bool True if HEAD was written successfully, false otherwise
+ */
+bool Refs::updateHead(const std::string& commit_hash) {
+    // Write a temporary file and rename it so readers never see a partial HEAD
+    std::string tmp_path = head_path + ".lock";
+    {
+        std::ofstream file(tmp_path);
+        if (!file.is_open()) return false;
+        file << commit_hash << "\n";
+        if (!file.good()) return false;
+    }
+    return std::rename(tmp_path.c_str(), head_path.c_str()) == 0;
+}
+
+} // namespace vcs
@@ -0,0 +1,333 @@
+#include "rename_detector.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+
+namespace vcs {
+
+/**
+ * @brief Longest chunk cut from content without a line end
+ */
+static const std::size_t MAX_CHUNK_SIZE = 64;
+
+/**
+ * @brief Scrambles a 64-bit value (splitmix64 finalizer)
+ * @param value Value to scramble
+ * @return std::uint64_t Scrambled value
+ */
+static std::uint64_t mix(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Builds the sketch of some content
+ * @param content The content
+ * @return ContentSketch The sketch
+ */
+ContentSketch ContentSketch::build(std::string_view content) {
+    ContentSketch sketch;
+    std::hash<std::string_view> hasher;
+    std::size_t start = 0;
+    while (start < content.size()) {
+        std::size_t end = start;
+        std::size_t limit = std::min(content.size(), start + MAX_CHUNK_SIZE);
+        while (end < limit && content[end] != '\n') end++;
+        if (end < content.size() && content[end] == '\n') end++;
+        sketch.chunks.push_back(hasher(content.substr(start, end - start)));
+        start = end;
+    }
+    std::sort(sketch.chunks.begin(), sketch.chunks.end());
+    sketch.chunks.erase(std::unique(sketch.chunks.begin(), sketch.chunks.end()), sketch.chunks.end());
+    if (sketch.chunks.empty()) return sketch;
+
+    // Slot i holds the minimum of the i-th hash function over all chunks
+    sketch.signature.assign(SIGNATURE_SIZE, UINT64_MAX);
+    for (std::uint64_t chunk : sketch.chunks) {
+        for (std::size_t i = 0; i < SIGNATURE_SIZE; i++) {
+            std::uint64_t value = mix(chunk ^ (0x5851f42d4c957f2dULL * (i + 1)));
+            if (value < sketch.signature[i]) sketch.signature[i] = value;
+        }
+    }
+    return sketch;
+}
+
+/**
+ * @brief Computes the exact Jaccard similarity of two chunk sets
+ * @param other The sketch to compare with
+ * @return double Similarity between 0 and 1
+ */
+double ContentSketch::similarity(const ContentSketch& other) const {
+    if (chunks.empty() || other.chunks.empty()) return 0;
+    std::size_t common = 0;
+    auto a = chunks.begin();
+    auto b = other.chunks.begin();
+    while (a != chunks.end() && b != other.chunks.end()) {
+        if (*a < *b) {
+            ++a;
+        } else if (*b < *a) {
+            ++b;
+        } else {
+            common++;
+            ++a;
+            ++b;
+        }
+    }
+    return static_cast<double>(common) / (chunks.size() + other.chunks.size() - common);
+}
+
+/**
+ * @brief Chooses the rows per signature band for a similarity threshold
+ *
+ * Two sketches share a band with probability 1 - (1 - s^r)^(n/r) for
+ * similarity s, r rows and n slots. The widest band that still finds
+ * pairs at the threshold with 99% probability keeps the buckets small.
+ *
+ * @param threshold Minimum similarity that must be found
+ * @return std::size_t Rows per band
+ */
+static std::size_t bandRows(double threshold) {
+    std::size_t rows = 1;
+    for (std::size_t candidate = 2; candidate <= 16; candidate *= 2) {
+        double hit = std::pow(threshold, static_cast<double>(candidate));
+        double found = 1 - std::pow(1 - hit, static_cast<double>(ContentSketch::SIGNATURE_SIZE / candidate));
+        if (found < 0.99) break;
+        rows = candidate;
+    }
+    return rows;
+}
+
+/**
+ * @brief Gets the file name part of a path
+ * @param path Slash-separated path
+ * @return std::string_view Text after the last slash
+ */
+static std::string_view baseName(const std::string& path) {
+    std::size_t slash = path.rfind('/');
+    return std::string_view(path).substr(slash == std::string::npos ? 0 : slash + 1);
+}
+
+/**
+ * @brief Constructs a RenameDetector
+ * @param storage Storage to read blobs from
+ * @param options Detection settings
+ */
+RenameDetector::RenameDetector(Storage& storage, const RenameOptions& options)
+    : storage(storage), options(options) {}
+
+/**
+ * @brief Replaces matching added and deleted files with renames and copies
+ * @param changes Changes from TreeDiff, rewritten in place (path order is kept)
+ * @param stats Reference to RenameStats to populate
+ * @return bool True if every blob could be read, false otherwise
+ */
+bool RenameDetector::detect(std::vector<FileChange>& changes, RenameStats& stats) {
+    stats = RenameStats();
+
+    // Sources are deleted files, plus the old side of modified files for copies
+    std::vector<std::size_t> added, sources;
+    for (std::size_t i = 0; i < changes.size(); i++) {
+        FileChange::Kind kind = changes[i].kind;
+        if (kind == FileChange::Kind::Added) {
+            added.push_back(i);
+        } else if (kind == FileChange::Kind::Deleted ||
+                   (options.find_copies && kind == FileChange::Kind::Modified)) {
+            sources.push_back(i);
+        }
+    }
+    if (added.empty() || sources.empty()) return true;
+
+    const std::size_t NONE = SIZE_MAX;
+    std::vector<std::size_t> match(added.size(), NONE);     // Index into sources
+    std::vector<int> score(added.size(), 0);
+    std::vector<bool> renamed(added.size(), false);
+    std::vector<bool> used(sources.size(), false);
+
+    auto isDeleted = [&](std::size_t source) {
+        return changes[sources[source]].kind == FileChange::Kind::Deleted;
+    };
+
+    // Pass 1: equal hashes, each deleted file renamed at most once
+    std::unordered_map<std::string, std::vector<std::size_t>> by_hash;
+    for (std::size_t s = 0; s < sources.size(); s++) {
+        by_hash[changes[sources[s]].old_hash].push_back(s);
+    }
+    for (int copies = 0; copies < (options.find_copies ? 2 : 1); copies++) {
+        for (std::size_t a = 0; a < added.size(); a++) {
+            if (match[a] != NONE) continue;
+            auto it = by_hash.find(changes[added[a]].new_hash);
+            if (it == by_hash.end()) continue;
+            for (std::size_t s : it->second) {
+                if (copies || (isDeleted(s) && !used[s])) {
+                    match[a] = s;
+                    score[a] = 100;
+                    renamed[a] = !copies;
+                    used[s] = used[s] || isDeleted(s);
+                    stats.exact++;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Pass 2: sketch the remaining files, reading each distinct blob once
+    std::vector<std::size_t> open_added, open_sources;
+    for (std::size_t a = 0; a < added.size(); a++) {
+        if (match[a] == NONE) open_added.push_back(a);
+    }
+    for (std::size_t s = 0; s < sources.size(); s++) {
+        if (!used[s] || options.find_copies) open_sources.push_back(s);
+    }
+
+    if (!open_added.empty() && !open_sources.empty()) {
+        std::unordered_map<std::string, std::size_t> sketch_ids;
+        std::vector<std::string> sketch_hashes;
+        auto sketchId = [&](const std::string& hash) {
+            auto inserted = sketch_ids.emplace(hash, sketch_hashes.size());
+            if (inserted.second) sketch_hashes.push_back(hash);
+            return inserted.first->second;
+        };
+        std::vector<std::size_t> added_sketch, source_sketch;
+        for (std::size_t a : open_added) added_sketch.push_back(sketchId(changes[added[a]].new_hash));
+        for (std::size_t s : open_sources) source_sketch.push_back(sketchId(changes[sources[s]].old_hash));
+
+        std::vector<ContentSketch> sketches(sketch_hashes.size());
+        std::atomic<bool> ok(true);
+        parallelFor(sketch_hashes.size(), [&](std::size_t i) {
+            Blob blob("");
+            if (!storage.readBlob(sketch_hashes[i], blob)) {
+                ok = false;
+                return;
+            }
+            sketches[i] = ContentSketch::build(blob.content);
+        }, options.threads);
+        if (!ok) return false;
+        stats.blobs_sketched = sketches.size();
+
+        // Sources sharing any band of rows with an added file become its candidates
+        std::size_t rows = bandRows(options.threshold);
+        std::size_t bands = ContentSketch::SIGNATURE_SIZE / rows;
+        auto bandKey = [&](const ContentSketch& sketch, std::size_t band) {
+            std::uint64_t key = mix(band);
+            for (std::size_t r = 0; r < rows; r++) key = mix(key ^ sketch.signature[band * rows + r]);
+            return key;
+        };
+        std::unordered_map<std::uint64_t, std::vector<std::size_t>> buckets;
+        for (std::size_t i = 0; i < open_sources.size(); i++) {
+            const ContentSketch& sketch = sketches[source_sketch[i]];
+            if (sketch.signature.empty()) continue;
+            for (std::size_t band = 0; band < bands; band++) {
+                buckets[bandKey(sketch, band)].push_back(i);
+            }
+        }
+
+        struct Pair {
+            int score;
+            bool same_name;
+            std::size_t added;      // Index into open_added
+            std::size_t source;     // Index into open_sources
+        };
+        std::vector<std::vector<Pair>> found(open_added.size());
+        std::atomic<std::size_t> scored(0);
+        parallelFor(open_added.size(), [&](std::size_t i) {
+            const ContentSketch& sketch = sketches[added_sketch[i]];
+            if (sketch.signature.empty()) return;
+            auto score = [&](std::size_t s) {
+                double similarity = sketch.similarity(sketches[source_sketch[s]]);
+                if (similarity < options.threshold) return;
+                const std::string& added_path = changes[added[open_added[i]]].path;
+                const std::string& source_path = changes[sources[open_sources[s]]].path;
+                found[i].push_back({static_cast<int>(similarity * 100),
+                                    baseName(added_path) == baseName(source_path), i, s});
+            };
+
+            // Candidates are ranked by the number of bands they share, since
+            // similar files share most bands. A bucket too large to score whole
+            // is content many files have in common (license headers and other
+            // boilerplate) and says little about which of them is the source;
+            // such buckets are only searched if the others found no match.
+            std::unordered_map<std::size_t, std::size_t> shared;
+            std::vector<const std::vector<std::size_t>*> oversized;
+            for (std::size_t band = 0; band < bands; band++) {
+                auto bucket = buckets.find(bandKey(sketch, band));
+                if (bucket == buckets.end()) continue;
+                if (bucket->second.size() > options.max_candidates) {
+                    oversized.push_back(&bucket->second);
+                    continue;
+                }
+                for (std::size_t s : bucket->second) shared[s]++;
+            }
+            std::vector<std::pair<std::size_t, std::size_t>> ranked(shared.begin(), shared.end());
+            std::sort(ranked.begin(), ranked.end(), [](const std::pair<std::size_t, std::size_t>& x,
+                                                       const std::pair<std::size_t, std::size_t>& y) {
+                if (x.second != y.second) return x.second > y.second;
+                return x.first < y.first;
+            });
+            if (ranked.size() > options.max_candidates) ranked.resize(options.max_candidates);
+            for (const auto& candidate : ranked) score(candidate.first);
+            std::size_t count = ranked.size();
+
+            for (const auto* bucket : oversized) {
+                if (!found[i].empty()) break;
+                for (std::size_t s : *bucket) {
+                    if (count >= options.max_candidates) break;
+                    if (!shared.emplace(s, 0).second) continue;
+                    score(s);
+                    count++;
+                }
+            }
+            scored += count;
+        }, options.threads);
+        stats.pairs_scored = scored;
+
+        // Best pairs first; equal scores prefer keeping the file name
+        std::vector<Pair> pairs;
+        for (auto& list : found) pairs.insert(pairs.end(), list.begin(), list.end());
+        std::sort(pairs.begin(), pairs.end(), [](const Pair& x, const Pair& y) {
+            if (x.score != y.score) return x.score > y.score;
+            if (x.same_name != y.same_name) return x.same_name;
+            if (x.added != y.added) return x.added < y.added;
+            return x.source < y.source;
+        });
+        for (int copies = 0; copies < (options.find_copies ? 2 : 1); copies++) {
+            for (const Pair& pair : pairs) {
+                std::size_t a = open_added[pair.added];
+                std::size_t s = open_sources[pair.source];
+                if (match[a] != NONE) continue;
+                if (!copies && (!isDeleted(s) || used[s])) continue;
+                match[a] = s;
+                score[a] = pair.score;
+                renamed[a] = !copies;
+                used[s] = used[s] || isDeleted(s);
+                stats.inexact++;
+            }
+        }
+    }
+
+    // Rewrite: matched added files become renames or copies, renamed sources disappear
+    std::vector<bool> consumed(changes.size(), false);
+    for (std::size_t a = 0; a < added.size(); a++) {
+        if (match[a] == NONE) continue;
+        const FileChange& source = changes[sources[match[a]]];
+        FileChange& change = changes[added[a]];
+        change.kind = renamed[a] ? FileChange::Kind::Renamed : FileChange::Kind::Copied;
+        change.old_path = source.path;
+        change.old_hash = source.old_hash;
+        change.similarity = score[a];
+        if (renamed[a]) consumed[sources[match[a]]] = true;
+    }
+    std::vector<FileChange> result;
+    result.reserve(changes.size());
+    for (std::size_t i = 0; i < changes.size(); i++) {
+        if (!consumed[i]) result.push_back(std::move(changes[i]));
+    }
+    changes.swap(result);
+    return true;
+}
+
+} // namespace vcs
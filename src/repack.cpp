@@ -0,0 +1,112 @@
+#include "repack.h"
+#include "gc.h"
+#include "pack.h"
+#include "reachability.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <unordered_set>
+
+namespace vcs {
+
+/**
+ * @brief Constructs a repacker for the given storage
+ * @param storage Storage to repack
+ * @param threads Worker thread count for marking (0 selects hardware concurrency)
+ */
+Repacker::Repacker(Storage& storage, unsigned threads) : storage(storage), threads(threads) {}
+
+/**
+ * @brief Packs reachable objects and deletes the copies that became redundant
+ * @param shared Write the pack into the first alternate instead of locally
+ * @param stats Reference to RepackStats to populate
+ * @return bool True if the pack was written and cleanup succeeded, false otherwise
+ */
+bool Repacker::run(bool shared, RepackStats& stats) {
+    stats = RepackStats();
+    if (shared && storage.getAlternates().empty()) return false;
+    Storage& target = shared ? *storage.getAlternates().front() : storage;
+
+    std::unordered_set<std::string> reachable;
+    std::vector<std::string> missing, commits, blobs;
+    GarbageCollector::readRoots(commits, blobs);
+    ReachabilityWalker(storage, threads).mark(commits, blobs, reachable, missing);
+    stats.reachable = reachable.size();
+
+    // Objects this repository holds that the target does not have in a pack yet
+    std::vector<std::string> loose, selected;
+    for (const auto& hash : reachable) {
+        std::uint64_t size;
+        std::int64_t mtime;
+        bool is_loose = storage.statObject(hash, size, mtime);
+        if (is_loose) loose.push_back(hash);
+        if (shared) {
+            // A loose copy in the target can be pruned there, so only its packs count
+            if ((is_loose || storage.hasPacked(hash)) && !target.hasPacked(hash)) selected.push_back(hash);
+        } else if (is_loose && !storage.hasPacked(hash)) {
+            selected.push_back(hash);
+        }
+    }
+    std::sort(selected.begin(), selected.end());
+
+    if (!selected.empty()) {
+        std::string names;
+        for (const auto& hash : selected) names += hash;
+
+        std::error_code ec;
+        std::filesystem::create_directories(target.getPackPath(), ec);
+        PackWriter writer;
+        if (!writer.open(target.getPackPath(), calculateSimpleHash(names))) return false;
+        std::string data;
+        for (const auto& hash : selected) {
+            if (!storage.readObject(hash, data) || !writer.add(hash, data)) {
+                writer.abort();
+                return false;
+            }
+            stats.packed++;
+            stats.bytes += data.size();
+        }
+        if (!writer.finish()) return false;
+        target.refresh();
+    }
+
+    // Only copies confirmed in the new location are deleted
+    bool ok = true;
+    for (const auto& hash : loose) {
+        bool redundant = shared ? target.hasPacked(hash) : storage.hasPacked(hash);
+        if (!redundant) continue;
+        if (storage.removeObject(hash)) {
+            stats.loose_removed++;
+        } else {
+            ok = false;
+        }
+    }
+
+    if (shared) {
+        std::vector<std::string> idx_paths;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(storage.getPackPath(), ec), end; !ec && it != end;
+             it.increment(ec)) {
+            if (it->path().extension() == ".idx") idx_paths.push_back(it->path().string());
+        }
+        for (const auto& idx_path : idx_paths) {
+            PackReader pack;
+            if (!pack.open(idx_path)) continue;
+            std::vector<std::string> hashes = pack.hashes();
+            bool covered = std::all_of(hashes.begin(), hashes.end(),
+                                       [&](const std::string& hash) { return target.hasPacked(hash); });
+            if (!covered) continue;
+            // The index goes first so no reader sees an index without its pack
+            std::string base = idx_path.substr(0, idx_path.size() - 4);
+            if (std::remove(idx_path.c_str()) == 0 && std::remove((base + ".pack").c_str()) == 0) {
+                stats.packs_removed++;
+            } else {
+                ok = false;
+            }
+        }
+    }
+    storage.refresh();
+    return ok;
+}
+
+} // namespace vcs
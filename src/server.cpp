@@ -0,0 +1,138 @@
+#include "server.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace vcs {
+
+/**
+ * @brief Writes a whole buffer to a descriptor, retrying short writes
+ * @param fd Descriptor to write to
+ * @param data Data to write
+ * @return bool True if everything was written, false otherwise
+ */
+static bool writeAll(int fd, const std::string& data) {
+    std::size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n <= 0) return false;
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * @brief Constructs a CommandServer dispatching to a handler
+ * @param handler Callback executing a single request
+ */
+CommandServer::CommandServer(Handler handler) : handler(handler) {}
+
+/**
+ * @brief Serves requests from an input stream until end of input
+ * @param in Stream to read request lines from
+ * @param out Stream to write replies to (flushed after every reply)
+ */
+void CommandServer::serveStream(std::istream& in, std::ostream& out) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        bool keep_going = handler(line, out);
+        out.flush();
+        if (!keep_going) break;
+    }
+}
+
+/**
+ * @brief Serves requests of one socket connection until it closes
+ * @param fd Connected socket descriptor
+ * @return bool False if the handler asked to stop the server, true otherwise
+ */
+bool CommandServer::serveConnection(int fd) {
+    std::string buffer;
+    char chunk[4096];
+    while (true) {
+        std::size_t newline;
+        while ((newline = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if (line.empty()) continue;
+
+            std::ostringstream reply;
+            bool keep_going = handler(line, reply);
+            if (!writeAll(fd, reply.str())) return true;
+            if (!keep_going) return false;
+        }
+
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n <= 0) return true;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+    }
+}
+
+/**
+ * @brief Listens on a Unix domain socket and serves connections one by one
+ * @param socket_path Filesystem path of the socket to create
+ * @return bool True if the server stopped on request, false on socket errors
+ */
+bool CommandServer::serveSocket(const std::string& socket_path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: Socket path too long" << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    // Only a stale socket left by an earlier server is replaced; any other file stays
+    struct stat st;
+    if (::lstat(socket_path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            std::cerr << "Error: " << socket_path << " exists and is not a socket" << std::endl;
+            return false;
+        }
+        if (::unlink(socket_path.c_str()) != 0) {
+            std::cerr << "Error: Cannot remove stale socket " << socket_path << std::endl;
+            return false;
+        }
+    }
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) return false;
+
+    // A client that disconnects mid-reply must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, 16) != 0) {
+        std::cerr << "Error: Cannot listen on " << socket_path << std::endl;
+        ::close(listener);
+        return false;
+    }
+
+    bool running = true;
+    bool ok = true;
+    while (running) {
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: Cannot accept connections on " << socket_path << ": "
+                      << std::strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        running = serveConnection(client);
+        ::close(client);
+    }
+
+    ::close(listener);
+    ::unlink(socket_path.c_str());
+    return ok;
+}
+
+} // namespace vcs
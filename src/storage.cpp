@@ -1,17 +1,61 @@
 #include "storage.h"
 #include "constants.h"
 #include <fstream>
+#include <sstream>
 #include <iostream>
-#include <sys/stat.h> // для mkdir
+#include <sys/stat.h> // для mkdir и stat
 #include <cstdio>     // для remove
+#include <filesystem>
+#include <utime.h>    // для utime
+#include <unistd.h>   // для getpid
+#include <atomic>
+#include <cerrno>
 
 namespace vcs {
 
 /**
  * @brief Constructs Storage object and initializes objects path
  */
-Storage::Storage() {
-    objects_path = std::string(VCS_DIR) + "/" + OBJECTS_DIR;
+Storage::Storage() : Storage(std::string(VCS_DIR) + "/" + OBJECTS_DIR) {
+    loadAlternates();
+}
+
+/**
+ * @brief Constructs Storage for another object directory, without following its alternates
+ * @param objects_path Path to the object directory
+ */
+Storage::Storage(const std::string& objects_path)
+    : objects_path(objects_path), object_index(objects_path) {}
+
+/**
+ * @brief Opens the alternate object directories listed in the alternates file
+ */
+void Storage::loadAlternates() {
+    std::ifstream file(objects_path + "/" + ALTERNATES_FILE);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        // Relative entries are relative to this objects directory, as in git
+        std::filesystem::path path(line);
+        if (path.is_relative()) path = std::filesystem::path(objects_path) / path;
+        path = path.lexically_normal();
+        if (isKnownObjectsDir(path)) continue;
+        alternates.push_back(std::unique_ptr<Storage>(new Storage(path.string())));
+    }
+}
+
+/**
+ * @brief Checks whether a directory is this objects directory or one of the alternates
+ * @param path Path to an objects directory
+ * @return bool True if it is already searched, false otherwise
+ */
+bool Storage::isKnownObjectsDir(const std::filesystem::path& path) const {
+    std::error_code ec;
+    if (std::filesystem::equivalent(path, objects_path, ec)) return true;
+    for (const auto& alternate : alternates) {
+        if (std::filesystem::equivalent(path, alternate->objects_path, ec)) return true;
+    }
+    return false;
 }
 
 /**
@@ -27,6 +71,10 @@ bool Storage::initialize() {
     if (mkdir(objects_path.c_str(), 0755) != 0) {
         // Ignore error if directory already exists
     }
+    
+    if (mkdir(getPackPath().c_str(), 0755) != 0) {
+        // Ignore error if directory already exists
+    }
     return true;
 }
 
@@ -39,66 +87,331 @@ std::string Storage::getObjectPath(const std::string& hash) const {
     return objects_path + "/" + hash;
 }
 
+/**
+ * @brief Writes serialized object data unless the object already exists
+ * @param hash The object's hash
+ * @param data The serialized object data
+ * @return bool True if the object is stored, false otherwise
+ */
+bool Storage::writeObject(const std::string& hash, const std::string& data) {
+    // Objects are content-addressed, so an existing file already holds this data,
+    // and one in a pack, here or in an alternate, is never copied. A local file's
+    // mtime is refreshed so gc treats a re-added object as new; if gc removed the
+    // file meanwhile, the refresh fails and the object is written again below.
+    // A loose copy in an alternate does not count: gc there may prune it.
+    std::string path = getObjectPath(hash);
+    if (objectExists(hash)) {
+        if (utime(path.c_str(), nullptr) == 0) return true;
+        if (object_index.containsPacked(hash)) return true;
+        for (const auto& alternate : alternates) {
+            if (alternate->hasPacked(hash)) return true;
+        }
+    }
+    
+    // Write to a private temporary file and rename it into place, so a crash
+    // never leaves a torn object that later stores would take as present
+    static std::atomic<unsigned> temp_counter(0);
+    std::error_code ec;
+    auto previous_mtime = std::filesystem::last_write_time(objects_path, ec);
+    std::string temp_path = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(temp_counter++);
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(data.data(), data.size());
+        file.close();
+        if (!file.good()) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    object_index.add(hash, previous_mtime);
+    return true;
+}
+
+/**
+ * @brief Reads the raw serialized data of an object, falling back to the alternates
+ * @param hash The object's hash
+ * @param data Reference to string to receive the object data
+ * @return bool True if read successful, false otherwise
+ */
+bool Storage::readObject(const std::string& hash, std::string& data) const {
+    std::ifstream file(getObjectPath(hash), std::ios::binary);
+    if (!file.is_open()) {
+        if (object_index.readPacked(hash, data)) return true;
+        for (const auto& alternate : alternates) {
+            if (alternate->readObject(hash, data)) return true;
+        }
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    data = ss.str();
+    return true;
+}
+
 /**
  * @brief Stores a Blob object to disk
  * @param blob The Blob object to store
  * @return bool True if storage successful, false otherwise
  */
 bool Storage::storeBlob(const Blob& blob) {
-    std::ofstream file(getObjectPath(blob.hash));
-    if (!file.is_open()) return false;
-    file << blob.content;
-    return file.good();
+    return writeObject(blob.hash, blob.content);
 }
 
 /**
  * @brief Stores a Tree object to disk
  * @param tree The Tree object to store
- * @return bool True if storage successful, false otherwise
+ * @return bool True if storage successful, false if it failed or the tree is malformed
  */
 bool Storage::storeTree(const Tree& tree) {
-    std::ofstream file(getObjectPath(tree.hash));
-    if (!file.is_open()) return false;
-    file << tree.serialize();
-    return file.good();
+    if (!tree.isValid()) return false;
+    return writeObject(tree.hash, tree.serialize());
 }
 
 /**
  * @brief Stores a Commit object to disk
  * @param commit The Commit object to store
- * @return bool True if storage successful, false otherwise
+ * @return bool True if storage successful, false if it failed or the commit is malformed
  */
 bool Storage::storeCommit(const Commit& commit) {
-    std::ofstream file(getObjectPath(commit.hash));
-    if (!file.is_open()) return false;
-    file << commit.serialize();
-    return file.good();
+    if (!commit.isValid()) return false;
+    return writeObject(commit.hash, commit.serialize());
 }
 
 /**
  * @brief Reads a Blob object from disk by its hash
  * @param hash The hash of the Blob to read
  * @param blob Reference to Blob object to populate with data
- * @return bool True if read successful, false otherwise
+ * @return bool True if read successful and the content matches the hash, false otherwise
  */
 bool Storage::readBlob(const std::string& hash, Blob& blob) {
-    std::ifstream file(getObjectPath(hash));
-    if (!file.is_open()) return false;
+    std::string content;
+    if (!readObject(hash, content)) return false;
     
-    std::string content((std::istreambuf_iterator<char>(file)), 
-                       std::istreambuf_iterator<char>());
-    blob = Blob(content);
+    Blob result(content);
+    // A file whose content does not hash to its name is corrupt
+    if (result.hash != hash) return false;
+    blob = result;
+    return true;
+}
+
+/**
+ * @brief Reads a Tree object from disk by its hash
+ * @param hash The hash of the Tree to read
+ * @param tree Reference to Tree object to populate with data
+ * @return bool True if read successful, false otherwise
+ */
+bool Storage::readTree(const std::string& hash, Tree& tree) {
+    std::string data;
+    if (!readObject(hash, data)) return false;
+    if (!Tree::parse(data, tree)) return false;
+    tree.hash = hash;
+    return true;
+}
+
+/**
+ * @brief Reads a Commit object from disk by its hash
+ * @param hash The hash of the Commit to read
+ * @param commit Reference to Commit object to populate with data
+ * @return bool True if read successful, false otherwise
+ */
+bool Storage::readCommit(const std::string& hash, Commit& commit) {
+    std::string data;
+    if (!readObject(hash, data)) return false;
+    if (!Commit::parse(data, commit)) return false;
+    commit.hash = hash;
     return true;
 }
 
 /**
  * @brief Checks if an object exists in storage by its hash
  * @param hash The hash to check
- * @return bool True if object exists, false otherwise
+ * @return bool True if object exists here or in an alternate, false otherwise
  */
 bool Storage::objectExists(const std::string& hash) const {
-    std::ifstream file(getObjectPath(hash));
-    return file.good();
+    lookups++;
+    if (!object_index.mightContain(hash)) {
+        bloom_negatives++;
+    } else {
+        disk_probes++;
+        struct stat st;
+        if (stat(getObjectPath(hash).c_str(), &st) == 0) return true;
+        if (object_index.containsPacked(hash)) return true;
+        false_positives++;
+    }
+    
+    for (const auto& alternate : alternates) {
+        if (alternate->objectExists(hash)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Checks if an object is stored in one of the local pack files
+ * @param hash The hash to check
+ * @return bool True if a local pack contains the object, false otherwise
+ */
+bool Storage::hasPacked(const std::string& hash) const {
+    return object_index.containsPacked(hash);
+}
+
+/**
+ * @brief Adds an object directory to the alternates file and opens it
+ * @param path Path to the other repository's objects directory
+ * @return bool True if the directory is recorded (now or before), false if it is missing or is this store
+ */
+bool Storage::addAlternate(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec).lexically_normal();
+    if (ec || !std::filesystem::is_directory(absolute, ec)) return false;
+    // This store itself is never an alternate, and a listed store is not added twice
+    if (std::filesystem::equivalent(absolute, objects_path, ec)) return false;
+    if (isKnownObjectsDir(absolute)) return true;
+    
+    std::filesystem::path file_path = std::filesystem::path(objects_path) / ALTERNATES_FILE;
+    std::filesystem::create_directories(file_path.parent_path(), ec);
+    std::ofstream file(file_path, std::ios::app);
+    if (!file.is_open()) return false;
+    file << absolute.string() << "\n";
+    if (!file.good()) return false;
+    alternates.push_back(std::unique_ptr<Storage>(new Storage(absolute.string())));
+    return true;
+}
+
+/**
+ * @brief Gets the alternate stores in the order they are searched
+ * @return const std::vector<std::unique_ptr<Storage>>& The alternates
+ */
+const std::vector<std::unique_ptr<Storage>>& Storage::getAlternates() const {
+    return alternates;
+}
+
+/**
+ * @brief Gets the path of the objects directory
+ * @return std::string Path to the objects directory
+ */
+std::string Storage::getObjectsPath() const {
+    return objects_path;
+}
+
+/**
+ * @brief Rescans the object directories if another process changed them
+ *
+ * Long-running processes call this between requests so that the
+ * in-memory object index does not miss objects stored elsewhere.
+ * Alternates are rescanned as well.
+ */
+void Storage::refresh() {
+    object_index.refreshIfChanged();
+    for (const auto& alternate : alternates) {
+        alternate->refresh();
+    }
+}
+
+/**
+ * @brief Gets a snapshot of the object lookup counters
+ * @return StorageCounters Current counter values
+ */
+StorageCounters Storage::getCounters() const {
+    StorageCounters counters;
+    counters.lookups = lookups.load();
+    counters.bloom_negatives = bloom_negatives.load();
+    counters.disk_probes = disk_probes.load();
+    counters.false_positives = false_positives.load();
+    counters.index_scans = object_index.scanCount();
+    return counters;
+}
+
+/**
+ * @brief Lists the hashes of all loose objects in the local object directory
+ * @return std::vector<std::string> Hashes of stored objects
+ */
+std::vector<std::string> Storage::listObjects() const {
+    std::vector<std::string> hashes;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(objects_path, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (isObjectName(name)) hashes.push_back(name);
+    }
+    return hashes;
+}
+
+/**
+ * @brief Lists the hashes of all objects stored in local pack files
+ * @return std::vector<std::string> Hashes of packed objects
+ */
+std::vector<std::string> Storage::listPackedObjects() const {
+    return object_index.packedObjects();
+}
+
+/**
+ * @brief Gets the directory holding pack files
+ * @return std::string Path to the pack directory
+ */
+std::string Storage::getPackPath() const {
+    return objects_path + "/" + PACK_DIR;
+}
+
+/**
+ * @brief Gets size and modification time of a loose object
+ * @param hash The object's hash
+ * @param size Reference to receive the object size in bytes
+ * @param mtime Reference to receive the modification time (seconds since epoch)
+ * @return bool True if the object exists, false otherwise
+ */
+bool Storage::statObject(const std::string& hash, std::uint64_t& size, std::int64_t& mtime) const {
+    struct stat st;
+    if (stat(getObjectPath(hash).c_str(), &st) != 0) return false;
+    size = static_cast<std::uint64_t>(st.st_size);
+    mtime = static_cast<std::int64_t>(st.st_mtime);
+    return true;
+}
+
+/**
+ * @brief Deletes a loose object
+ * @param hash The object's hash
+ * @return bool True if the object was removed, false otherwise
+ */
+bool Storage::removeObject(const std::string& hash) {
+    // The object index may still report the hash; objectExists confirms on disk
+    return std::remove(getObjectPath(hash).c_str()) == 0;
+}
+
+/**
+ * @brief Deletes a loose object unless it was stored or re-added after a cutoff
+ *
+ * The object is first renamed aside and its mtime checked on the renamed
+ * file, so a concurrent store either refreshed it before the check (and it
+ * is put back) or finds it gone and writes it again.
+ *
+ * @param hash The object's hash
+ * @param cutoff Keep the object if its mtime is later than this (seconds since epoch)
+ * @param removed Reference set to true if the object was deleted
+ * @return bool True unless the object could not be renamed or removed
+ */
+bool Storage::removeObjectIfOlder(const std::string& hash, std::int64_t cutoff, bool& removed) {
+    removed = false;
+    std::string path = getObjectPath(hash);
+    std::string doomed_path = path + ".gc." + std::to_string(getpid());
+    if (std::rename(path.c_str(), doomed_path.c_str()) != 0) {
+        return errno == ENOENT;  // removed concurrently
+    }
+    
+    struct stat st;
+    if (stat(doomed_path.c_str(), &st) != 0) return false;
+    if (static_cast<std::int64_t>(st.st_mtime) > cutoff) {
+        // Re-added since the candidate was chosen: put it back (a rewrite by
+        // the concurrent store holds the same content)
+        return std::rename(doomed_path.c_str(), path.c_str()) == 0;
+    }
+    if (std::remove(doomed_path.c_str()) != 0) return false;
+    removed = true;
+    return true;
 }
 
-} // namespace vcs
\ No newline at end of file
+} // namespace vcs
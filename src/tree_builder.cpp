@@ -0,0 +1,150 @@
+#include "tree_builder.h"
+#include "constants.h"
+
+namespace vcs {
+
+/**
+ * @brief Constructs a TreeBuilder writing to the given storage
+ * @param storage Storage to write Tree objects to
+ */
+TreeBuilder::TreeBuilder(Storage& storage) : storage(storage) {}
+
+/**
+ * @brief Reads the entries of a seeded directory that has not been loaded yet
+ * @param node The directory to load
+ * @return bool True if the directory is loaded, false if its tree cannot be read
+ */
+bool TreeBuilder::load(Node& node) {
+    if (node.loaded) return true;
+    Tree tree;
+    if (!storage.readTree(node.hash, tree)) return false;
+    for (const auto& entry : tree.entries) {
+        if (entry.type == types::TREE) {
+            std::unique_ptr<Node> child(new Node());
+            child->hash = entry.hash;
+            child->loaded = false;
+            node.directories[entry.name] = std::move(child);
+        } else {
+            node.files[entry.name] = entry;
+        }
+    }
+    node.loaded = true;
+    return true;
+}
+
+/**
+ * @brief Starts from the contents of an existing tree
+ * @param tree_hash Hash of the tree to start from
+ * @return bool True if the tree could be read, false otherwise
+ */
+bool TreeBuilder::addTree(const std::string& tree_hash) {
+    root = Node();
+    root.hash = tree_hash;
+    root.loaded = false;
+    if (!load(root)) return false;
+    // The root is rewritten whenever a file is added
+    root.hash.clear();
+    return true;
+}
+
+/**
+ * @brief Checks whether a path can name a file in a tree
+ *
+ * Empty and "." directory components are ignored. A ".." component
+ * would let checkout write outside the working tree, so it is refused.
+ *
+ * @param path Slash-separated path of the file relative to the root
+ * @return bool True if no component is ".." and the file name is not empty or ".", false otherwise
+ */
+bool TreeBuilder::isValidPath(const std::string& path) {
+    std::size_t start = 0;
+    std::size_t slash;
+    while ((slash = path.find('/', start)) != std::string::npos) {
+        if (path.compare(start, slash - start, "..") == 0) return false;
+        start = slash + 1;
+    }
+    std::string name = path.substr(start);
+    return !name.empty() && name != "." && name != "..";
+}
+
+/**
+ * @brief Adds a file to the tree being built, replacing any entry at that path
+ * @param path Slash-separated path of the file relative to the root
+ * @param blob_hash Hash of the file's blob content
+ * @param mode File permissions mode (default "100644")
+ * @return bool True if the file was added, false if the path is invalid or a seeded tree cannot be read
+ */
+bool TreeBuilder::addFile(const std::string& path, const std::string& blob_hash,
+                          const std::string& mode) {
+    if (!isValidPath(path)) return false;
+    Node* node = &root;
+    std::size_t start = 0;
+    std::size_t slash;
+    while ((slash = path.find('/', start)) != std::string::npos) {
+        std::string dir = path.substr(start, slash - start);
+        start = slash + 1;
+        // Skip empty and "." components ("./a.txt", "dir//b.txt")
+        if (dir.empty() || dir == ".") continue;
+        node->files.erase(dir);
+        auto& child = node->directories[dir];
+        if (!child) child.reset(new Node());
+        node = child.get();
+        // A seeded directory is read on first change and rewritten on write()
+        if (!load(*node)) return false;
+        node->hash.clear();
+    }
+
+    TreeEntry entry;
+    entry.mode = mode;
+    entry.type = types::BLOB;
+    entry.hash = blob_hash;
+    entry.name = path.substr(start);
+    node->directories.erase(entry.name);
+    node->files[entry.name] = entry;
+    return true;
+}
+
+/**
+ * @brief Stores a directory and all of its subdirectories bottom-up
+ * @param node The directory to store
+ * @param hash Reference to string to receive the stored tree hash
+ * @return bool True if all trees were stored, false otherwise
+ */
+bool TreeBuilder::writeNode(const Node& node, std::string& hash) {
+    // An unchanged seeded directory is already stored
+    if (!node.hash.empty()) {
+        hash = node.hash;
+        return true;
+    }
+
+    // Merge directories and files in name order so equal content gives equal hashes
+    std::map<std::string, TreeEntry> sorted = node.files;
+    for (const auto& dir : node.directories) {
+        TreeEntry entry;
+        entry.mode = "40000";
+        entry.type = types::TREE;
+        entry.name = dir.first;
+        if (!writeNode(*dir.second, entry.hash)) return false;
+        sorted[entry.name] = entry;
+    }
+
+    Tree tree;
+    for (const auto& pair : sorted) {
+        tree.addEntry(pair.second);
+    }
+    tree.hash = tree.calculateHash();
+    if (!storage.storeTree(tree)) return false;
+    hash = tree.hash;
+    return true;
+}
+
+/**
+ * @brief Stores all trees and returns the hash of the root tree
+ * @param root_hash Reference to string to receive the root tree hash
+ * @return bool True if all trees were stored, false otherwise
+ */
+bool TreeBuilder::write(std::string& root_hash) {
+    return writeNode(root, root_hash);
+}
+
+} // namespace vcs
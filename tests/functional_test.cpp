@@ -0,0 +1,787 @@
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <regex>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "commit_graph.h"
+#include "constants.h"
+#include "grep.h"
+#include "merge.h"
+#include "pack.h"
+#include "object.h"
+#include "tree_builder.h"
+
+namespace vcs {
+
+/**
+ * @brief End-to-end checks of the myvcs command line in scratch repositories
+ *
+ * Every check runs in its own empty directory below the test root and
+ * drives the real binary, so the on-disk formats are exercised as well.
+ */
+class FunctionalTester {
+private:
+    const std::string binary = MYVCS_BINARY;
+    std::filesystem::path root;     // Каталог для временных репозиториев
+    int failures = 0;
+
+public:
+    explicit FunctionalTester(const std::filesystem::path& root) : root(std::filesystem::absolute(root)) {
+        std::filesystem::remove_all(this->root);
+        std::filesystem::create_directories(this->root);
+    }
+
+    int getFailures() const {
+        return failures;
+    }
+
+    void expect(bool condition, const std::string& what) {
+        if (!condition) {
+            std::cerr << "FAIL: " << what << std::endl;
+            failures++;
+        }
+    }
+
+    // Новый пустой каталог, ставший текущим
+    void enter(const std::string& name) {
+        std::filesystem::path dir = root / name;
+        std::filesystem::create_directories(dir);
+        std::filesystem::current_path(dir);
+    }
+
+    // Запуск myvcs: возвращает код завершения, вывод (stdout и stderr) в output
+    int run(const std::string& args, std::string& output) {
+        FILE* pipe = popen((binary + " " + args + " 2>&1").c_str(), "r");
+        if (!pipe) return -1;
+        output.clear();
+        char buffer[4096];
+        std::size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+            output.append(buffer, n);
+        }
+        int status = pclose(pipe);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    int run(const std::string& args) {
+        std::string output;
+        return run(args, output);
+    }
+
+    void writeFile(const std::string& path, const std::string& content) {
+        std::filesystem::path file(path);
+        if (file.has_parent_path()) std::filesystem::create_directories(file.parent_path());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    std::string readHead() {
+        std::string head = readFile(".my_vcs/HEAD");
+        while (!head.empty() && (head.back() == '\n' || head.back() == '\r')) head.pop_back();
+        return head;
+    }
+
+    void testCommitSnapshot() {
+        // Второй коммит хранит полный снимок, а не только заново добавленные файлы
+        enter("commit_snapshot");
+        run("init");
+        writeFile("src/a.txt", "a\n");
+        writeFile("b.txt", "b\n");
+        run("add src/a.txt");
+        run("add b.txt");
+        expect(run("commit first") == 0, "first commit");
+        writeFile("b.txt", "b2\n");
+        run("add b.txt");
+        expect(run("commit second") == 0, "second commit");
+
+        std::string log;
+        run("log -- src/a.txt", log);
+        expect(log.find("second") == std::string::npos, "log -- src/a.txt skips the commit that did not touch it");
+        expect(log.find("first") != std::string::npos, "log -- src/a.txt lists the commit that added it");
+
+        std::filesystem::remove_all("src");
+        std::filesystem::remove("b.txt");
+        expect(run("checkout HEAD") == 0, "checkout HEAD");
+        expect(readFile("src/a.txt") == "a\n", "checkout restores the file not restaged in the second commit");
+        expect(readFile("b.txt") == "b2\n", "checkout restores the file changed in the second commit");
+    }
+
+    void testDotDotPaths() {
+        // Путь с ".." не попадает ни в индекс, ни в дерево коммита
+        enter("dotdot_paths");
+        run("init");
+        writeFile("../dotdot_outside.txt", "outside\n");
+        writeFile("dir/a.txt", "a\n");
+        std::string output;
+        expect(run("add ../dotdot_outside.txt", output) != 0 && output.find("Error: Invalid path") != std::string::npos,
+               "add rejects a path leaving the working tree");
+        expect(run("add dir/../dir/a.txt", output) != 0 && output.find("Error: Invalid path") != std::string::npos,
+               "add rejects a path with a .. component");
+        expect(readFile(".my_vcs/index").find("..") == std::string::npos, "rejected paths are not staged");
+
+        // Индекс, записанный в обход add, не даёт создать такой коммит
+        Blob blob("outside\n");
+        Storage storage;
+        storage.storeBlob(blob);
+        writeFile(".my_vcs/index", "../dotdot_outside.txt " + blob.hash + " 0 0 0 1\n");
+        expect(run("commit escape", output) != 0 && output.find("Error: Invalid path") != std::string::npos,
+               "commit rejects a .. path in the index");
+        expect(readHead().empty(), "no commit is created");
+    }
+
+    void testCheckoutDoesNotStage() {
+        // Checkout старого коммита не подкладывает его файлы в следующий коммит
+        enter("checkout_no_stage");
+        run("init");
+        writeFile("a.txt", "v1\n");
+        run("add a.txt");
+        run("commit first");
+        std::string first = readHead();
+        writeFile("a.txt", "v2\n");
+        run("add a.txt");
+        run("commit second");
+
+        std::string output;
+        expect(run("checkout " + first) == 0 && readFile("a.txt") == "v1\n", "checkout of the first commit");
+        run("status", output);
+        expect(output.find("a.txt") == std::string::npos, "checkout stages nothing");
+        writeFile("b.txt", "b\n");
+        run("add b.txt");
+        expect(run("commit third") == 0, "commit after checkout");
+        std::filesystem::remove("a.txt");
+        expect(run("checkout HEAD") == 0 && readFile("a.txt") == "v2\n",
+               "commit after checkout keeps the content of HEAD");
+        writeFile("a.txt", "v3\n");
+        run("add a.txt");
+        run("checkout " + first);
+        run("status", output);
+        expect(output.find("a.txt") != std::string::npos, "checkout keeps a staged entry staged");
+    }
+
+    void testObjectIndexFile() {
+        // Фильтр объектов сохраняется на диск, и следующий процесс не сканирует каталог заново
+        enter("object_index_file");
+        run("init");
+        writeFile("a.txt", "a\n");
+        run("add a.txt");
+        run("commit first");
+        setenv("MYVCS_TRACE", "1", 1);
+        std::string output;
+        writeFile("b.txt", "b\n");
+        expect(run("add b.txt", output) == 0 && output.find("index scans 0") != std::string::npos,
+               "add reuses the saved object index");
+        expect(run("exists " + Blob("b\n").hash, output) == 0 && output.find("index scans 0") != std::string::npos &&
+               output.find("yes") != std::string::npos, "objects stored by the previous process are in the saved index");
+
+        // Чужое изменение каталога объектов делает сохранённый фильтр устаревшим
+        writeFile(".my_vcs/objects/" + Blob("foreign\n").hash, "foreign\n");
+        expect(run("exists " + Blob("foreign\n").hash, output) == 0 && output.find("index scans 1") != std::string::npos &&
+               output.find("yes") != std::string::npos, "a foreign store forces a rescan");
+
+        // После упаковки объекты находятся в пакете без повторного сканирования
+        expect(run("repack") == 0, "repack succeeds");
+        expect(run("exists " + Blob("a\n").hash, output) == 0 && output.find("index scans 0") != std::string::npos &&
+               output.find("yes") != std::string::npos, "repack saves an index that covers the new pack");
+        unsetenv("MYVCS_TRACE");
+        std::filesystem::remove("a.txt");
+        expect(run("checkout HEAD") == 0 && readFile("a.txt") == "a\n", "packed objects are read back");
+    }
+
+    void testServeIndexRefresh() {
+        // Долгоживущий batch-процесс видит индекс, изменённый другим процессом, и не затирает его
+        enter("serve_index_refresh");
+        run("init");
+        writeFile("a.txt", "a\n");
+        writeFile("b.txt", "b\n");
+        FILE* batch = popen((binary + " batch > batch.out 2>&1").c_str(), "w");
+        expect(batch != nullptr, "start batch");
+        if (!batch) return;
+        std::fputs("status\n", batch);
+        std::fflush(batch);
+        expect(run("add a.txt") == 0, "add from another process");
+        std::fputs("add b.txt\nquit\n", batch);
+        pclose(batch);
+
+        std::string status;
+        run("status", status);
+        expect(status.find("a.txt") != std::string::npos, "batch add keeps the entry staged by another process");
+        expect(status.find("b.txt") != std::string::npos, "batch add is saved");
+    }
+
+    // Unix-сокет по пути: привязанный (bind) или подключённый к серверу (connect)
+    int openSocket(const std::string& path, bool bind_only) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        int rc = bind_only ? ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+                           : ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        if (rc != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void testServeSocketPath() {
+        // serve заменяет только оставшийся сокет и никогда не удаляет обычный файл
+        enter("serve_socket_path");
+        run("init");
+        writeFile("victim.txt", "keep me\n");
+        std::string output;
+        expect(run("serve victim.txt", output) != 0 && output.find("not a socket") != std::string::npos,
+               "serve refuses a path that is not a socket");
+        expect(readFile("victim.txt") == "keep me\n", "the file at the socket path survives");
+
+        // Сокет от упавшего сервера: файл есть, но никто не слушает
+        int stale = openSocket("vcs.sock", true);
+        expect(stale >= 0, "create a stale socket");
+        if (stale < 0) return;
+        ::close(stale);
+        expect(std::system((binary + " serve vcs.sock > serve.out 2>&1 &").c_str()) == 0, "start serve");
+        int client = -1;
+        for (int attempt = 0; attempt < 200 && client < 0; attempt++) {
+            client = openSocket("vcs.sock", false);
+            if (client < 0) ::usleep(10000);
+        }
+        expect(client >= 0, "serve replaces a stale socket and accepts connections");
+        if (client < 0) return;
+        const std::string request = "exists 0000000000000000\nquit\n";
+        expect(::write(client, request.data(), request.size()) == static_cast<ssize_t>(request.size()),
+               "send requests");
+        std::string reply;
+        char buffer[256];
+        ssize_t n;
+        while ((n = ::read(client, buffer, sizeof(buffer))) > 0) reply.append(buffer, static_cast<std::size_t>(n));
+        ::close(client);
+        expect(reply.find("no") != std::string::npos, "serve answers on the replaced socket");
+    }
+
+    void testGcWithMissingObjects() {
+        // Нечитаемое дерево не должно превращать всё под ним в мусор
+        enter("gc_missing");
+        run("init");
+        writeFile("dir/a.txt", "a\n");
+        run("add dir/a.txt");
+        run("commit first");
+        std::string commit_hash = readHead();
+        std::string tree_hash, blob_hash;
+        run("hash-object dir/a.txt", blob_hash);
+        blob_hash = blob_hash.substr(0, 16);
+        
+        // Корневое дерево удаляется, поддерево и блоб остаются
+        std::string log;
+        for (const auto& entry : std::filesystem::directory_iterator(".my_vcs/objects")) {
+            std::string name = entry.path().filename().string();
+            if (name.size() != 16 || name == commit_hash || name == blob_hash) continue;
+            std::string type;
+            run("cat-object " + name, type);
+            if (type.find("dir") != std::string::npos) tree_hash = name;
+        }
+        expect(!tree_hash.empty(), "root tree found");
+        std::filesystem::remove(".my_vcs/objects/" + tree_hash);
+        
+        expect(run("gc --prune=0") != 0, "gc fails when a reachable object is missing");
+        expect(std::filesystem::exists(".my_vcs/objects/" + blob_hash), "gc keeps objects below the missing tree");
+    }
+
+    void writeGzip(const std::string& path, const std::string& data) {
+        gzFile file = gzopen(path.c_str(), "wb");
+        if (!file) return;
+        gzwrite(file, data.data(), static_cast<unsigned>(data.size()));
+        gzclose(file);
+    }
+
+    void testGcPruneOption() {
+        // --prune принимает только неотрицательное целое число секунд
+        enter("gc_prune_option");
+        run("init");
+        writeFile("a.txt", "a\n");
+        run("add a.txt");
+        std::string output;
+        for (const char* bad : {"2.weeks.ago", "abc", "", "-5", " 5", "+5", "99999999999999999999"}) {
+            expect(run("gc \"--prune=" + std::string(bad) + "\"", output) != 0 &&
+                   output.find("Error: Invalid prune") != std::string::npos,
+                   "gc rejects --prune=" + std::string(bad));
+        }
+        expect(run("gc --prune=0 --dry-run") == 0, "gc accepts --prune=0");
+        expect(run("gc --prune=1209600") == 0 && run("exists " + Blob("a\n").hash, output) == 0 &&
+               output.find("yes") != std::string::npos, "gc with a long grace period keeps new objects");
+    }
+
+    void testBundleRoundTrip() {
+        // Бандл переносит историю в пустой репозиторий, HEAD двигается только вперёд
+        enter("bundle_source");
+        run("init");
+        writeFile("dir/a.txt", "a\n");
+        run("add dir/a.txt");
+        run("commit first");
+        writeFile("b.txt", "b\n");
+        run("add b.txt");
+        run("commit second");
+        std::string tip = readHead();
+        std::string bundle_path = (root / "history.bundle").string();
+        expect(run("bundle create " + bundle_path + " HEAD") == 0, "bundle create");
+
+        enter("bundle_target");
+        run("init");
+        std::string output;
+        expect(run("bundle unbundle " + bundle_path + " --update-head", output) == 0, "bundle unbundle");
+        expect(output.find("tip " + tip) != std::string::npos, "unbundle lists the tip");
+        expect(readHead() == tip, "unbundle --update-head moves HEAD to the tip");
+        expect(run("checkout HEAD") == 0, "checkout of the unbundled tip");
+        expect(readFile("dir/a.txt") == "a\n" && readFile("b.txt") == "b\n", "unbundled tree is complete");
+        run("fsck", output);
+        expect(output.find("0 corrupt, 0 missing") != std::string::npos, "fsck after unbundle");
+
+        // Несвязанный HEAD не перезаписывается
+        enter("bundle_unrelated");
+        run("init");
+        writeFile("c.txt", "c\n");
+        run("add c.txt");
+        run("commit other");
+        std::string head = readHead();
+        expect(run("bundle unbundle " + bundle_path + " --update-head") != 0, "unbundle refuses a non-fast-forward");
+        expect(readHead() == head, "HEAD stays on unrelated history");
+
+        // Повреждённые заголовки и длины отклоняются без падения
+        enter("bundle_hostile");
+        run("init");
+        std::string signature = "# myvcs bundle v1\n";
+        writeGzip("count.bundle", signature + "objects abc\n\n");
+        writeGzip("huge.bundle", signature + "objects 1\n\n" + std::string(8, 'x') +
+                                 std::string("\xff\xff\xff\xff\xff\xff\xff\x7f", 8));
+        writeGzip("short.bundle", signature + "objects 1\n\n" + std::string(8, 'x') + "\x80\x80\x10" + "abc");
+        writeGzip("suffix.bundle", signature + tip + " HEAD\nobjects 0\n\n");
+        for (const char* name : {"count.bundle", "huge.bundle", "short.bundle", "suffix.bundle"}) {
+            run(std::string("bundle unbundle ") + name, output);
+            expect(output.find("Error: Cannot read bundle") != std::string::npos,
+                   std::string("malformed ") + name + " is rejected cleanly");
+        }
+
+        // Каждая запись бандла: сырой хеш, varint-длина, данные
+        std::filesystem::path source_objects = root / "bundle_source" / ".my_vcs" / "objects";
+        auto record = [&](const std::string& hash) {
+            std::string raw, data = readFile((source_objects / hash).string());
+            hexToRaw(hash, raw);
+            std::uint64_t length = data.size();
+            while (length >= 0x80) {
+                raw.push_back(static_cast<char>((length & 0x7f) | 0x80));
+                length >>= 7;
+            }
+            raw.push_back(static_cast<char>(length));
+            return raw + data;
+        };
+
+        // Повторяющиеся записи упаковываются один раз
+        std::string records;
+        std::size_t object_count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(source_objects)) {
+            std::string name = entry.path().filename().string();
+            if (name.size() != 16 || !entry.is_regular_file()) continue;
+            records += record(name) + record(name);
+            object_count++;
+        }
+        enter("bundle_duplicates");
+        run("init");
+        writeGzip("twice.bundle", signature + tip + "\nobjects " + std::to_string(object_count * 2) + "\n\n" + records);
+        expect(run("bundle unbundle twice.bundle --update-head", output) == 0 &&
+               output.find("Unpacked " + std::to_string(object_count) + " objects") != std::string::npos &&
+               output.find("(" + std::to_string(object_count) + " already present)") != std::string::npos,
+               "duplicate records are packed once");
+        expect(readHead() == tip, "bundle with duplicates moves HEAD");
+
+        // Бандл без дерева коммита отклоняется, HEAD и пакеты не меняются
+        enter("bundle_incomplete");
+        run("init");
+        writeGzip("commit_only.bundle", signature + tip + "\nobjects 1\n\n" + record(tip));
+        expect(run("bundle unbundle commit_only.bundle --update-head", output) != 0 &&
+               output.find("Error: Bundle tips need missing object") != std::string::npos,
+               "a bundle whose tip lacks its tree is rejected");
+        expect(readHead().empty(), "HEAD is not touched by an incomplete bundle");
+        expect(run("exists " + tip, output) == 0 && output.find("no") != std::string::npos,
+               "the pack of an incomplete bundle is removed");
+    }
+
+    // Число в little-endian, как в заголовках pack-файлов
+    static std::string u64(std::uint64_t value) {
+        std::string bytes;
+        for (int i = 0; i < 8; i++) bytes.push_back(static_cast<char>(value >> (8 * i)));
+        return bytes;
+    }
+
+    void testTreeEntryModes() {
+        // Режим записи должен соответствовать её типу: 40000 для деревьев,
+        // 100644 или 100755 для файлов
+        enter("tree_entry_modes");
+        run("init");
+        Storage storage;
+        Blob blob("a\n");
+        storage.storeBlob(blob);
+        Tree empty;
+        empty.hash = empty.calculateHash();
+        storage.storeTree(empty);
+        auto store = [&](const std::string& mode, const std::string& type, const std::string& hash) {
+            Tree tree;
+            tree.addEntry({mode, type, hash, "entry"});
+            tree.hash = tree.calculateHash();
+            return storage.storeTree(tree);
+        };
+        expect(store("100644", types::BLOB, blob.hash), "regular file entry is stored");
+        expect(store("100755", types::BLOB, blob.hash), "executable file entry is stored");
+        expect(store("40000", types::TREE, empty.hash), "subtree entry is stored");
+        expect(!store("40000", types::BLOB, blob.hash), "file entry with a directory mode is rejected");
+        expect(!store("100644", types::TREE, empty.hash), "subtree entry with a file mode is rejected");
+        expect(!store("100600", types::BLOB, blob.hash), "file entry with an unknown mode is rejected");
+    }
+
+    void testHostilePack() {
+        // Размеры из .idx и pack-файла проверяются до выделения памяти
+        enter("hostile_pack");
+        run("init");
+        writeFile(".my_vcs/objects/pack/pack-bad.idx", "MVIX" + u64(1) + u64(1ULL << 61));
+        writeFile(".my_vcs/objects/pack/pack-bad.pack", "MVPK" + u64(1));
+        writeFile("a.txt", "a\n");
+        std::string output;
+        expect(run("add a.txt") == 0, "add next to a pack with an impossible entry count");
+        expect(run("fsck", output) != 0 && output.find("bad pack") != std::string::npos,
+               "fsck reports the bad pack");
+
+        // Запись с длиной больше самого pack-файла
+        std::filesystem::remove(".my_vcs/objects/pack/pack-bad.idx");
+        std::filesystem::remove(".my_vcs/objects/pack/pack-bad.pack");
+        writeFile("huge.idx", "MVIX" + u64(1) + u64(1) + u64(0x1234) + u64(12));
+        writeFile("huge.pack", "MVPK" + u64(1) + "\x05" + "\x80\x80\x80\x80\x80\x20" + "xx");
+        PackReader pack;
+        std::string data;
+        expect(pack.open("huge.idx"), "pack with a consistent index opens");
+        expect(!pack.read(0x1234, data), "record longer than the pack is rejected");
+    }
+
+    void testGrepLiterals() {
+        // Операнды \x, \u и \c не являются обязательными литералами
+        using Literals = std::vector<std::string>;
+        expect(TreeGrep::requiredLiterals("TODO.*hash") == Literals({"TODO", "hash"}), "literals around .*");
+        expect(TreeGrep::requiredLiterals("\\x41BC") == Literals({"BC"}), "\\x operand is skipped");
+        expect(TreeGrep::requiredLiterals("A\\x42C") == Literals({"A", "C"}), "\\x operand inside a literal");
+        expect(TreeGrep::requiredLiterals("\\u0041BC") == Literals({"BC"}), "\\u operand is skipped");
+        expect(TreeGrep::requiredLiterals("\\cJabc") == Literals({"abc"}), "\\c operand is skipped");
+        expect(TreeGrep::requiredLiterals("ab\\d+cd") == Literals({"ab", "cd"}), "class escape splits literals");
+        expect(TreeGrep::requiredLiterals("a\\.b") == Literals({"a.b"}), "escaped punctuation is literal");
+        expect(TreeGrep::requiredLiterals("abc?d") == Literals({"ab", "d"}), "optional character is dropped");
+        expect(TreeGrep::requiredLiterals("ab|cd").empty(), "alternation has no required literals");
+
+        enter("grep_escapes");
+        run("init");
+        writeFile("a.txt", "hello ABC world\n");
+        run("add a.txt");
+        run("commit first");
+        std::string output;
+        expect(run("grep '\\x41BC'", output) == 0 && output.find("hello ABC world") != std::string::npos,
+               "grep '\\x41BC' finds the line");
+        expect(run("grep 'A\\x42C'", output) == 0 && output.find("hello ABC world") != std::string::npos,
+               "grep 'A\\x42C' finds the line");
+    }
+
+    void testLineRegex() {
+        // Линейный NFA совпадает с std::regex на коротких строках
+        const std::vector<std::string> patterns = {
+            "abc", "a.c", "^ab", "c$", "^$", "a*b", "a+b", "ab?c", "a{2}", "a{1,2}b", "a{2,}", "(ab)+c",
+            "(?:a|b)+$", "x|y|abc", "[a-c]+", "[^a-c]", "[]a]", "[\\]]", "\\d+", "\\D", "\\w+\\s\\w",
+            "\\bab", "b\\B", "\\x41", "\\u0042", "\\.", "a.*b$", "(a|)+c", "(a*)*b", "[-a]", "[a-]",
+            "a+?b", "A\\x42C", "\\t", "h[ae]llo", "((a|b)c)*d", "", "a{0}b", "[\\d_]+x"};
+        const std::vector<std::string> lines = {
+            "", "abc", "aabc", "xbc", "ab", "a", "b", "ABC", "hello ABC world", "a.c", "a]c", "12 ab",
+            "ab ab", "ac", "aaab", "ccd", "acbcd", "\tx", "hallo", "_9x", "-", "abababc", "ba", "cab"};
+        for (bool ignore_case : {false, true}) {
+            for (const auto& pattern : patterns) {
+                LineRegex matcher;
+                auto flags = std::regex::ECMAScript;
+                if (ignore_case) flags |= std::regex::icase;
+                std::regex reference(pattern, flags);
+                expect(matcher.compile(pattern, ignore_case), "compile " + pattern);
+                for (const auto& line : lines) {
+                    expect(matcher.search(line) == std::regex_search(line, reference),
+                           "'" + pattern + "' on '" + line + "'" + (ignore_case ? " ignoring case" : ""));
+                }
+            }
+        }
+        LineRegex matcher;
+        expect(!matcher.compile("(a)\\1", false), "backreference is left to std::regex");
+        expect(!matcher.compile("a(?=b)", false), "lookahead is left to std::regex");
+
+        // Длинная строка не переполняет стек ни в NFA, ни в запасном std::regex
+        enter("grep_long_line");
+        run("init");
+        std::string long_line;
+        for (int i = 0; i < 20000; i++) long_line += "ab";
+        writeFile("min.js", long_line + "\n");
+        run("add min.js");
+        run("commit first");
+        std::string output;
+        expect(run("grep 'a.*b$'", output) == 0 && output.find("min.js:1:") == 0, "grep 'a.*b$' on a long line");
+        expect(run("grep '(a|b)+$'", output) == 0 && output.find("min.js:1:") == 0, "grep '(a|b)+$' on a long line");
+        expect(run("grep '(a)b\\1.*b$'", output) != 0 && output.find("long lines were not searched") != std::string::npos,
+               "backreference pattern skips the long line with a warning");
+    }
+
+    void testAlternates() {
+        // Общее хранилище: чтение через alternates, repack --shared и gc в общем репозитории
+        enter("alternates_shared");
+        run("init");
+        writeFile("s.txt", "shared\n");
+        run("add s.txt");
+        run("commit shared");
+        std::string shared_head = readHead();
+        // Незакоммиченная версия x.txt остаётся в общем хранилище недостижимым свободным объектом
+        writeFile("x.txt", "local\n");
+        run("add x.txt");
+        writeFile("x.txt", "other\n");
+        run("add x.txt");
+        std::string shared_objects = (root / "alternates_shared" / ".my_vcs" / "objects").string();
+
+        enter("alternates_local");
+        run("init");
+        std::string output;
+        expect(run("alternates add .my_vcs/objects") != 0, "own objects directory is not an alternate");
+        expect(run("alternates add " + shared_objects) == 0, "alternates add");
+        expect(run("alternates add " + shared_objects) == 0, "repeated alternates add");
+        run("alternates", output);
+        expect(output == shared_objects + "\n", "alternate is listed once");
+        expect(run("checkout " + shared_head) == 0 && readFile("s.txt") == "shared\n",
+               "checkout reads the commit, tree and blob from the alternate");
+
+        writeFile("l.txt", "local\n");
+        run("add l.txt");
+        run("commit local");
+        expect(run("repack --shared") == 0, "repack --shared");
+
+        enter("alternates_shared");
+        expect(run("gc --prune=0") == 0, "gc in the shared repository");
+
+        enter("alternates_local");
+        std::filesystem::remove("l.txt");
+        expect(run("checkout HEAD") == 0 && readFile("l.txt") == "local\n",
+               "objects moved by repack --shared survive gc in the shared repository");
+        run("fsck", output);
+        expect(output.find("0 corrupt, 0 missing") != std::string::npos, "fsck after repack --shared");
+
+        // Коммит в alternate, блоб которого потерян, не проходит fsck
+        enter("alternates_broken_shared");
+        run("init");
+        writeFile("a.txt", "a\n");
+        run("add a.txt");
+        run("commit first");
+        std::string broken_head = readHead();
+        std::filesystem::remove(".my_vcs/objects/" + Blob("a\n").hash);
+        std::string broken_objects = (root / "alternates_broken_shared" / ".my_vcs" / "objects").string();
+
+        enter("alternates_broken_local");
+        run("init");
+        run("alternates add " + broken_objects);
+        writeFile(".my_vcs/HEAD", broken_head + "\n");
+        expect(run("fsck", output) != 0 && output.find("0 missing") == std::string::npos,
+               "fsck follows history kept in an alternate");
+    }
+
+    void testMergeBase() {
+        // Отметки времени с перекосом часов не влияют на выбор базы:
+        // R — предок A, поэтому лучшая база X и Y — это A, а не R
+        enter("merge_base");
+        run("init");
+        Storage storage;
+        Tree empty;
+        empty.hash = empty.calculateHash();
+        storage.storeTree(empty);
+        auto makeCommit = [&](const std::string& timestamp, const std::vector<std::string>& parents) {
+            Commit commit;
+            commit.tree_hash = empty.hash;
+            commit.parent_hashes = parents;
+            commit.author = "tester";
+            commit.message = "at " + timestamp;
+            commit.timestamp = timestamp;
+            commit.hash = commit.calculateHash();
+            storage.storeCommit(commit);
+            return commit.hash;
+        };
+        std::string r = makeCommit("50", {});
+        std::string a = makeCommit("5", {r});
+        std::string p = makeCommit("1", {a});
+        std::string x = makeCommit("100", {p, r});
+        std::string y = makeCommit("100", {a});
+        TreeMerger merger(storage);
+        std::string base;
+        expect(merger.findMergeBase(x, y, base) && base == a, "merge base is not an ancestor of another common ancestor");
+        expect(merger.findMergeBase(y, x, base) && base == a, "merge base does not depend on the argument order");
+        expect(merger.findMergeBase(x, r, base) && base == r, "merge base of a commit and its ancestor");
+
+        // С графом коммитов и номерами поколений ответы те же
+        CommitGraph graph("merge_base_graph");
+        for (const auto& hash : {r, a, p, x, y}) {
+            Commit commit;
+            storage.readCommit(hash, commit);
+            graph.append(hash, CommitGraph::makeEntry(commit, {}));
+        }
+        TreeMerger graph_merger(storage, &graph);
+        expect(graph_merger.findMergeBase(x, y, base) && base == a, "merge base with the commit graph");
+        expect(graph_merger.findMergeBase(y, x, base) && base == a, "merge base with the commit graph in either order");
+        expect(graph_merger.findMergeBase(x, r, base) && base == r, "ancestor is the base with the commit graph");
+    }
+
+    void testMergeConflicts() {
+        // Конфликт строк: маркеры с метками сторон; правки в разных местах сливаются чисто
+        std::string merged;
+        expect(!TreeMerger::mergeText("1\n2\n3\n", "1\nours\n3\n", "1\ntheirs\n3\n", "OURS", "THEIRS", merged) &&
+               merged == "1\n<<<<<<< OURS\nours\n=======\ntheirs\n>>>>>>> THEIRS\n3\n",
+               "mergeText writes conflict markers around both sides");
+        expect(TreeMerger::mergeText("1\n2\n3\n4\n5\n", "one\n2\n3\n4\n5\n", "1\n2\n3\n4\nfive\n", "OURS", "THEIRS",
+                                     merged) && merged == "one\n2\n3\n4\nfive\n",
+               "mergeText merges edits of different lines");
+
+        // Все виды конфликтов через merge-tree: ненулевой код и строки "conflict <вид> <путь>"
+        enter("merge_conflicts");
+        run("init");
+        Storage storage;
+        auto makeCommit = [&](const std::map<std::string, std::string>& files, const std::vector<std::string>& parents) {
+            TreeBuilder builder(storage);
+            for (const auto& file : files) {
+                Blob blob(file.second);
+                storage.storeBlob(blob);
+                builder.addFile(file.first, blob.hash);
+            }
+            Commit commit;
+            builder.write(commit.tree_hash);
+            commit.parent_hashes = parents;
+            commit.author = "tester";
+            commit.message = "commit";
+            commit.timestamp = std::to_string(1000 + parents.size());
+            commit.hash = commit.calculateHash();
+            storage.storeCommit(commit);
+            return commit.hash;
+        };
+        std::string base = makeCommit({{"text.txt", "1\n2\n3\n"}, {"gone.txt", "keep\n"},
+                                       {"image.bin", std::string("\0base", 5)}, {"same.txt", "same\n"}}, {});
+        std::string ours = makeCommit({{"text.txt", "1\nours\n3\n"}, {"gone.txt", "keep, edited\n"},
+                                       {"image.bin", std::string("\0ours", 5)}, {"same.txt", "same\n"},
+                                       {"node", "file\n"}}, {base});
+        std::string theirs = makeCommit({{"text.txt", "1\ntheirs\n3\n"}, {"image.bin", std::string("\0theirs", 7)},
+                                         {"same.txt", "same\n"}, {"node/inner.txt", "inner\n"}}, {base});
+
+        std::string output;
+        expect(run("merge-tree " + ours + " " + theirs, output) != 0, "merge-tree fails on conflicts");
+        for (const char* line : {"conflict content text.txt", "conflict modify/delete gone.txt",
+                                 "conflict binary image.bin", "conflict file/directory node",
+                                 "Error: Merge has 4 conflicts"}) {
+            expect(output.find(line) != std::string::npos, std::string("merge-tree reports ") + line);
+        }
+        expect(output.find("same.txt") == std::string::npos, "unchanged files do not conflict");
+
+        // Результат: маркеры в тексте, изменённый файл сохранён, у двоичного — наша версия
+        std::smatch match;
+        std::string tree_hash = std::regex_search(output, match, std::regex("tree ([0-9a-f]{16})")) ? match[1].str() : "";
+        Tree tree;
+        expect(storage.readTree(tree_hash, tree), "merge-tree prints the merged tree");
+        std::map<std::string, std::string> contents;
+        for (const auto& entry : tree.entries) {
+            Blob blob("");
+            if (entry.type == types::BLOB && storage.readBlob(entry.hash, blob)) contents[entry.name] = blob.content;
+        }
+        expect(contents["text.txt"] == "1\n<<<<<<< " + ours + "\nours\n=======\ntheirs\n>>>>>>> " + theirs + "\n3\n",
+               "content conflict is written with markers labelled by commit");
+        expect(contents["gone.txt"] == "keep, edited\n", "modify/delete keeps the modification");
+        expect(contents["image.bin"] == std::string("\0ours", 5), "binary conflict keeps our version");
+        expect(contents["node"] == "file\n", "file/directory conflict keeps our file");
+    }
+
+    void testMergeTreeHead() {
+        // --update-head двигает HEAD только от ours; предок другой стороны не даёт коммита слияния
+        enter("merge_tree_head");
+        run("init");
+        writeFile("a.txt", "base\n");
+        run("add a.txt");
+        run("commit base");
+        std::string base = readHead();
+        writeFile("b.txt", "theirs\n");
+        run("add b.txt");
+        run("commit theirs");
+        std::string theirs = readHead();
+        writeFile(".my_vcs/HEAD", base + "\n");
+        writeFile("a.txt", "ours\n");
+        run("add a.txt");
+        run("commit ours");
+        std::string ours = readHead();
+
+        std::string output;
+        expect(run("merge-tree --update-head " + theirs + " " + ours) != 0 && readHead() == ours,
+               "merge-tree --update-head refuses when ours is not HEAD");
+        expect(run("merge-tree --update-head HEAD " + theirs, output) == 0 &&
+               output.find("Merged ") != std::string::npos, "merge-tree --update-head merges into HEAD");
+        std::string merged = readHead();
+        expect(merged != ours, "HEAD moves to the merge commit");
+
+        expect(run("merge-tree --update-head HEAD " + theirs, output) == 0 &&
+               output.find("Already up to date") != std::string::npos && readHead() == merged,
+               "merging an ancestor creates no commit");
+        writeFile(".my_vcs/HEAD", theirs + "\n");
+        expect(run("merge-tree --update-head HEAD " + merged, output) == 0 &&
+               output.find("Fast-forward") != std::string::npos && readHead() == merged,
+               "merging a descendant fast-forwards HEAD");
+        std::filesystem::remove("a.txt");
+        std::filesystem::remove("b.txt");
+        expect(run("checkout HEAD") == 0 && readFile("a.txt") == "ours\n" && readFile("b.txt") == "theirs\n",
+               "merged tree has both changes");
+    }
+
+    void runAll() {
+        testCommitSnapshot();
+        testCheckoutDoesNotStage();
+        testDotDotPaths();
+        testObjectIndexFile();
+        testServeIndexRefresh();
+        testServeSocketPath();
+        testGcWithMissingObjects();
+        testGcPruneOption();
+        testBundleRoundTrip();
+        testTreeEntryModes();
+        testHostilePack();
+        testGrepLiterals();
+        testLineRegex();
+        testAlternates();
+        testMergeBase();
+        testMergeConflicts();
+        testMergeTreeHead();
+    }
+};
+
+} // namespace vcs
+
+int main(int argc, char* argv[]) {
+    vcs::FunctionalTester tester(argc >= 2 ? argv[1] : "functional_test_repos");
+    tester.runAll();
+    if (tester.getFailures() > 0) {
+        std::cerr << tester.getFailures() << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -4,11 +4,27 @@
 #include <vector>
 #include <string>
 #include <cstdlib>
+#include <cstdio>
 #include <iomanip>
+#include <filesystem>
+#include <map>
+#include <algorithm>
+#include <regex>
+#include <sstream>
 #include "constants.h"
 #include "storage.h"
 #include "index.h"
 #include "object.h"
+#include "tree_builder.h"
+#include "checkout.h"
+#include "commit_graph.h"
+#include "history.h"
+#include "refs.h"
+#include "repo_generator.h"
+#include "fsck.h"
+#include "rename_detector.h"
+#include "grep.h"
+#include "merge.h"
 
 namespace vcs {
 
@@ -17,6 +33,9 @@ private:
     Storage storage;
     Index index;
     std::ofstream csv_file;
+    const std::string bench_root = "bench_repo";   // Каталог синтетического репозитория
+    std::vector<std::string> test_files;          // Пути сгенерированных файлов
+    int failures = 0;                             // Результаты, не совпавшие с ожидаемыми
 
 public:
     PerformanceTester() {
@@ -32,27 +51,57 @@ public:
         csv_file << "file_count,operation,time_microseconds\n";
     }
 
+    int getFailures() const {
+        return failures;
+    }
+
+    // Замеры без проверки результата ничего не доказывают: несовпадение валит прогон
+    void expect(bool condition, const std::string& what) {
+        if (!condition) {
+            std::cerr << "FAIL: " << what << std::endl;
+            failures++;
+        }
+    }
+
+    // Синтетический текстовый файл: строки "file <i> line <n>"
+    static std::string makeLines(int i, int line_count = 20) {
+        std::string content;
+        for (int line = 0; line < line_count; line++) {
+            content += "file " + std::to_string(i) + " line " + std::to_string(line) + "\n";
+        }
+        return content;
+    }
+
+    GeneratorConfig makeConfig(int count, int size_kb) {
+        GeneratorConfig config;
+        config.file_count = count;
+        config.median_file_size = size_kb * 1024;
+        config.min_binary_size = 16 << 10;
+        config.max_binary_size = 4 << 20;
+        return config;
+    }
+
     void generateTestFiles(int count, int size_kb) {
+        // Детерминированный репозиторий: иерархия каталогов, текст и бинарные файлы
+        RepoGenerator generator(makeConfig(count, size_kb));
+        generator.generate(bench_root);
+        test_files.clear();
         for (int i = 0; i < count; i++) {
-            std::string filename = "test_file_" + std::to_string(i) + ".txt";
-            std::ofstream file(filename);
-            std::string content(size_kb * 1024, 'A' + (i % 26));
-            file << content;
+            test_files.push_back(bench_root + "/" + generator.describe(i).path);
         }
     }
 
     void cleanupTestFiles(int count) {
-        for (int i = 0; i < count; i++) {
-            std::string filename = "test_file_" + std::to_string(i) + ".txt";
-            std::remove(filename.c_str());
-        }
+        (void)count;
+        std::filesystem::remove_all(bench_root);
+        test_files.clear();
     }
 
     void testAddPerformance(int file_count) {
         auto start = std::chrono::high_resolution_clock::now();
         
         for (int i = 0; i < file_count; i++) {
-            std::string filename = "test_file_" + std::to_string(i) + ".txt";
+            const std::string& filename = test_files[i];
             std::ifstream file(filename);
             std::string content((std::istreambuf_iterator<char>(file)), 
                                std::istreambuf_iterator<char>());
@@ -76,7 +125,7 @@ public:
     void testCommitPerformance(int file_count) {
         // Сначала добавляем файлы
         for (int i = 0; i < file_count; i++) {
-            std::string filename = "test_file_" + std::to_string(i) + ".txt";
+            const std::string& filename = test_files[i];
             std::ifstream file(filename);
             std::string content((std::istreambuf_iterator<char>(file)), 
                                std::istreambuf_iterator<char>());
@@ -89,23 +138,20 @@ public:
         // Тестируем коммит
         auto start = std::chrono::high_resolution_clock::now();
         
-        // Создаем tree из staged файлов
-        Tree tree;
+        // Создаем дерево из staged файлов
+        TreeBuilder builder(storage);
         auto staged_files = index.getStagedFiles();
         for (const auto& file_path : staged_files) {
-            TreeEntry entry;
-            entry.mode = "100644";
-            entry.type = types::BLOB;
-            entry.hash = "test_hash";
-            entry.name = file_path;
-            tree.addEntry(entry);
+            IndexEntry entry;
+            index.getEntry(file_path, entry);
+            builder.addFile(file_path, entry.blob_hash);
         }
-        tree.hash = tree.calculateHash();
-        storage.storeTree(tree);
+        std::string tree_hash;
+        builder.write(tree_hash);
         
         // Создаем коммит
         Commit commit;
-        commit.tree_hash = tree.hash;
+        commit.tree_hash = tree_hash;
         commit.author = "tester";
         commit.message = "Performance test commit";
         commit.timestamp = "1234567890";
@@ -123,6 +169,708 @@ public:
         index.clear();
     }
 
+    void testCheckoutPerformance(int file_count) {
+        // Подготавливаем дерево из сгенерированных файлов
+        TreeBuilder builder(storage);
+        for (int i = 0; i < file_count; i++) {
+            const std::string& filename = test_files[i];
+            std::ifstream file(filename);
+            std::string content((std::istreambuf_iterator<char>(file)), 
+                               std::istreambuf_iterator<char>());
+            
+            Blob blob(content, filename);
+            storage.storeBlob(blob);
+            builder.addFile(filename, blob.hash);
+        }
+        std::string tree_hash;
+        builder.write(tree_hash);
+
+        // Тестируем checkout в отдельную директорию
+        const std::string target = "checkout_test";
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        Checkout checkout(storage, index);
+        CheckoutStats stats;
+        checkout.run(tree_hash, target, stats);
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        
+        double seconds = duration.count() / 1e6;
+        double files_per_sec = seconds > 0 ? stats.files_written / seconds : 0;
+        double mb_per_sec = seconds > 0 ? stats.bytes_written / (1024.0 * 1024.0) / seconds : 0;
+        
+        // Записываем в CSV
+        csv_file << file_count << ",checkout," << duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Checkout " << file_count << " files: " << duration.count() << " μs ("
+                  << std::fixed << std::setprecision(1) << files_per_sec << " files/s, "
+                  << std::setprecision(2) << mb_per_sec << " MB/s)" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        
+        std::filesystem::remove_all(target);
+        index.clear();
+    }
+
+    void testLookupPerformance(int file_count) {
+        // Собираем хеши существующих объектов
+        std::vector<std::string> hashes;
+        for (int i = 0; i < file_count; i++) {
+            const std::string& filename = test_files[i];
+            std::ifstream file(filename);
+            std::string content((std::istreambuf_iterator<char>(file)), 
+                               std::istreambuf_iterator<char>());
+            
+            Blob blob(content, filename);
+            storage.storeBlob(blob);
+            hashes.push_back(blob.hash);
+        }
+
+        // Хиты: объекты, которые есть в хранилище
+        StorageCounters before = storage.getCounters();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& hash : hashes) {
+            storage.objectExists(hash);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto hit_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        // Промахи: новое содержимое, которого ещё нет в хранилище
+        std::vector<std::string> missing;
+        for (int i = 0; i < file_count; i++) {
+            missing.push_back(Blob("missing content " + std::to_string(i)).hash);
+        }
+        start = std::chrono::high_resolution_clock::now();
+        for (const auto& hash : missing) {
+            storage.objectExists(hash);
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto miss_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        StorageCounters after = storage.getCounters();
+
+        // Записываем в CSV
+        csv_file << file_count << ",lookup_hit," << hit_duration.count() << "\n";
+        csv_file << file_count << ",lookup_miss," << miss_duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Lookup " << file_count << " hits: " << hit_duration.count() << " μs, "
+                  << file_count << " misses: " << miss_duration.count() << " μs" << std::endl;
+        std::cout << "  bloom negatives: " << after.bloom_negatives - before.bloom_negatives
+                  << ", disk probes: " << after.disk_probes - before.disk_probes
+                  << ", false positives: " << after.false_positives - before.false_positives
+                  << std::endl;
+
+        // Первый поиск в новом процессе: со сканированием каталога и с сохранённым индексом
+        std::string probe = Blob("cold lookup probe").hash;
+        std::string objects_path = storage.getObjectsPath();
+        start = std::chrono::high_resolution_clock::now();
+        std::uint64_t cold_scans;
+        {
+            Storage cold(objects_path);
+            cold.objectExists(probe);
+            cold_scans = cold.getCounters().index_scans;
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto cold_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        start = std::chrono::high_resolution_clock::now();
+        std::uint64_t warm_scans;
+        {
+            Storage warm(objects_path);
+            warm.objectExists(probe);
+            warm_scans = warm.getCounters().index_scans;
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto warm_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        expect(cold_scans == 1 && warm_scans == 0, "a new store reuses the saved object index");
+
+        csv_file << file_count << ",lookup_cold_scan," << cold_duration.count() << "\n";
+        csv_file << file_count << ",lookup_cold_saved," << warm_duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "  first lookup with scan: " << cold_duration.count() << " μs, with saved index: "
+                  << warm_duration.count() << " μs" << std::endl;
+    }
+
+    void testHistoryPerformance(int commit_count) {
+        // Строим линейную историю: каждый коммит меняет один файл из 10 директорий
+        const std::string graph_path = "bench_commit_graph";
+        std::remove(graph_path.c_str());
+        CommitGraph graph(graph_path);
+        std::vector<std::string> blob_hashes(50);
+        std::string parent_hash, parent_tree;
+        TreeDiff differ(storage);
+        
+        for (int i = 0; i < commit_count; i++) {
+            Blob blob("history content " + std::to_string(i));
+            storage.storeBlob(blob);
+            blob_hashes[i % blob_hashes.size()] = blob.hash;
+            
+            TreeBuilder builder(storage);
+            for (std::size_t f = 0; f < blob_hashes.size(); f++) {
+                if (blob_hashes[f].empty()) continue;
+                builder.addFile("dir_" + std::to_string(f % 10) + "/file_" + std::to_string(f) + ".txt",
+                                blob_hashes[f]);
+            }
+            
+            Commit commit;
+            builder.write(commit.tree_hash);
+            if (!parent_hash.empty()) commit.parent_hashes.push_back(parent_hash);
+            commit.author = "tester";
+            commit.message = "History commit " + std::to_string(i);
+            commit.timestamp = std::to_string(1234567890 + i);
+            commit.hash = commit.calculateHash();
+            storage.storeCommit(commit);
+            
+            std::vector<FileChange> changes;
+            differ.diff(parent_tree, commit.tree_hash, changes);
+            graph.append(commit.hash, CommitGraph::makeEntry(commit, changes));
+            parent_hash = commit.hash;
+            parent_tree = commit.tree_hash;
+        }
+
+        // Тестируем log -- <path> с фильтрами и без них
+        History history(storage, graph);
+        const std::string path = "dir_3/file_3.txt";
+        long long durations[2];
+        HistoryStats stats[2];
+        for (int pass = 0; pass < 2; pass++) {
+            std::vector<std::string> commits;
+            auto start = std::chrono::high_resolution_clock::now();
+            history.log(parent_hash, path, commits, stats[pass], pass == 0);
+            auto end = std::chrono::high_resolution_clock::now();
+            durations[pass] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        }
+        
+        // Записываем в CSV
+        csv_file << commit_count << ",log_path_filtered," << durations[0] << "\n";
+        csv_file << commit_count << ",log_path_full," << durations[1] << "\n";
+        csv_file.flush();
+        std::cout << "Log -- <path> over " << commit_count << " commits: "
+                  << durations[0] << " μs with filters (" << stats[0].trees_diffed << " diffs), "
+                  << durations[1] << " μs without (" << stats[1].trees_diffed << " diffs)" << std::endl;
+        
+        std::remove(graph_path.c_str());
+    }
+
+    void testTreeFormatPerformance(int file_count) {
+        // Один большой каталог: в 100 раз больше записей, чем файлов в наборе
+        int entry_count = file_count * 100;
+        Tree tree;
+        std::size_t text_size = 0;
+        for (int i = 0; i < entry_count; i++) {
+            TreeEntry entry;
+            entry.mode = "100644";
+            entry.type = types::BLOB;
+            entry.hash = Blob("tree entry " + std::to_string(i)).hash;
+            entry.name = "source_file_" + std::to_string(i) + ".cpp";
+            tree.addEntry(entry);
+            // Размер прежнего текстового формата "<mode> <type> <hex> <name>\n"
+            text_size += entry.mode.size() + entry.type.size() + entry.hash.size() + entry.name.size() + 4;
+        }
+        std::string data = tree.serialize();
+
+        // Ленивый разбор через string_view без аллокаций
+        auto start = std::chrono::high_resolution_clock::now();
+        TreeParser parser(data);
+        TreeEntryView view;
+        std::size_t parsed = 0;
+        while (parser.next(view)) parsed++;
+        auto end = std::chrono::high_resolution_clock::now();
+        auto view_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        // Полный разбор в Tree
+        start = std::chrono::high_resolution_clock::now();
+        Tree parsed_tree;
+        Tree::parse(data, parsed_tree);
+        end = std::chrono::high_resolution_clock::now();
+        auto full_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        // Записываем в CSV
+        csv_file << entry_count << ",tree_parse_view," << view_duration.count() << "\n";
+        csv_file << entry_count << ",tree_parse_full," << full_duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Tree with " << parsed << " entries: " << data.size() << " bytes (text format "
+                  << text_size << " bytes), parse " << view_duration.count() << " μs lazy, "
+                  << full_duration.count() << " μs full" << std::endl;
+    }
+
+    void testIncrementalCommitPerformance(int file_count) {
+        // Снимок и 10 коммитов с инкрементальными правками
+        GeneratorConfig config = makeConfig(file_count, 1);
+        config.commit_count = 10;
+        config.edit_fraction = 0.02;
+        RepoGenerator generator(config);
+        
+        const std::string root = bench_root + "_history";
+        std::map<std::string, std::string> tracked;
+        long long total_us = 0;
+        std::size_t total_changed = 0;
+        
+        generator.generateHistory(root, [&](std::size_t round, const std::vector<std::string>& changed) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const auto& path : changed) {
+                std::ifstream file(root + "/" + path, std::ios::binary);
+                std::string content((std::istreambuf_iterator<char>(file)), 
+                                   std::istreambuf_iterator<char>());
+                Blob blob(content, path);
+                storage.storeBlob(blob);
+                tracked[path] = blob.hash;
+            }
+            TreeBuilder builder(storage);
+            for (const auto& pair : tracked) {
+                builder.addFile(pair.first, pair.second);
+            }
+            std::string tree_hash;
+            builder.write(tree_hash);
+            auto end = std::chrono::high_resolution_clock::now();
+            if (round > 0) {
+                total_us += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+                total_changed += changed.size();
+            }
+            return true;
+        });
+        
+        long long per_commit = total_us / static_cast<long long>(config.commit_count);
+        
+        // Записываем в CSV
+        csv_file << file_count << ",incremental_commit," << per_commit << "\n";
+        csv_file.flush();
+        std::cout << "Incremental commit over " << file_count << " files: " << per_commit
+                  << " μs per commit (" << total_changed / config.commit_count << " files changed)" << std::endl;
+        
+        std::filesystem::remove_all(root);
+    }
+
+    void testBatchPerformance(int file_count) {
+        const std::string binary = MYVCS_BINARY;
+        
+        // Отдельный процесс myvcs на каждую команду
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < file_count; i++) {
+            std::string command = binary + " hash-object '" + test_files[i] + "' > /dev/null";
+            std::system(command.c_str());
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto process_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        
+        // Один процесс myvcs batch для всех команд
+        start = std::chrono::high_resolution_clock::now();
+        FILE* batch = popen((binary + " batch > /dev/null").c_str(), "w");
+        for (int i = 0; i < file_count; i++) {
+            std::string request = "hash-object " + test_files[i] + "\n";
+            std::fwrite(request.data(), 1, request.size(), batch);
+        }
+        pclose(batch);
+        end = std::chrono::high_resolution_clock::now();
+        auto batch_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        
+        // Записываем в CSV
+        csv_file << file_count << ",per_process," << process_duration.count() << "\n";
+        csv_file << file_count << ",batch," << batch_duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Hash-object " << file_count << " files: " << process_duration.count()
+                  << " μs per-process, " << batch_duration.count() << " μs batch" << std::endl;
+    }
+
+    void testRenamePerformance(int file_count) {
+        // Массовое перемещение: каталог src/ переезжает в moved/, половина файлов правится
+        int moved_count = file_count * 10;
+        TreeBuilder old_builder(storage), new_builder(storage);
+        bool stored = true;
+        for (int i = 0; i < moved_count; i++) {
+            std::string content = makeLines(i);
+            Blob before(content);
+            stored = storage.storeBlob(before) && stored;
+            if (i % 2 == 1) content += "edited line\n";
+            Blob after(content);
+            stored = storage.storeBlob(after) && stored;
+            
+            std::string name = "dir_" + std::to_string(i % 10) + "/file_" + std::to_string(i) + ".txt";
+            old_builder.addFile("src/" + name, before.hash);
+            new_builder.addFile("moved/" + name, after.hash);
+        }
+        std::string old_tree, new_tree;
+        stored = old_builder.write(old_tree) && new_builder.write(new_tree) && stored;
+        expect(stored, "rename fixture stored");
+        
+        // Поиск переименований: точные хеши, затем MinHash-кандидаты
+        auto start = std::chrono::high_resolution_clock::now();
+        TreeDiff differ(storage);
+        std::vector<FileChange> changes;
+        bool detected = differ.diff(old_tree, new_tree, changes);
+        RenameDetector detector(storage);
+        RenameStats stats;
+        detected = detected && detector.detect(changes, stats);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto detect_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        
+        // Каждый файл должен найти свою пару: src/<name> -> moved/<name>
+        std::size_t paired = 0;
+        for (const auto& change : changes) {
+            if (change.kind == FileChange::Kind::Renamed &&
+                change.old_path.compare(0, 4, "src/") == 0 && change.path.compare(0, 6, "moved/") == 0 &&
+                change.old_path.substr(4) == change.path.substr(6)) {
+                paired++;
+            }
+        }
+        expect(detected, "rename detection ran");
+        expect(paired == static_cast<std::size_t>(moved_count) && changes.size() == paired,
+               "every moved file paired with its source (" + std::to_string(paired) + " of " +
+               std::to_string(moved_count) + ")");
+        expect(stats.exact == static_cast<std::size_t>(moved_count + 1) / 2 &&
+               stats.inexact == static_cast<std::size_t>(moved_count) / 2,
+               "rename split into exact and similar pairs");
+        
+        // Записываем в CSV
+        csv_file << moved_count << ",rename_detect," << detect_duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Rename " << moved_count << " files: " << detect_duration.count() << " μs ("
+                  << stats.exact << " exact, " << stats.inexact << " similar, "
+                  << stats.pairs_scored << " pairs scored)" << std::endl;
+        
+        // Для сравнения: попарное сравнение всех удаленных и добавленных файлов (O(n²), только малые наборы)
+        if (moved_count > 1000) return;
+        start = std::chrono::high_resolution_clock::now();
+        std::vector<FileChange> plain;
+        differ.diff(old_tree, new_tree, plain);
+        std::vector<ContentSketch> deleted, added;
+        for (const auto& change : plain) {
+            Blob blob("");
+            bool is_added = change.kind == FileChange::Kind::Added;
+            storage.readBlob(is_added ? change.new_hash : change.old_hash, blob);
+            (is_added ? added : deleted).push_back(ContentSketch::build(blob.content));
+        }
+        std::size_t pairs_found = 0;
+        for (const auto& a : added) {
+            double best = 0;
+            for (const auto& d : deleted) best = std::max(best, a.similarity(d));
+            if (best >= 0.5) pairs_found++;
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto pairwise_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        
+        csv_file << moved_count << ",rename_pairwise," << pairwise_duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "  pairwise: " << pairwise_duration.count() << " μs ("
+                  << pairs_found << " found)" << std::endl;
+        expect(pairs_found == added.size(), "pairwise baseline finds a match for every added file");
+    }
+
+    void testRenameBoilerplate(int file_count) {
+        // Общий заголовок лицензии: корзины MinHash с ним огромны, но настоящие пары должны находиться
+        int moved_count = file_count * 10;
+        std::string license;
+        for (int line = 0; line < 30; line++) {
+            license += "// Licensed under the shared boilerplate terms, clause " + std::to_string(line) + "\n";
+        }
+        TreeBuilder old_builder(storage), new_builder(storage);
+        bool stored = true;
+        for (int i = 0; i < moved_count; i++) {
+            std::string content = license + makeLines(i);
+            Blob before(content);
+            Blob after(content + "edited line\n");
+            stored = storage.storeBlob(before) && storage.storeBlob(after) && stored;
+            std::string name = "file_" + std::to_string(i) + ".cpp";
+            old_builder.addFile("lib/" + name, before.hash);
+            new_builder.addFile("src/" + name, after.hash);
+        }
+        std::string old_tree, new_tree;
+        stored = old_builder.write(old_tree) && new_builder.write(new_tree) && stored;
+        expect(stored, "boilerplate fixture stored");
+
+        auto start = std::chrono::high_resolution_clock::now();
+        TreeDiff differ(storage);
+        std::vector<FileChange> changes;
+        bool detected = differ.diff(old_tree, new_tree, changes);
+        RenameDetector detector(storage);
+        RenameStats stats;
+        detected = detected && detector.detect(changes, stats);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        std::size_t paired = 0;
+        for (const auto& change : changes) {
+            if (change.kind == FileChange::Kind::Renamed && change.old_path.substr(4) == change.path.substr(4)) {
+                paired++;
+            }
+        }
+        expect(detected && paired == static_cast<std::size_t>(moved_count),
+               "boilerplate does not crowd out true renames (" + std::to_string(paired) + " of " +
+               std::to_string(moved_count) + ")");
+
+        csv_file << moved_count << ",rename_boilerplate," << duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Rename " << moved_count << " files with shared boilerplate: " << duration.count()
+                  << " μs (" << stats.pairs_scored << " pairs scored)" << std::endl;
+    }
+
+    void testSplitIndexPerformance(int file_count) {
+        // Большой индекс: в 200 раз больше записей, чем файлов в наборе
+        int entry_count = file_count * 200;
+        const int update_count = 20;
+        std::vector<IndexEntry> batch;
+        batch.reserve(entry_count);
+        for (int i = 0; i < entry_count; i++) {
+            batch.emplace_back("dir_" + std::to_string(i % 100) + "/file_" + std::to_string(i) + ".txt",
+                               calculateSimpleHash("entry " + std::to_string(i)));
+        }
+        
+        // Добавление по одному файлу: полная перезапись индекса против журнала изменений
+        long long durations[2];
+        for (int split = 0; split < 2; split++) {
+            Index large;
+            large.setSplit(split == 1);
+            large.addFiles(batch);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < update_count; i++) {
+                large.addFile(batch[i * 7 % entry_count].file_path, calculateSimpleHash("update " + std::to_string(i)));
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            durations[split] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            
+            // Новый Index читает диск: база плюс журнал должны дать все записи с обновлениями
+            std::string mode = split ? "split" : "full";
+            Index reloaded;
+            IndexEntry entry;
+            expect(reloaded.getStagedFiles().size() == static_cast<std::size_t>(entry_count),
+                   mode + " index keeps every entry after updates");
+            expect(reloaded.getEntry(batch[(update_count - 1) * 7 % entry_count].file_path, entry) &&
+                   entry.blob_hash == calculateSimpleHash("update " + std::to_string(update_count - 1)),
+                   mode + " index replays the last update");
+            if (split == 1) {
+                expect(reloaded.isSplit() && reloaded.deltaSize() == static_cast<std::size_t>(update_count),
+                       "split index appends updates to the change log");
+                
+                // Пакет больше порога сворачивает журнал в базу
+                large.addFiles(batch);
+                Index folded;
+                expect(folded.deltaSize() == 0 && folded.baseSize() == static_cast<std::size_t>(entry_count) &&
+                       folded.getEntry(batch[0].file_path, entry) && entry.blob_hash == batch[0].blob_hash,
+                       "split index folds the change log into the base");
+            }
+            large.clear();
+            large.setSplit(false);
+        }
+        
+        // Записываем в CSV
+        csv_file << entry_count << ",index_update_full," << durations[0] << "\n";
+        csv_file << entry_count << ",index_update_split," << durations[1] << "\n";
+        csv_file.flush();
+        std::cout << "Index " << update_count << " updates over " << entry_count << " entries: "
+                  << durations[0] << " μs full rewrite, " << durations[1] << " μs split" << std::endl;
+    }
+
+    void testGrepPerformance(int file_count) {
+        // Дерево из сгенерированных файлов; ожидаемое число совпадений считаем построчно
+        const std::regex pattern("TODO.*hash");
+        std::size_t expected = 0;
+        TreeBuilder builder(storage);
+        for (int i = 0; i < file_count; i++) {
+            const std::string& filename = test_files[i];
+            std::ifstream file(filename, std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(file)), 
+                               std::istreambuf_iterator<char>());
+            Blob blob(content, filename);
+            storage.storeBlob(blob);
+            builder.addFile(filename, blob.hash);
+            
+            bool binary = content.find('\0') < 8000;
+            std::size_t lines = 0;
+            std::istringstream in(content);
+            std::string line;
+            while (std::getline(in, line)) {
+                if (std::regex_search(line, pattern)) lines++;
+            }
+            expected += binary ? std::min<std::size_t>(lines, 1) : lines;
+        }
+        std::string tree_hash;
+        builder.write(tree_hash);
+        
+        // Первый поиск читает все блобы, повторный отвечает из кэша поддеревьев
+        TreeGrep grep(storage);
+        grep.setPattern("TODO.*hash", GrepOptions());
+        std::vector<GrepMatch> matches;
+        GrepStats cold_stats, warm_stats;
+        auto start = std::chrono::high_resolution_clock::now();
+        bool cold_ok = grep.search(tree_hash, matches, cold_stats);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto cold_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        std::size_t cold_matches = matches.size();
+        
+        start = std::chrono::high_resolution_clock::now();
+        bool warm_ok = grep.search(tree_hash, matches, warm_stats);
+        end = std::chrono::high_resolution_clock::now();
+        auto warm_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        
+        expect(cold_ok && cold_matches == expected,
+               "grep finds " + std::to_string(expected) + " matches, got " + std::to_string(cold_matches));
+        expect(warm_ok && matches.size() == expected, "cached grep returns the same matches");
+        
+        double mb = cold_stats.bytes_searched / (1024.0 * 1024.0);
+        double seconds = cold_duration.count() / 1e6;
+        
+        // Записываем в CSV
+        csv_file << file_count << ",grep_cold," << cold_duration.count() << "\n";
+        csv_file << file_count << ",grep_warm," << warm_duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Grep " << file_count << " files: " << cold_duration.count() << " μs cold ("
+                  << std::fixed << std::setprecision(2) << (seconds > 0 ? mb / seconds : 0) << " MB/s, "
+                  << cold_stats.blobs_prefiltered << " prefiltered, " << cold_stats.binary_files
+                  << " binary), " << warm_duration.count() << " μs cached, "
+                  << matches.size() << " matches" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    void testMergePerformance(int file_count) {
+        // Две ветки от общей базы: ours правит dir_1, theirs правит dir_2,
+        // часть файлов dir_3 правится обеими сторонами в разных строках
+        // Ожидаемое дерево содержит правки обеих сторон
+        int merged_count = file_count * 20;
+        std::size_t both_count = 0;
+        TreeBuilder base_builder(storage), ours_builder(storage), theirs_builder(storage), expected_builder(storage);
+        for (int i = 0; i < merged_count; i++) {
+            std::string content = makeLines(i);
+            int dir = i % 50;
+            bool both = dir == 3 && i % 7 == 0;
+            if (both) both_count++;
+            std::string ours_edit = (dir == 1 || both) ? "ours edit\n" : "";
+            std::string theirs_edit = (dir == 2 || both) ? "theirs edit\n" : "";
+            Blob base_blob(content), ours_blob(ours_edit + content), theirs_blob(content + theirs_edit);
+            Blob expected_blob(ours_edit + content + theirs_edit);
+            storage.storeBlob(base_blob);
+            storage.storeBlob(ours_blob);
+            storage.storeBlob(theirs_blob);
+            
+            std::string name = "dir_" + std::to_string(dir) + "/sub_" + std::to_string(i % 7) +
+                               "/file_" + std::to_string(i) + ".txt";
+            base_builder.addFile(name, base_blob.hash);
+            ours_builder.addFile(name, ours_blob.hash);
+            theirs_builder.addFile(name, theirs_blob.hash);
+            expected_builder.addFile(name, expected_blob.hash);
+        }
+        
+        Commit base, ours, theirs;
+        std::string expected_tree;
+        base_builder.write(base.tree_hash);
+        ours_builder.write(ours.tree_hash);
+        theirs_builder.write(theirs.tree_hash);
+        expected_builder.write(expected_tree);
+        base.author = "tester";
+        base.message = "merge base";
+        base.timestamp = "1000";
+        base.hash = base.calculateHash();
+        ours.parent_hashes.push_back(base.hash);
+        ours.author = "tester";
+        ours.message = "ours";
+        ours.timestamp = "1001";
+        ours.hash = ours.calculateHash();
+        theirs.parent_hashes.push_back(base.hash);
+        theirs.author = "tester";
+        theirs.message = "theirs";
+        theirs.timestamp = "1002";
+        theirs.hash = theirs.calculateHash();
+        storage.storeCommit(base);
+        storage.storeCommit(ours);
+        storage.storeCommit(theirs);
+        
+        // Слияние в памяти: неизменённые поддеревья пропускаются по хешу
+        TreeMerger merger(storage);
+        MergeResult result;
+        MergeStats stats;
+        auto start = std::chrono::high_resolution_clock::now();
+        bool merged = merger.merge(ours.hash, theirs.hash, result, stats);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        
+        expect(merged && result.base_hash == base.hash, "merge finds the common base");
+        expect(result.conflicts.empty(), "disjoint edits merge without conflicts, got " +
+               std::to_string(result.conflicts.size()));
+        expect(stats.blobs_merged == both_count, "merge merges " + std::to_string(both_count) +
+               " files line by line, got " + std::to_string(stats.blobs_merged));
+        expect(result.tree_hash == expected_tree, "merged tree has the edits of both sides");
+        
+        // Записываем в CSV
+        csv_file << merged_count << ",merge_tree," << duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Merge " << merged_count << " files: " << duration.count() << " μs ("
+                  << stats.trees_read << " trees read, " << stats.subtrees_skipped << " subtrees skipped, "
+                  << stats.blobs_merged << " files merged, " << result.conflicts.size()
+                  << " conflicts)" << std::endl;
+    }
+
+    void testMergeBasePerformance(int commit_count) {
+        // Длинная линейная история и две короткие ветки от её вершины:
+        // с номерами поколений поиск базы не спускается ниже развилки
+        const std::string graph_path = "bench_merge_graph";
+        std::remove(graph_path.c_str());
+        CommitGraph graph(graph_path);
+        Tree empty;
+        empty.hash = empty.calculateHash();
+        storage.storeTree(empty);
+        int clock = 0;
+        auto makeCommit = [&](const std::string& message, const std::vector<std::string>& parents) {
+            Commit commit;
+            commit.tree_hash = empty.hash;
+            commit.parent_hashes = parents;
+            commit.author = "tester";
+            commit.message = message;
+            commit.timestamp = std::to_string(1234567890 + clock++);
+            commit.hash = commit.calculateHash();
+            storage.storeCommit(commit);
+            graph.append(commit.hash, CommitGraph::makeEntry(commit, {}));
+            return commit.hash;
+        };
+        std::string fork;
+        for (int i = 0; i < commit_count; i++) {
+            fork = makeCommit("base history " + std::to_string(i), fork.empty() ? std::vector<std::string>()
+                                                                                 : std::vector<std::string>{fork});
+        }
+        std::string ours = makeCommit("ours 1", {fork});
+        ours = makeCommit("ours 2", {ours});
+        std::string theirs = makeCommit("theirs 1", {fork});
+
+        std::string base;
+        TreeMerger merger(storage, &graph);
+        auto start = std::chrono::high_resolution_clock::now();
+        bool found = merger.findMergeBase(ours, theirs, base);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto graph_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        std::size_t graph_walked = merger.commitsWalked();
+        expect(found && base == fork, "merge base of two branches is the fork point");
+        expect(graph_walked <= 8, "merge base walk stops at the fork, walked " + std::to_string(graph_walked));
+
+        // Для сравнения: без графа поколения неизвестны и порядок обхода произволен
+        TreeMerger plain(storage);
+        start = std::chrono::high_resolution_clock::now();
+        found = plain.findMergeBase(ours, theirs, base);
+        end = std::chrono::high_resolution_clock::now();
+        auto plain_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        expect(found && base == fork, "merge base without the commit graph");
+
+        csv_file << commit_count << ",merge_base_graph," << graph_duration.count() << "\n";
+        csv_file << commit_count << ",merge_base_plain," << plain_duration.count() << "\n";
+        csv_file.flush();
+        std::cout << "Merge base over " << commit_count << " commits: " << graph_duration.count() << " μs with graph ("
+                  << graph_walked << " commits walked), " << plain_duration.count() << " μs without ("
+                  << plain.commitsWalked() << " walked)" << std::endl;
+    }
+
+    void testFsckPerformance() {
+        // Проверка всего хранилища, накопленного предыдущими тестами
+        IntegrityChecker checker(storage);
+        FsckReport report;
+        checker.run(report);
+        
+        double mb = report.bytes / (1024.0 * 1024.0);
+        long long duration = static_cast<long long>(report.seconds * 1e6);
+        
+        // Записываем в CSV
+        csv_file << report.objects << ",fsck," << duration << "\n";
+        csv_file.flush();
+        std::cout << "Fsck " << report.objects << " objects: " << duration << " μs ("
+                  << std::fixed << std::setprecision(2)
+                  << (report.seconds > 0 ? mb / report.seconds : 0) << " MB/s)" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+
     void runPerformanceSuite() {
         std::vector<int> test_sizes = {10, 50, 100, 200, 500};
         
@@ -133,10 +881,23 @@ public:
         
         for (int size : test_sizes) {
             std::cout << "Testing with " << size << " files..." << std::endl;
-            generateTestFiles(size, 1); // Файлы по 1KB
+            generateTestFiles(size, 1); // Медианный размер файла 1KB
             
             testAddPerformance(size);
             testCommitPerformance(size);
+            testCheckoutPerformance(size);
+            testLookupPerformance(size);
+            testHistoryPerformance(size);
+            testTreeFormatPerformance(size);
+            testIncrementalCommitPerformance(size);
+            testBatchPerformance(size);
+            testRenamePerformance(size);
+            testRenameBoilerplate(size);
+            testSplitIndexPerformance(size);
+            testGrepPerformance(size);
+            testMergePerformance(size);
+            testMergeBasePerformance(size * 20);
+            testFsckPerformance();
             
             cleanupTestFiles(size);
             std::cout << "---" << std::endl;
@@ -150,8 +911,71 @@ public:
 
 } // namespace vcs
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Режим генерации: performance_test generate <dir> <files> [seed] [commits]
+    // Снимок и каждый раунд правок записываются коммитами в <dir>/.my_vcs
+    if (argc >= 4 && std::string(argv[1]) == "generate") {
+        vcs::GeneratorConfig config;
+        config.file_count = std::strtoull(argv[3], nullptr, 10);
+        if (argc >= 5) config.seed = std::strtoull(argv[4], nullptr, 10);
+        if (argc >= 6) config.commit_count = std::strtoull(argv[5], nullptr, 10);
+        
+        std::error_code ec;
+        std::filesystem::create_directories(argv[2], ec);
+        std::filesystem::current_path(argv[2], ec);
+        if (ec) {
+            std::cerr << "Error: Cannot enter " << argv[2] << std::endl;
+            return 1;
+        }
+        vcs::Storage storage;
+        storage.initialize();
+        vcs::Refs refs;
+        vcs::CommitGraph commit_graph;
+        vcs::TreeBuilder builder(storage);
+        std::string parent_hash, parent_tree;
+        
+        vcs::RepoGenerator generator(config);
+        bool ok = generator.generateHistory(".", [&](std::size_t round, const std::vector<std::string>& changed) {
+            for (const auto& path : changed) {
+                std::ifstream file(path, std::ios::binary);
+                std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                vcs::Blob blob(content, path);
+                if (!storage.storeBlob(blob)) return false;
+                builder.addFile(path, blob.hash);
+            }
+            
+            // Метка времени равна номеру раунда, чтобы история была детерминированной
+            vcs::Commit commit;
+            if (!builder.write(commit.tree_hash)) return false;
+            commit.author = "generator";
+            commit.message = round == 0 ? "snapshot" : "round " + std::to_string(round);
+            commit.timestamp = std::to_string(round);
+            if (!parent_hash.empty()) commit.parent_hashes.push_back(parent_hash);
+            commit.hash = commit.calculateHash();
+            if (!storage.storeCommit(commit)) return false;
+            
+            vcs::TreeDiff differ(storage);
+            std::vector<vcs::FileChange> changes;
+            if (differ.diff(parent_tree, commit.tree_hash, changes)) {
+                commit_graph.append(commit.hash, vcs::CommitGraph::makeEntry(commit, changes));
+            }
+            if (!refs.updateHead(commit.hash)) return false;
+            parent_hash = commit.hash;
+            parent_tree = commit.tree_hash;
+            std::cout << "round " << round << ": " << changed.size() << " files, commit " << commit.hash << std::endl;
+            return true;
+        });
+        if (!ok) {
+            std::cerr << "Error: Failed to generate history" << std::endl;
+        }
+        return ok ? 0 : 1;
+    }
+    
     vcs::PerformanceTester tester;
     tester.runPerformanceSuite();
+    if (tester.getFailures() > 0) {
+        std::cerr << tester.getFailures() << " checks failed" << std::endl;
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
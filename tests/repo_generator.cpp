@@ -0,0 +1,251 @@
+#include "repo_generator.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace vcs {
+
+/**
+ * @brief Words used to build source-like text content
+ */
+static const char* const WORDS[] = {
+    "int", "return", "const", "std::string", "auto", "for", "if", "else", "while",
+    "value", "index", "result", "storage", "commit", "tree", "blob", "hash", "path",
+    "size_t", "void", "bool", "true", "false", "nullptr", "=", "==", "+", "(", ")",
+    "{", "}", ";", "//", "TODO", "namespace", "vcs", "entry", "data", "count", "i"
+};
+
+/**
+ * @brief Maps one engine output to a double in [0, 1)
+ *
+ * The standard distributions are implementation-defined, so the generator
+ * uses its own transforms to give identical repositories on every platform.
+ *
+ * @param rng The random engine
+ * @return double Uniform value in [0, 1)
+ */
+static double unitInterval(std::mt19937_64& rng) {
+    return static_cast<double>(rng() >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @brief Draws a standard normal value with the Box-Muller transform
+ * @param rng The random engine
+ * @return double Normally distributed value with mean 0 and deviation 1
+ */
+static double standardNormal(std::mt19937_64& rng) {
+    double u1 = 1.0 - unitInterval(rng);  // (0, 1], keeps log() finite
+    double u2 = unitInterval(rng);
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+/**
+ * @brief Constructs a generator with the given parameters
+ * @param config Generation parameters
+ */
+RepoGenerator::RepoGenerator(const GeneratorConfig& config)
+    : config(config), total_files(config.file_count) {}
+
+/**
+ * @brief Creates the random engine for one file or commit
+ * @param stream Stream number (file number or commit round)
+ * @param salt Distinguishes independent uses of the same stream
+ * @return std::mt19937_64 Engine seeded from the config seed, stream and salt
+ */
+std::mt19937_64 RepoGenerator::engine(std::uint64_t stream, std::uint64_t salt) const {
+    // splitmix64 over the combined inputs gives well-spread seeds for nearby streams
+    std::uint64_t z = config.seed ^ (stream * 0x9e3779b97f4a7c15ULL) ^ (salt * 0xd1b54a32d192ed03ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return std::mt19937_64(z ^ (z >> 31));
+}
+
+/**
+ * @brief Describes a file without generating it
+ * @param index The file number
+ * @return GeneratedFile Path, size and kind of the file
+ */
+GeneratedFile RepoGenerator::describe(std::size_t index) const {
+    std::mt19937_64 rng = engine(index, 1);
+
+    GeneratedFile file;
+    std::string dir;
+    for (unsigned level = 0; level < config.max_depth; level++) {
+        if (unitInterval(rng) >= config.descend_probability) break;
+        dir += "dir_" + std::to_string(rng() % config.dir_fanout) + "/";
+    }
+
+    double kind = unitInterval(rng);
+    if (kind < config.binary_fraction) {
+        file.kind = GeneratedFile::Kind::Binary;
+    } else if (kind < config.binary_fraction + config.random_fraction * (1.0 - config.binary_fraction)) {
+        file.kind = GeneratedFile::Kind::Random;
+    } else {
+        file.kind = GeneratedFile::Kind::Text;
+    }
+
+    double size;
+    if (file.kind == GeneratedFile::Kind::Binary) {
+        // Pareto tail: most binaries are near the minimum, a few are huge
+        size = config.min_binary_size * std::pow(1.0 - unitInterval(rng), -1.0 / 1.16);
+        size = std::min(size, static_cast<double>(config.max_binary_size));
+    } else {
+        // Log-normal around the median with sigma 1
+        double lognormal = config.median_file_size * std::exp(standardNormal(rng));
+        size = std::min(lognormal, static_cast<double>(config.max_text_size));
+    }
+    file.size = std::max<std::size_t>(1, static_cast<std::size_t>(size));
+
+    static const char* const extensions[] = {".txt", ".dat", ".bin"};
+    file.path = dir + "file_" + std::to_string(index) + extensions[static_cast<int>(file.kind)];
+    return file;
+}
+
+/**
+ * @brief Generates the initial content of a file
+ * @param file The file description
+ * @param index The file number
+ * @return std::string File content
+ */
+std::string RepoGenerator::content(const GeneratedFile& file, std::size_t index) const {
+    std::mt19937_64 rng = engine(index, 2);
+    std::string data;
+    data.reserve(file.size + 64);
+
+    if (file.kind == GeneratedFile::Kind::Text) {
+        const std::size_t word_count = sizeof(WORDS) / sizeof(WORDS[0]);
+        while (data.size() < file.size) {
+            std::size_t words = 3 + rng() % 10;
+            data.append(rng() % 4, ' ');
+            for (std::size_t w = 0; w < words; w++) {
+                if (w > 0) data.push_back(' ');
+                data += WORDS[rng() % word_count];
+            }
+            data.push_back('\n');
+        }
+    } else {
+        while (data.size() < file.size) {
+            std::uint64_t bits = rng();
+            data.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+        }
+    }
+    data.resize(file.size);
+    return data;
+}
+
+/**
+ * @brief Writes content to a file below the root, creating directories
+ * @param root Repository root directory
+ * @param path Path relative to the root
+ * @param data Content to write
+ * @return bool True if the file was written, false otherwise
+ */
+bool RepoGenerator::writeFile(const std::string& root, const std::string& path, const std::string& data) {
+    std::filesystem::path full = std::filesystem::path(root) / path;
+    std::error_code ec;
+    std::filesystem::create_directories(full.parent_path(), ec);
+    std::ofstream file(full, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(data.data(), data.size());
+    return file.good();
+}
+
+/**
+ * @brief Gets the number of files generated so far
+ * @return std::size_t Snapshot files plus files added by commits
+ */
+std::size_t RepoGenerator::fileCount() const {
+    return total_files;
+}
+
+/**
+ * @brief Writes the initial snapshot below a root directory
+ * @param root Repository root directory
+ * @return bool True if every file was written, false otherwise
+ */
+bool RepoGenerator::generate(const std::string& root) {
+    for (std::size_t i = 0; i < config.file_count; i++) {
+        GeneratedFile file = describe(i);
+        if (!writeFile(root, file.path, content(file, i))) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Applies one round of incremental edits to files below the root
+ * @param root Repository root directory
+ * @param round Commit round (1-based), determines which files change
+ * @return std::vector<std::string> Paths of modified and added files
+ */
+std::vector<std::string> RepoGenerator::applyEdits(const std::string& root, std::size_t round) {
+    std::mt19937_64 rng = engine(round, 3);
+    std::vector<std::string> changed;
+
+    std::size_t edits = std::max<std::size_t>(1, static_cast<std::size_t>(total_files * config.edit_fraction));
+    std::set<std::size_t> picked;
+    while (picked.size() < std::min(edits, total_files)) {
+        picked.insert(rng() % total_files);
+    }
+
+    for (std::size_t index : picked) {
+        GeneratedFile file = describe(index);
+        std::ifstream in(std::filesystem::path(root) / file.path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        std::string data = ss.str();
+        in.close();
+
+        if (file.kind == GeneratedFile::Kind::Text) {
+            // Insert a line at a line boundary, the way a small source edit would
+            std::size_t offset = data.empty() ? 0 : rng() % data.size();
+            std::size_t line = data.rfind('\n', offset);
+            line = line == std::string::npos ? 0 : line + 1;
+            data.insert(line, "edit " + std::to_string(round) + " value = " + std::to_string(rng() % 1000) + ";\n");
+        } else {
+            // Overwrite one block of a binary file
+            std::size_t block = std::min<std::size_t>(4096, data.size());
+            std::size_t offset = data.size() > block ? rng() % (data.size() - block) : 0;
+            for (std::size_t i = 0; i < block; i++) {
+                data[offset + i] = static_cast<char>(rng());
+            }
+        }
+        if (writeFile(root, file.path, data)) changed.push_back(file.path);
+    }
+
+    std::size_t additions = static_cast<std::size_t>(total_files * config.add_fraction);
+    for (std::size_t i = 0; i < additions; i++) {
+        std::size_t index = total_files++;
+        GeneratedFile file = describe(index);
+        if (writeFile(root, file.path, content(file, index))) changed.push_back(file.path);
+    }
+    return changed;
+}
+
+/**
+ * @brief Writes the snapshot and then commit_count rounds of edits
+ * @param root Repository root directory
+ * @param on_commit Called with the round number (0 for the snapshot) and changed paths;
+ *                  returns false to stop
+ * @return bool True if every file was written and every callback succeeded, false otherwise
+ */
+bool RepoGenerator::generateHistory(const std::string& root,
+                                    const std::function<bool(std::size_t, const std::vector<std::string>&)>& on_commit) {
+    if (!generate(root)) return false;
+
+    std::vector<std::string> snapshot;
+    snapshot.reserve(config.file_count);
+    for (std::size_t i = 0; i < config.file_count; i++) {
+        snapshot.push_back(describe(i).path);
+    }
+    if (!on_commit(0, snapshot)) return false;
+
+    for (std::size_t round = 1; round <= config.commit_count; round++) {
+        if (!on_commit(round, applyEdits(root, round))) return false;
+    }
+    return true;
+}
+
+} // namespace vcs
@@ -0,0 +1,135 @@
+#ifndef REPO_GENERATOR_H
+#define REPO_GENERATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace vcs {
+
+/**
+ * @brief Parameters of a synthetic repository
+ */
+struct GeneratorConfig {
+    std::uint64_t seed = 42;                ///< Seed; equal seeds give identical repositories
+    std::size_t file_count = 1000;          ///< Number of files in the initial snapshot
+    unsigned max_depth = 8;                 ///< Maximum directory depth
+    unsigned dir_fanout = 6;                ///< Subdirectories per directory
+    double descend_probability = 0.7;       ///< Chance of going one directory deeper per level
+    std::size_t median_file_size = 4096;    ///< Median size of text files in bytes
+    std::size_t max_text_size = 1 << 20;    ///< Upper bound for text files in bytes
+    double binary_fraction = 0.02;          ///< Share of large binary files (long tail)
+    std::size_t min_binary_size = 64 << 10; ///< Smallest binary file in bytes
+    std::size_t max_binary_size = 16 << 20; ///< Largest binary file in bytes
+    double random_fraction = 0.1;           ///< Share of text-sized files with incompressible content
+    std::size_t commit_count = 0;           ///< Number of incremental commits after the snapshot
+    double edit_fraction = 0.01;            ///< Share of files modified per commit
+    double add_fraction = 0.002;            ///< Share of new files added per commit
+};
+
+/**
+ * @brief Description of one generated file
+ */
+struct GeneratedFile {
+    /**
+     * @brief Kind of content in the file
+     */
+    enum class Kind {
+        Text,       ///< Line-oriented, compressible source-like text
+        Random,     ///< Small incompressible file
+        Binary      ///< Large incompressible file from the long tail
+    };
+
+    std::string path;       ///< Slash-separated path relative to the repository root
+    std::size_t size;       ///< Size of the initial content in bytes
+    Kind kind;              ///< Kind of content
+};
+
+/**
+ * @brief Deterministic generator of realistic synthetic repositories
+ *
+ * Path, size and content of every file are derived from the seed and the
+ * file number alone, so files are streamed to disk one at a time and the
+ * generator scales to millions of files without keeping them in memory.
+ */
+class RepoGenerator {
+private:
+    GeneratorConfig config;     ///< Generation parameters
+    std::size_t total_files;    ///< Files generated so far, including added ones
+
+    /**
+     * @brief Creates the random engine for one file or commit
+     * @param stream Stream number (file number or commit round)
+     * @param salt Distinguishes independent uses of the same stream
+     * @return std::mt19937_64 Engine seeded from the config seed, stream and salt
+     */
+    std::mt19937_64 engine(std::uint64_t stream, std::uint64_t salt) const;
+
+    /**
+     * @brief Generates the initial content of a file
+     * @param file The file description
+     * @param index The file number
+     * @return std::string File content
+     */
+    std::string content(const GeneratedFile& file, std::size_t index) const;
+
+    /**
+     * @brief Writes content to a file below the root, creating directories
+     * @param root Repository root directory
+     * @param path Path relative to the root
+     * @param data Content to write
+     * @return bool True if the file was written, false otherwise
+     */
+    static bool writeFile(const std::string& root, const std::string& path, const std::string& data);
+
+public:
+    /**
+     * @brief Constructs a generator with the given parameters
+     * @param config Generation parameters
+     */
+    explicit RepoGenerator(const GeneratorConfig& config);
+
+    /**
+     * @brief Describes a file without generating it
+     * @param index The file number
+     * @return GeneratedFile Path, size and kind of the file
+     */
+    GeneratedFile describe(std::size_t index) const;
+
+    /**
+     * @brief Gets the number of files generated so far
+     * @return std::size_t Snapshot files plus files added by commits
+     */
+    std::size_t fileCount() const;
+
+    /**
+     * @brief Writes the initial snapshot below a root directory
+     * @param root Repository root directory
+     * @return bool True if every file was written, false otherwise
+     */
+    bool generate(const std::string& root);
+
+    /**
+     * @brief Applies one round of incremental edits to files below the root
+     * @param root Repository root directory
+     * @param round Commit round (1-based), determines which files change
+     * @return std::vector<std::string> Paths of modified and added files
+     */
+    std::vector<std::string> applyEdits(const std::string& root, std::size_t round);
+
+    /**
+     * @brief Writes the snapshot and then commit_count rounds of edits
+     * @param root Repository root directory
+     * @param on_commit Called with the round number (0 for the snapshot) and changed paths;
+     *                  returns false to stop
+     * @return bool True if every file was written and every callback succeeded, false otherwise
+     */
+    bool generateHistory(const std::string& root,
+                         const std::function<bool(std::size_t, const std::vector<std::string>&)>& on_commit);
+};
+
+} // namespace vcs
+
+#endif